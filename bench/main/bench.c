@@ -0,0 +1,373 @@
+/**
+ * @file bench.c
+ * @brief Benchmarks del driver ST77xx en el dispositivo
+ *
+ * Mide flush completo, flush por franjas, primitivas de dibujo, kernels de
+ * píxel, decodificación JPEG de los frames de spiffs_image a cada escala y
+ * lectura de SPIFFS. Cada resultado es una línea CSV por stdout:
+ *
+ *     BENCH,<chip>,<panel>,<test>,<param>,<valor>,<unidad>
+ *
+ * precedida de una cabecera con los mismos campos y terminada en
+ * "BENCH_DONE". Para extraerla del monitor: grep '^BENCH'.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "jpeg_decoder.h"
+#include "st77xx.h"
+#include "st77xx_kernels.h"
+
+static const char* TAG = "BENCH";
+
+/** @brief Frames por medida de flush */
+#define BENCH_FLUSH_FRAMES   30
+
+/** @brief Pasadas por medida de dibujo y kernels */
+#define BENCH_ROUNDS         50
+
+/** @brief Máximo de JPG medidos de SPIFFS */
+#define BENCH_MAX_FILES      32
+
+/** @brief Tamaño de bloque para la lectura secuencial de SPIFFS */
+#define BENCH_READ_CHUNK     4096
+
+static char jpg_paths[BENCH_MAX_FILES][64];
+static int jpg_count = 0;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Salida
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void report(const char* test, const char* param, double value, const char* unit)
+{
+    printf("BENCH,%s,%s,%s,%s,%.3f,%s\n", ST77XX_CHIP_NAME, ST77XX_CONTROLLER_NAME,
+           test, param, value, unit);
+}
+
+static void report_skip(const char* test, const char* param, const char* reason)
+{
+    printf("BENCH,%s,%s,%s,%s,nan,%s\n", ST77XX_CHIP_NAME, ST77XX_CONTROLLER_NAME,
+           test, param, reason);
+}
+
+static inline double rate(double amount, int64_t us)
+{
+    return us > 0 ? amount * 1e6 / (double)us : 0.0;
+}
+
+/**
+ * @brief Espera a que el bus quede libre
+ *
+ * Un flush vuelve con el último chunk aún en vuelo; escribir un píxel pasa
+ * por CASET, que solo se envía con el bus vacío, y obliga al siguiente
+ * flush a restablecer la ventana completa.
+ */
+static void bus_barrier(void)
+{
+    st77xx_fill_rect_direct(0, 0, 1, 1, 0x0000);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Flush
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void bench_flush(const char* param, uint32_t caps, bool raw)
+{
+    uint16_t* fb = heap_caps_malloc(ST77XX_FB_SIZE, caps);
+    if (!fb) {
+        report_skip("flush_full", param, "no_mem");
+        return;
+    }
+    for (size_t i = 0; i < ST77XX_FB_SIZE / sizeof(uint16_t); i++) fb[i] = (uint16_t)i;
+
+    bus_barrier();
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_FLUSH_FRAMES; i++) {
+        if (raw) {
+            st77xx_flush_raw(fb);
+        } else {
+            st77xx_flush(fb);
+        }
+    }
+    bus_barrier();
+    int64_t dt = esp_timer_get_time() - t0;
+
+    report("flush_full", param, rate(BENCH_FLUSH_FRAMES, dt), "fps");
+    report("flush_full_bw", param, rate((double)BENCH_FLUSH_FRAMES * ST77XX_FB_SIZE / 1e6, dt), "MB/s");
+    heap_caps_free(fb);
+}
+
+static void fill_stripe(uint16_t* stripe, int index, int32_t y0, int32_t rows, void* ctx)
+{
+    (void)y0;
+    (void)ctx;
+    st77xx_kernel_fill(stripe, (uint16_t)(index * 0x0841), (size_t)ST77XX_WIDTH * rows);
+}
+
+static void bench_stripe(void)
+{
+    st77xx_init_stripe_mode();
+    if (st77xx_stripe_get_count() <= 0) {
+        report_skip("flush_stripe", "fill", "no_mem");
+        return;
+    }
+
+    char param[32];
+    snprintf(param, sizeof(param), "rows=%ld", (long)st77xx_stripe_get_height());
+
+    st77xx_stripe_begin_frame();
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_FLUSH_FRAMES; i++) {
+        st77xx_stripe_render(fill_stripe, NULL);
+    }
+    st77xx_stripe_begin_frame();  // Espera a las franjas en vuelo
+    int64_t dt = esp_timer_get_time() - t0;
+
+    report("flush_stripe", param, rate(BENCH_FLUSH_FRAMES, dt), "fps");
+    st77xx_cleanup_stripe_mode();
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Dibujo y kernels
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void bench_draw(void)
+{
+    uint16_t* fb = heap_caps_malloc(ST77XX_FB_SIZE, MALLOC_CAP_8BIT);
+    if (!fb) {
+        report_skip("draw", "fb", "no_mem");
+        return;
+    }
+    const double screen_px = (double)ST77XX_WIDTH * ST77XX_HEIGHT;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ROUNDS; i++) st77xx_fill_screen(fb, (uint16_t)i);
+    report("fill_screen", "full", rate(BENCH_ROUNDS * screen_px / 1e6, esp_timer_get_time() - t0), "Mpx/s");
+
+    // Rectángulos de 64x48 repartidos por la pantalla
+    const int rects = BENCH_ROUNDS * 20;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < rects; i++) {
+        int32_t x = (i * 37) % (ST77XX_WIDTH - 64);
+        int32_t y = (i * 23) % (ST77XX_HEIGHT - 48);
+        st77xx_fill_rect(fb, x, y, 64, 48, (uint16_t)(i * 0x1111));
+    }
+    int64_t dt = esp_timer_get_time() - t0;
+    report("fill_rect", "64x48", rate(rects, dt), "rect/s");
+    report("fill_rect_px", "64x48", rate((double)rects * 64 * 48 / 1e6, dt), "Mpx/s");
+
+    static uint8_t font[ST77XX_FONT_CHARS * ST77XX_FONT_HEIGHT];
+    st77xx_load_font(font);
+    static const char line[] = "The quick brown fox 0123456789";
+    const int chars = (int)sizeof(line) - 1;
+    for (uint8_t scale = 1; scale <= 2; scale++) {
+        char param[16];
+        snprintf(param, sizeof(param), "scale=%u", scale);
+        int32_t line_h = ST77XX_FONT_HEIGHT * scale;
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < BENCH_ROUNDS * 4; i++) {
+            int32_t y = (i * line_h) % (ST77XX_HEIGHT - line_h);
+            st77xx_draw_text(fb, line, 0, y, 0xFFFF, scale, font);
+        }
+        report("draw_text", param, rate((double)BENCH_ROUNDS * 4 * chars, esp_timer_get_time() - t0), "char/s");
+    }
+    heap_caps_free(fb);
+}
+
+/**
+ * @brief MB/s de fill, copy y swap con origen en @p src_caps
+ */
+static void bench_kernels(const char* param, uint32_t src_caps)
+{
+    const size_t pixels = ST77XX_DMA_BUFFER_SIZE / sizeof(uint16_t);
+    const size_t bytes = pixels * sizeof(uint16_t);
+    uint16_t* src = heap_caps_aligned_alloc(16, bytes, src_caps);
+    uint16_t* dst = heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!src || !dst) {
+        report_skip("kernel_swap", param, "no_mem");
+        heap_caps_free(src);
+        heap_caps_free(dst);
+        return;
+    }
+    for (size_t i = 0; i < pixels; i++) src[i] = (uint16_t)(i * 2654435761u);
+    const double mb = (double)bytes * BENCH_ROUNDS / 1e6;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ROUNDS; i++) st77xx_kernel_fill(dst, (uint16_t)i, pixels);
+    report("kernel_fill", param, rate(mb, esp_timer_get_time() - t0), "MB/s");
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ROUNDS; i++) st77xx_kernel_copy(dst, src, pixels);
+    report("kernel_copy", param, rate(mb, esp_timer_get_time() - t0), "MB/s");
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ROUNDS; i++) st77xx_kernel_swap(dst, src, pixels);
+    report("kernel_swap", param, rate(mb, esp_timer_get_time() - t0), "MB/s");
+
+    heap_caps_free(src);
+    heap_caps_free(dst);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * SPIFFS y JPEG
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void collect_jpgs(void)
+{
+    DIR* dir = opendir("/spiffs");
+    if (!dir) return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && jpg_count < BENCH_MAX_FILES) {
+        const char* dot = strrchr(entry->d_name, '.');
+        if (!dot || strcmp(dot, ".jpg") != 0) continue;
+        if (strlen(entry->d_name) > 55) continue;  // No cabe en jpg_paths
+        snprintf(jpg_paths[jpg_count++], sizeof(jpg_paths[0]), "/spiffs/%.55s", entry->d_name);
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Carga un archivo entero en un buffer nuevo
+ */
+static uint8_t* load_file(const char* path, size_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t* buf = heap_caps_malloc(*size, MALLOC_CAP_8BIT);
+    if (buf && fread(buf, 1, *size, f) != *size) {
+        heap_caps_free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+static void bench_spiffs(void)
+{
+    if (jpg_count == 0) {
+        report_skip("spiffs_read", "jpg", "no_files");
+        return;
+    }
+
+    static uint8_t chunk[BENCH_READ_CHUNK];
+    size_t total = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < jpg_count; i++) {
+        FILE* f = fopen(jpg_paths[i], "rb");
+        if (!f) continue;
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) total += got;
+        fclose(f);
+    }
+    int64_t dt = esp_timer_get_time() - t0;
+
+    char param[24];
+    snprintf(param, sizeof(param), "chunk=%d", BENCH_READ_CHUNK);
+    report("spiffs_read", param, rate((double)total / 1e6, dt), "MB/s");
+    report("spiffs_open_read", "per_file", jpg_count ? (double)dt / jpg_count : 0.0, "us");
+}
+
+static void bench_jpeg(void)
+{
+    if (jpg_count == 0) {
+        report_skip("jpeg_decode", "all", "no_files");
+        return;
+    }
+    static const char* const scale_names[] = { "1/1", "1/2", "1/4", "1/8" };
+
+    for (int scale = JPEG_IMAGE_SCALE_0; scale <= JPEG_IMAGE_SCALE_1_8; scale++) {
+        int decoded = 0;
+        int64_t total_us = 0, worst_us = 0;
+
+        for (int i = 0; i < jpg_count; i++) {
+            size_t size;
+            uint8_t* jpg = load_file(jpg_paths[i], &size);
+            if (!jpg) continue;
+
+            esp_jpeg_image_cfg_t cfg = {
+                .indata = jpg,
+                .indata_size = size,
+                .out_format = JPEG_IMAGE_FORMAT_RGB565,
+                .out_scale = (esp_jpeg_image_scale_t)scale,
+            };
+            esp_jpeg_image_output_t info;
+            uint8_t* out = NULL;
+            if (esp_jpeg_get_image_info(&cfg, &info) == ESP_OK) {
+                out = heap_caps_malloc(info.output_len, MALLOC_CAP_8BIT);
+            }
+            if (out) {
+                cfg.outbuf = out;
+                cfg.outbuf_size = info.output_len;
+                int64_t t0 = esp_timer_get_time();
+                esp_err_t ret = esp_jpeg_decode(&cfg, &info);
+                int64_t dt = esp_timer_get_time() - t0;
+                if (ret == ESP_OK) {
+                    decoded++;
+                    total_us += dt;
+                    if (dt > worst_us) worst_us = dt;
+                }
+                heap_caps_free(out);
+            }
+            heap_caps_free(jpg);
+        }
+
+        char param[24];
+        snprintf(param, sizeof(param), "scale=%s", scale_names[scale]);
+        if (decoded == 0) {
+            report_skip("jpeg_decode", param, "no_mem");
+            continue;
+        }
+        report("jpeg_decode", param, (double)total_us / decoded, "us");
+        report("jpeg_decode_max", param, (double)worst_us, "us");
+        report("jpeg_decode_fps", param, rate(decoded, total_us), "fps");
+    }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Entrada
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void app_main(void)
+{
+    st77xx_mount_spiffs();
+    st77xx_init();
+    st77xx_backlight(77);
+    collect_jpgs();
+    st77xx_info_t info = st77xx_get_info();
+    ESP_LOGI(TAG, "%s + %s %dx%d, %s %lu MHz, PIE %s, %d JPG",
+             ST77XX_CHIP_NAME, ST77XX_CONTROLLER_NAME, ST77XX_WIDTH, ST77XX_HEIGHT,
+             info.bus_name, (unsigned long)(info.bus_clock_hz / 1000000),
+             ST77XX_USE_PIE ? "SI" : "NO", jpg_count);
+
+    // El log del driver no debe intercalarse con las líneas CSV
+    esp_log_level_set("*", ESP_LOG_WARN);
+    printf("BENCH,chip,panel,test,param,value,unit\n");
+
+    bench_flush("internal_swap", MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL, false);
+    bench_flush("internal_raw", MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL, true);
+#if ST77XX_HAS_PSRAM
+    bench_flush("psram_swap", MALLOC_CAP_SPIRAM, false);
+#endif
+    bench_stripe();
+    bench_draw();
+    bench_kernels("internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#if ST77XX_HAS_PSRAM
+    bench_kernels("psram", MALLOC_CAP_SPIRAM);
+#endif
+    bench_spiffs();
+    bench_jpeg();
+
+    printf("BENCH_DONE\n");
+    fflush(stdout);
+}
@@ -2,7 +2,8 @@
  * @file st77xx.h
  * @brief Driver unificado para displays ST7789/ST7796S sobre ESP32
  * 
- * Soporta detección automática de chip, PSRAM, double buffering y modo stripe.
+ * Soporta detección automática de chip, PSRAM, double buffering y modo stripe,
+ * sobre SPI o bus i80 paralelo (st77xx_transport.h).
  */
 
 #ifndef ST77XX_H
@@ -22,6 +23,7 @@
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
     #define ST77XX_CHIP_NAME      "ESP32-S3"
     #define ST77XX_HAS_PSRAM      1
+    #define ST77XX_HAS_PIE        1
     #define ST77XX_MAX_SPI_SPEED  (80 * 1000 * 1000)
 #elif defined(CONFIG_IDF_TARGET_ESP32S2)
     #define ST77XX_CHIP_NAME      "ESP32-S2"
@@ -46,6 +48,16 @@
     #define ST77XX_HAS_PSRAM      1
 #endif
 
+/** @brief Kernels vectoriales PIE de 128 bits (solo ESP32-S3) */
+#ifndef ST77XX_HAS_PIE
+    #define ST77XX_HAS_PIE        0
+#endif
+#if ST77XX_HAS_PIE && defined(CONFIG_ST77XX_USE_PIE) && CONFIG_ST77XX_USE_PIE
+    #define ST77XX_USE_PIE        1
+#else
+    #define ST77XX_USE_PIE        0
+#endif
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Selección de controlador (desde Kconfig o manual)
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -75,6 +87,11 @@
     #define ST77XX_PIN_MOSI  9
     #define ST77XX_PIN_MISO  8
     #define ST77XX_PIN_BL    43
+    // i80: CS, DC, RST y BL compartidos; WR en el pin de SCLK, RD a 3V3
+    #define ST77XX_PIN_WR    7
+    #define ST77XX_I80_DATA_PINS { 8, 9, 10, 11, 12, 13, 14, 15, \
+                                   16, 17, 18, 21, 38, 39, 40, 41 }
+    #define ST77XX_I80_MAX_WIDTH 16
 #else
     #define ST77XX_PIN_CS    5
     #define ST77XX_PIN_DC    16
@@ -83,8 +100,69 @@
     #define ST77XX_PIN_MOSI  19
     #define ST77XX_PIN_MISO  -1
     #define ST77XX_PIN_BL    4
+    #define ST77XX_PIN_WR    18
+    #define ST77XX_I80_DATA_PINS { 19, 21, 22, 25, 26, 27, 32, 33 }
+    #define ST77XX_I80_MAX_WIDTH 8
+#endif
+
+/** @brief Salida TE del panel (-1 = sin conectar) */
+#if defined(CONFIG_ST77XX_PIN_TE)
+    #define ST77XX_PIN_TE    CONFIG_ST77XX_PIN_TE
+#else
+    #define ST77XX_PIN_TE    -1
+#endif
+
+#if defined(CONFIG_ST77XX_TE_SCANLINE)
+    #define ST77XX_TE_SCANLINE CONFIG_ST77XX_TE_SCANLINE
+#else
+    #define ST77XX_TE_SCANLINE 0
 #endif
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Bus del panel
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/** @brief SPI de 4 hilos o i80 paralelo (esp_lcd), desde Kconfig */
+#if defined(CONFIG_ST77XX_BUS_I80) && CONFIG_ST77XX_BUS_I80
+    #define ST77XX_BUS_I80 1
+#else
+    #define ST77XX_BUS_I80 0
+#endif
+
+#if defined(CONFIG_ST77XX_I80_WIDTH_16) && CONFIG_ST77XX_I80_WIDTH_16
+    #define ST77XX_I80_BUS_WIDTH 16
+#else
+    #define ST77XX_I80_BUS_WIDTH 8
+#endif
+
+#if defined(CONFIG_ST77XX_I80_PCLK_MHZ)
+    #define ST77XX_I80_PCLK_HZ (CONFIG_ST77XX_I80_PCLK_MHZ * 1000 * 1000)
+#else
+    #define ST77XX_I80_PCLK_HZ (15 * 1000 * 1000)
+#endif
+
+#if ST77XX_BUS_I80 && ST77XX_I80_BUS_WIDTH > ST77XX_I80_MAX_WIDTH
+    #error "Esta placa no tiene pines para un bus i80 de 16 bits"
+#endif
+
+/** @brief Calibración del reloj SPI: requiere bus SPI y MISO conectado */
+#if defined(CONFIG_ST77XX_SPI_AUTOTUNE) && CONFIG_ST77XX_SPI_AUTOTUNE && \
+    !ST77XX_BUS_I80 && ST77XX_PIN_MISO >= 0
+    #define ST77XX_SPI_AUTOTUNE 1
+#else
+    #define ST77XX_SPI_AUTOTUNE 0
+#endif
+
+#if defined(CONFIG_ST77XX_SPI_AUTOTUNE_MAX_MHZ) && \
+    (CONFIG_ST77XX_SPI_AUTOTUNE_MAX_MHZ * 1000 * 1000) < ST77XX_MAX_SPI_SPEED
+    #define ST77XX_SPI_TUNE_MAX_HZ (CONFIG_ST77XX_SPI_AUTOTUNE_MAX_MHZ * 1000 * 1000)
+#else
+    #define ST77XX_SPI_TUNE_MAX_HZ ST77XX_MAX_SPI_SPEED
+#endif
+
+/** @brief Reloj de lectura de RAMRD (ciclo de lectura mínimo de 150 ns) */
+#define ST77XX_SPI_READ_HZ     (5 * 1000 * 1000)
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Configuración por modelo de controlador
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -94,6 +172,7 @@
     #define ST77XX_HEIGHT          135
     #define ST77XX_X_OFFSET        40
     #define ST77XX_Y_OFFSET        52
+    #define ST77XX_GRAM_LINES      320      // Líneas de gate (eje del scroll)
     #define ST77XX_USE_INVERSION   1
     #define ST77XX_SPI_SPEED_HZ    (40 * 1000 * 1000)
     #define ST77XX_CONTROLLER_NAME "ST7789"
@@ -102,6 +181,7 @@
     #define ST77XX_HEIGHT          320
     #define ST77XX_X_OFFSET        0
     #define ST77XX_Y_OFFSET        0
+    #define ST77XX_GRAM_LINES      480      // Líneas de gate (eje del scroll)
     #define ST77XX_USE_INVERSION   0
     #define ST77XX_SPI_SPEED_HZ    ST77XX_MAX_SPI_SPEED
     #define ST77XX_CONTROLLER_NAME "ST7796S"
@@ -116,16 +196,82 @@
 #define ST77XX_USE_PSRAM       ST77XX_HAS_PSRAM
 #define ST77XX_FB_SIZE         ((size_t)ST77XX_WIDTH * ST77XX_HEIGHT * sizeof(uint16_t))
 
-/** @brief Modo stripe: divide pantalla en franjas para menor uso de RAM */
-#define ST77XX_STRIPE_HEIGHT   27
-#define ST77XX_STRIPE_COUNT    (ST77XX_HEIGHT / ST77XX_STRIPE_HEIGHT)
-#define ST77XX_STRIPE_SIZE     ((size_t)ST77XX_WIDTH * ST77XX_STRIPE_HEIGHT * sizeof(uint16_t))
+/**
+ * @brief Modo stripe: divide pantalla en franjas para menor uso de RAM
+ *
+ * La altura se elige en st77xx_init_stripe_mode() según la memoria DMA
+ * libre y el tamaño de chunk DMA; la última franja cubre el resto de filas.
+ * ST77XX_STRIPE_HEIGHT = 0 significa automática.
+ */
+#if defined(CONFIG_ST77XX_STRIPE_HEIGHT)
+    #define ST77XX_STRIPE_HEIGHT   CONFIG_ST77XX_STRIPE_HEIGHT
+#else
+    #define ST77XX_STRIPE_HEIGHT   0
+#endif
+#define ST77XX_STRIPE_ALIGN        16    ///< Alineación de altura (filas de MCU JPEG)
+#define ST77XX_STRIPE_MAX_HEIGHT   (ST77XX_DMA_BUFFER_SIZE / (ST77XX_WIDTH * sizeof(uint16_t)))
+#define ST77XX_STRIPE_DMA_BUDGET   50    ///< % máximo de la RAM DMA libre para el anillo
+
+/** @brief Presupuesto de la caché de frames decodificados */
+#if defined(CONFIG_ST77XX_FRAME_CACHE_KB)
+    #define ST77XX_FRAME_CACHE_BUDGET  ((size_t)CONFIG_ST77XX_FRAME_CACHE_KB * 1024)
+#else
+    #define ST77XX_FRAME_CACHE_BUDGET  0
+#endif
+#define ST77XX_FRAME_CACHE_ENTRIES 32   ///< Entradas máximas de la caché
+
+/** @brief Slots del anillo de prefetch de frames (1 frame completo cada uno) */
+#if defined(CONFIG_ST77XX_PREFETCH_SLOTS)
+    #define ST77XX_PREFETCH_SLOTS  CONFIG_ST77XX_PREFETCH_SLOTS
+#else
+    #define ST77XX_PREFETCH_SLOTS  (ST77XX_HAS_PSRAM ? 4 : 2)
+#endif
+
+/** @brief Franjas en el anillo DMA: se genera la franja N+1 mientras se envía la N */
+#if defined(CONFIG_ST77XX_STRIPE_BUFFERS)
+    #define ST77XX_STRIPE_BUFFERS  CONFIG_ST77XX_STRIPE_BUFFERS
+#else
+    #define ST77XX_STRIPE_BUFFERS  2
+#endif
+
+/** @brief Seguimiento de regiones dañadas (dirty rects) */
+#define ST77XX_DIRTY_MAX_RECTS 8
+#define ST77XX_WINDOW_COST_PX  512   ///< Coste aproximado de una ventana, en píxeles equivalentes
+
+/** @brief Diff por filas entre frames consecutivos */
+#define ST77XX_DIFF_MAX_RECTS  32
+#define ST77XX_DIFF_BAND_ROWS  8
 
 /** @brief Configuración DMA */
 #define ST77XX_DMA_BUFFER_SIZE (32 * 1024)
-#define ST77XX_SPI_QUEUE_SIZE  8
+#define ST77XX_BUS_QUEUE_SIZE  8     ///< Transferencias de píxel en vuelo en el bus
+#define ST77XX_SPI_HOST        SPI2_HOST
 #define ST77XX_SWAP_BYTES_DMA  1
 
+/** @brief Buffers de rebote DMA (ping-pong): swap del chunk N+1 mientras se envía el N */
+#if defined(CONFIG_ST77XX_DMA_BUFFER_COUNT)
+    #define ST77XX_DMA_BUFFER_COUNT CONFIG_ST77XX_DMA_BUFFER_COUNT
+#else
+    #define ST77XX_DMA_BUFFER_COUNT 2
+#endif
+
+/** @brief Tarea de flush asíncrono */
+#define ST77XX_FLUSH_TASK_STACK 3072
+#define ST77XX_FLUSH_TASK_PRIO  10
+#if defined(CONFIG_FREERTOS_UNICORE) && CONFIG_FREERTOS_UNICORE
+    #define ST77XX_FLUSH_TASK_CORE 0
+#else
+    #define ST77XX_FLUSH_TASK_CORE 1
+#endif
+
+/** @brief Tarea de st77xx_init_async() (incluye la calibración SPI y sus logs) */
+#define ST77XX_INIT_TASK_STACK  4096
+
+/** @brief Tarea de prefetch: lectura de archivos en el core de la aplicación */
+#define ST77XX_PREFETCH_TASK_STACK 4096
+#define ST77XX_PREFETCH_TASK_PRIO  4
+#define ST77XX_PREFETCH_TASK_CORE  0
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Configuración Backlight (LEDC PWM)
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -167,20 +313,98 @@ typedef struct {
     const char* controller_name;
     uint16_t width;
     uint16_t height;
-    uint32_t spi_speed_hz;
+    uint32_t spi_speed_hz;          // 0 con bus i80
+    const char* bus_name;
+    uint32_t bus_clock_hz;          // SCLK o WR
     bool psram_enabled;
     bool initialized;
 } st77xx_info_t;
 
+/**
+ * @brief Rectángulo en coordenadas de pantalla (extremos inclusivos)
+ */
+typedef struct {
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+} st77xx_rect_t;
+
+/**
+ * @brief Modos de presentación de st77xx_swap_and_display()
+ */
+typedef enum {
+    ST77XX_PRESENT_FULL = 0,   ///< Envía siempre el frame completo
+    ST77XX_PRESENT_DIRTY = 1,  ///< Envía solo las regiones dañadas del back buffer
+    ST77XX_PRESENT_DIFF = 2    ///< Compara con el frame mostrado y envía solo lo que cambió
+} st77xx_present_mode_t;
+
+/**
+ * @brief Modelo de coste del diff por filas
+ */
+typedef struct {
+    uint16_t band_rows;        ///< Filas por banda al buscar spans cambiados
+    uint32_t window_cost_px;   ///< Coste de configurar una ventana, en píxeles equivalentes
+} st77xx_diff_config_t;
+
+/**
+ * @brief Estadísticas acumuladas del diff por filas
+ */
+typedef struct {
+    uint32_t frames;           ///< Frames presentados con diff
+    uint32_t full_frames;      ///< Frames en los que salió más barato enviar todo
+    uint32_t windows;          ///< Ventanas enviadas en total
+    uint64_t bytes_sent;       ///< Bytes de píxel enviados
+    uint64_t bytes_saved;      ///< Bytes ahorrados frente a frames completos
+    uint32_t last_windows;     ///< Ventanas del último frame
+    uint32_t last_bytes_sent;  ///< Bytes enviados en el último frame
+} st77xx_diff_stats_t;
+
+/**
+ * @brief Callback que genera el contenido de una franja
+ * @param stripe Buffer de la franja (RGB565 nativo, ancho ST77XX_WIDTH)
+ * @param index Índice de la franja
+ * @param y0 Primera fila de pantalla que cubre
+ * @param rows Número de filas de la franja
+ * @param ctx Contexto del usuario
+ */
+typedef void (*st77xx_stripe_render_cb_t)(uint16_t* stripe, int index, int32_t y0,
+                                          int32_t rows, void* ctx);
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * API - Inicialización y Sistema
  * ═══════════════════════════════════════════════════════════════════════════ */
 
 /**
  * @brief Inicializa el driver ST77xx (SPI, GPIO, secuencia de inicio)
+ *
+ * Usa las esperas mínimas del datasheet: unos 130 ms tras el encendido.
+ * Si hay un st77xx_init_async() en curso, espera a que termine.
  */
 void st77xx_init(void);
 
+/**
+ * @brief Inicia la secuencia de init en una tarea y retorna enseguida
+ *
+ * Las esperas del panel (reset, SLPOUT) corren en segundo plano: el
+ * llamador puede montar SPIFFS o cargar recursos mientras tanto, y debe
+ * llamar a st77xx_init_wait() antes de usar cualquier otra función.
+ *
+ * @param splash Frame completo en orden del panel (como st77xx_flush_raw()),
+ *               p.ej. en flash mapeada; se escribe en la GRAM antes de DISPON,
+ *               así que es lo primero que se ve. Debe seguir válido hasta
+ *               st77xx_init_wait(). NULL = sin splash
+ * @return ESP_OK, ESP_ERR_INVALID_STATE si ya se inició o ESP_ERR_NO_MEM
+ */
+esp_err_t st77xx_init_async(const uint16_t* splash);
+
+/**
+ * @brief Espera a que termine st77xx_init_async()
+ * @param timeout_ms Tiempo máximo (UINT32_MAX = sin límite)
+ * @return true si el driver está inicializado
+ */
+bool st77xx_init_wait(uint32_t timeout_ms);
+
 /**
  * @brief Inicialización rápida con double-buffering (requiere PSRAM)
  */
@@ -192,6 +416,24 @@ void st77xx_init_fast(void);
  */
 st77xx_info_t st77xx_get_info(void);
 
+/**
+ * @brief Vuelve a calibrar el reloj SPI y guarda el resultado en NVS
+ *
+ * Espera al flush en curso. Escribe patrones en la primera fila y la deja
+ * en negro: llamar entre frames (no con un frame de franjas abierto).
+ *
+ * @param force true = busca desde cero aunque el reloj guardado funcione
+ * @return Reloj aplicado en Hz, 0 sin CONFIG_ST77XX_SPI_AUTOTUNE, sin MISO,
+ *         si la lectura no responde o si ningún candidato es fiable (en
+ *         esos casos el reloj no cambia y no se guarda nada)
+ */
+uint32_t st77xx_spi_autotune(bool force);
+
+/**
+ * @brief Olvida el reloj calibrado; el próximo arranque vuelve a buscar
+ */
+void st77xx_spi_autotune_forget(void);
+
 /**
  * @brief Libera todos los recursos del driver
  */
@@ -224,6 +466,108 @@ void st77xx_flush(const uint16_t* frame_buffer);
  */
 void st77xx_flush_immediate(const uint16_t* frame_buffer);
 
+/**
+ * @brief Inicia el envío del framebuffer en segundo plano y retorna de inmediato
+ *
+ * El swap y la transferencia se realizan en una tarea dedicada. El buffer
+ * no debe modificarse ni liberarse hasta que st77xx_flush_wait() retorne.
+ * Cualquier otra llamada al driver espera primero a que termine el envío.
+ *
+ * @param frame_buffer Puntero al buffer RGB565
+ */
+void st77xx_flush_async(const uint16_t* frame_buffer);
+
+/**
+ * @brief Envía un framebuffer ya en orden de bytes del panel (RGB565 big-endian)
+ *
+ * Sin swap ni copia: si el buffer está en memoria accesible por DMA se
+ * entrega tal cual al driver SPI. Si no (p.ej. PSRAM), se copia por los
+ * buffers de rebote sin swap. Retorna cuando el buffer puede reutilizarse.
+ *
+ * @param frame_buffer Puntero al buffer RGB565 con bytes intercambiados
+ */
+void st77xx_flush_raw(const uint16_t* frame_buffer);
+
+/**
+ * @brief Versión asíncrona de st77xx_flush_raw()
+ * @param frame_buffer Puntero al buffer RGB565 con bytes intercambiados
+ */
+void st77xx_flush_raw_async(const uint16_t* frame_buffer);
+
+/**
+ * @brief Espera a que termine el flush asíncrono en curso (si lo hay)
+ */
+void st77xx_flush_wait(void);
+
+/**
+ * @brief Indica si hay un flush asíncrono en curso
+ * @return true si la transferencia aún no ha terminado
+ */
+bool st77xx_flush_busy(void);
+
+/**
+ * @brief Envía solo una región de un framebuffer completo
+ *
+ * Configura la ventana con st77xx_set_window() y envía las filas de la
+ * región leyéndolas con el stride del framebuffer.
+ *
+ * @param frame_buffer Framebuffer RGB565 de pantalla completa
+ * @param x, y Posición de la región
+ * @param w, h Dimensiones de la región
+ */
+void st77xx_flush_rect(const uint16_t* frame_buffer, int32_t x, int32_t y, int32_t w, int32_t h);
+
+/**
+ * @brief Envía una región con píxeles contiguos ya en orden del panel
+ *
+ * Como st77xx_flush_raw() pero para una ventana: @p pixels contiene w*h
+ * píxeles seguidos. Sin copia si la memoria es accesible por DMA. La región
+ * debe caber entera en pantalla (no se recorta).
+ *
+ * @param x, y Posición de la región
+ * @param w, h Dimensiones de la región
+ * @param pixels Píxeles RGB565 big-endian
+ */
+void st77xx_write_rect_raw(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* pixels);
+
+/**
+ * @brief Rellena una región de la pantalla con un color, sin framebuffer
+ * @param x, y Posición
+ * @param w, h Dimensiones
+ * @param color Color RGB565
+ */
+void st77xx_fill_rect_direct(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+
+/**
+ * @brief Envía solo los spans de next que difieren de prev (el frame mostrado)
+ *
+ * Compara fila a fila en palabras de 32 bits por bandas de filas, une los
+ * spans cercanos según el coste de ventana y emite ventanas CASET/RASET/RAMWR
+ * mínimas. Si el total no compensa, envía el frame completo.
+ *
+ * @param prev Frame actualmente en pantalla
+ * @param next Frame a mostrar
+ * @return Número de ventanas enviadas (0 si no hubo cambios)
+ */
+int st77xx_flush_diff(const uint16_t* prev, const uint16_t* next);
+
+/**
+ * @brief Ajusta el modelo de coste del diff y de la fusión de regiones
+ * @param config Nueva configuración (NULL restablece los valores por defecto)
+ */
+void st77xx_set_diff_config(const st77xx_diff_config_t* config);
+
+/**
+ * @brief Obtiene las estadísticas del diff por filas
+ * @param stats Estructura destino
+ */
+void st77xx_get_diff_stats(st77xx_diff_stats_t* stats);
+
+/**
+ * @brief Reinicia las estadísticas del diff por filas
+ */
+void st77xx_reset_diff_stats(void);
+
 /**
  * @brief Cambia la orientación de la pantalla
  * @param orientation Nueva orientación
@@ -243,6 +587,66 @@ void st77xx_backlight(uint8_t duty);
  */
 void st77xx_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API - Scroll por hardware
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * VSCRDEF/VSCSAD desplazan la imagen a lo largo de las líneas de gate del
+ * panel sin reenviar la GRAM: por cada paso solo se escriben las líneas
+ * que aparecen. En las orientaciones horizontales del driver esas líneas
+ * son columnas de la pantalla, así que el scroll es horizontal (tickers,
+ * gráficas y logs que avanzan de derecha a izquierda). En vertical el
+ * driver no tiene geometría propia y el scroll no está disponible.
+ *
+ * Con el scroll activo la GRAM ya no coincide con la pantalla: un flush
+ * completo se vería rotado dentro de la zona de scroll. Hay que llamar a
+ * st77xx_scroll_reset() antes, o dibujar en las columnas que devuelve
+ * st77xx_scroll_map().
+ */
+
+/**
+ * @brief Define la zona de scroll dejando columnas fijas a cada lado
+ *
+ * Resetea el desplazamiento. Tiene en cuenta el sentido de MADCTL de la
+ * orientación actual; st77xx_set_orientation() vuelve a aplicarla.
+ *
+ * @param fixed_left Columnas fijas a la izquierda
+ * @param fixed_right Columnas fijas a la derecha
+ * @return false en orientación vertical o si no queda zona de scroll
+ */
+bool st77xx_scroll_setup(uint16_t fixed_left, uint16_t fixed_right);
+
+/**
+ * @brief Desplaza la zona de scroll y escribe las columnas que aparecen
+ *
+ * El contenido se mueve @p cols columnas a la izquierda; las columnas
+ * nuevas entran por el borde derecho de la zona.
+ *
+ * @param pixels Rectángulo de cols x ST77XX_HEIGHT píxeles RGB565 nativos;
+ *               NULL solo desplaza y deja en las columnas nuevas lo que
+ *               salió por la izquierda
+ * @param cols Columnas a avanzar (como máximo el ancho de la zona)
+ */
+void st77xx_scroll_push(const uint16_t* pixels, int32_t cols);
+
+/**
+ * @brief Columna de la GRAM que se ve en la columna @p x de la pantalla
+ *
+ * Sin scroll activo devuelve @p x. Sirve para dibujar con
+ * st77xx_flush_rect() o st77xx_fill_rect_direct() con el scroll activo.
+ */
+int32_t st77xx_scroll_map(int32_t x);
+
+/**
+ * @brief Indica si hay una zona de scroll definida
+ */
+bool st77xx_scroll_active(void);
+
+/**
+ * @brief Sale del modo scroll (NORON); la GRAM vuelve a verse tal cual
+ */
+void st77xx_scroll_reset(void);
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * API - Double Buffering
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -260,9 +664,82 @@ uint16_t* st77xx_get_draw_buffer(void);
 
 /**
  * @brief Intercambia buffers y muestra el contenido
+ *
+ * En modo ST77XX_PRESENT_DIRTY solo se envían las regiones dañadas, que
+ * después se copian al nuevo back buffer para que ambos sigan idénticos.
+ * En modo ST77XX_PRESENT_DIFF se compara con el frame mostrado; requiere
+ * que cada frame se redibuje completo en el back buffer.
  */
 void st77xx_swap_and_display(void);
 
+/**
+ * @brief Selecciona cómo presenta st77xx_swap_and_display() el back buffer
+ *
+ * Al activar ST77XX_PRESENT_DIRTY el primer swap envía el frame completo.
+ *
+ * @param mode Modo de presentación
+ */
+void st77xx_set_present_mode(st77xx_present_mode_t mode);
+
+/**
+ * @brief Activa o desactiva la sincronización con el pin TE
+ *
+ * Con la sincronización activa cada flush de frame completo (síncrono,
+ * asíncrono o raw) y cada st77xx_swap_and_display() esperan al pulso TE,
+ * que el panel emite al pasar su barrido por CONFIG_ST77XX_TE_SCANLINE:
+ * la escritura arranca justo detrás del barrido. No hay tearing mientras
+ * el envío dure menos de dos refrescos y la orientación recorra la GRAM en
+ * el mismo sentido que el barrido. Se activa en st77xx_init() si hay pin
+ * TE, y se desactiva sola con un aviso si dejan de llegar pulsos.
+ *
+ * @param enable true para sincronizar
+ * @return false si no hay pin TE configurado
+ */
+bool st77xx_set_te_sync(bool enable);
+
+/**
+ * @brief Indica si los flush esperan al pulso TE
+ */
+bool st77xx_te_active(void);
+
+/**
+ * @brief Período de refresco del panel medido entre pulsos TE
+ * @return Microsegundos, 0 sin TE o antes del segundo pulso
+ */
+uint32_t st77xx_get_refresh_period_us(void);
+
+/**
+ * @brief Refrescos del panel que dura cada frame con TE activo
+ *
+ * El siguiente flush espera al pulso número @p refreshes contado desde el
+ * anterior; si llega tarde sale con el pulso siguiente.
+ *
+ * @param refreshes 1 = cada refresco (p. ej. 60 fps), 2 = uno de cada dos...
+ */
+void st77xx_set_present_interval(uint8_t refreshes);
+
+/**
+ * @brief Espera entre frames de una animación
+ *
+ * Con TE activo no duerme: convierte @p delay_ms al número de refrescos
+ * más cercano (mínimo uno) y el siguiente flush espera a ese pulso, así la
+ * cadencia queda anclada al panel. Sin TE equivale a vTaskDelay().
+ *
+ * @param delay_ms Tiempo de cada frame en pantalla
+ */
+void st77xx_frame_delay(uint32_t delay_ms);
+
+/**
+ * @brief Marca una región del back buffer como modificada
+ *
+ * Las primitivas de dibujo lo hacen solas; usar cuando se escribe
+ * directamente en el buffer de st77xx_get_draw_buffer().
+ *
+ * @param x, y Posición
+ * @param w, h Dimensiones
+ */
+void st77xx_mark_dirty(int32_t x, int32_t y, int32_t w, int32_t h);
+
 /**
  * @brief Libera los buffers dobles
  */
@@ -274,9 +751,37 @@ void st77xx_cleanup_double_buffers(void);
 
 /**
  * @brief Inicializa el modo stripe buffer
+ *
+ * Reserva un anillo persistente de ST77XX_STRIPE_BUFFERS franjas en memoria
+ * DMA. Conviene llamarla una vez al inicio y no por frame.
  */
 void st77xx_init_stripe_mode(void);
 
+/**
+ * @brief Fija la altura de franja (0 = automática); reinicia el modo si está activo
+ * @param rows Filas por franja, se limita a ST77XX_STRIPE_MAX_HEIGHT
+ */
+void st77xx_stripe_set_height(int32_t rows);
+
+/**
+ * @brief Altura nominal de franja elegida (0 si el modo no está activo)
+ * @return Filas por franja
+ */
+int32_t st77xx_stripe_get_height(void);
+
+/**
+ * @brief Número de franjas por frame
+ * @return Franjas por frame (0 si el modo no está activo)
+ */
+int st77xx_stripe_get_count(void);
+
+/**
+ * @brief Filas que cubre una franja concreta (la última puede ser menor)
+ * @param index Índice de la franja
+ * @return Filas de la franja, 0 si el índice no es válido
+ */
+int32_t st77xx_stripe_get_rows(int index);
+
 /**
  * @brief Obtiene el buffer de la franja actual
  * @return Puntero al buffer de stripe
@@ -315,6 +820,36 @@ void st77xx_stripe_begin_frame(void);
  */
 bool st77xx_stripe_draw_image(const char* path);
 
+/**
+ * @brief Obtiene la siguiente franja libre del anillo para generarla
+ *
+ * En la primera franja del frame configura la ventana completa. Espera solo
+ * si el DMA todavía está leyendo esa franja. Entre acquire y submit de un
+ * frame no deben usarse otras funciones de envío del driver.
+ *
+ * @return Buffer de la franja, NULL si el frame ya está completo
+ */
+uint16_t* st77xx_stripe_acquire(void);
+
+/**
+ * @brief Encola la franja obtenida con st77xx_stripe_acquire() y avanza
+ *
+ * El swap de bytes se hace en el propio buffer y se envía sin copia;
+ * retorna sin esperar a que termine la transferencia.
+ */
+void st77xx_stripe_submit(void);
+
+/**
+ * @brief Genera y envía un frame completo franja a franja
+ *
+ * Llama a cb para cada franja mientras el DMA envía la anterior.
+ *
+ * @param cb Callback que rellena cada franja
+ * @param ctx Contexto pasado al callback
+ * @return true si se envió el frame completo
+ */
+bool st77xx_stripe_render(st77xx_stripe_render_cb_t cb, void* ctx);
+
 /**
  * @brief Libera recursos del modo stripe
  */
@@ -348,6 +883,23 @@ void st77xx_draw_pixel(uint16_t* fb, int32_t x, int32_t y, uint16_t color);
  */
 void st77xx_fill_rect(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
 
+/**
+ * @brief Copia una imagen RGB565 al framebuffer
+ * @param fb Framebuffer destino
+ * @param x, y Posición de la esquina superior izquierda (se recorta)
+ * @param w, h Dimensiones de la imagen
+ * @param src Píxeles en el mismo orden de bytes que @p fb
+ * @param src_stride Píxeles entre filas de @p src
+ */
+void st77xx_blit(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h,
+                 const uint16_t* src, int32_t src_stride);
+
+/**
+ * @brief Como st77xx_blit() pero los píxeles iguales a @p key son transparentes
+ */
+void st77xx_blit_key(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h,
+                     const uint16_t* src, int32_t src_stride, uint16_t key);
+
 /**
  * @brief Carga imagen RGB565 desde archivo
  * @param fb Framebuffer destino
@@ -380,6 +932,25 @@ void st77xx_draw_text(uint16_t* fb, const char* text, int32_t x, int32_t y,
 void st77xx_draw_text_unicode(uint16_t* fb, const char* text, int32_t x, int32_t y,
                               uint16_t color, uint8_t scale, const uint8_t* font);
 
+/**
+ * @brief Dibuja texto UTF-8 en una franja
+ *
+ * Pensado para callbacks de st77xx_stripe_render(): el texto se posiciona
+ * en coordenadas de pantalla y se recorta a las filas que cubre la franja.
+ *
+ * @param stripe Buffer de la franja (ancho ST77XX_WIDTH)
+ * @param y0 Primera fila de pantalla que cubre la franja
+ * @param rows Filas de la franja
+ * @param text Texto UTF-8
+ * @param x, y Posición en pantalla
+ * @param color Color RGB565
+ * @param scale Factor de escala
+ * @param font Datos de fuente
+ */
+void st77xx_stripe_draw_text(uint16_t* stripe, int32_t y0, int32_t rows, const char* text,
+                             int32_t x, int32_t y, uint16_t color, uint8_t scale,
+                             const uint8_t* font);
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * API - Utilidades
  * ═══════════════════════════════════════════════════════════════════════════ */
@@ -412,6 +983,11 @@ int st77xx_preload_frames(const char* base_dir, int max_preload);
 
 /**
  * @brief Obtiene un frame precargado
+ *
+ * Los frames que no cupieron en memoria al precargar se leen bajo demanda a
+ * través de la caché de frames; ese puntero es válido hasta la siguiente
+ * llamada.
+ *
  * @param index Índice del frame
  * @return Puntero a los datos del frame
  */
@@ -419,7 +995,7 @@ const uint8_t* st77xx_get_preloaded_frame(int index);
 
 /**
  * @brief Obtiene cantidad de frames precargados
- * @return Número de frames
+ * @return Número de frames (en memoria más los servidos por la caché)
  */
 int st77xx_get_preloaded_count(void);
 
@@ -428,6 +1004,152 @@ int st77xx_get_preloaded_count(void);
  */
 void st77xx_free_preloaded_frames(void);
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API - Prefetch asíncrono de frames
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Estado de un frame en el prefetch
+ */
+typedef enum {
+    ST77XX_PREFETCH_PENDING,    ///< Aún no leído (o leyéndose)
+    ST77XX_PREFETCH_READY,      ///< En memoria
+    ST77XX_PREFETCH_MISSING,    ///< Más allá del último frame
+    ST77XX_PREFETCH_ERROR,      ///< Archivo corto o ilegible
+} st77xx_prefetch_state_t;
+
+/**
+ * @brief Arranca la lectura de frames en segundo plano
+ *
+ * Una tarea lee @p base_dir/N.bin (N = 1, 2...) en un anillo de
+ * ST77XX_PREFETCH_SLOTS frames, adelantándose a la reproducción. Vuelve en
+ * cuanto el frame 0 está en memoria, así que el arranque no depende de la
+ * longitud de la animación. El primer archivo que falta marca el final; un
+ * archivo corto se marca como ST77XX_PREFETCH_ERROR y no corta el resto.
+ *
+ * @param base_dir Directorio con los frames
+ * @param max_frames Máximo número de frames
+ * @param timeout_ms Espera máxima por el frame 0
+ * @return ESP_OK, ESP_ERR_NOT_FOUND si no hay frames, ESP_ERR_INVALID_SIZE si
+ *         el frame 0 es erróneo, ESP_ERR_TIMEOUT, ESP_ERR_NO_MEM o
+ *         ESP_ERR_INVALID_STATE si ya está en marcha. Con cualquier error
+ *         salvo INVALID_STATE la tarea ya está detenida y el anillo liberado.
+ */
+esp_err_t st77xx_prefetch_start(const char* base_dir, int max_frames, uint32_t timeout_ms);
+
+/**
+ * @brief Estado del frame @p index, sin esperar
+ */
+st77xx_prefetch_state_t st77xx_prefetch_state(int index);
+
+/**
+ * @brief Obtiene el frame @p index, esperando a que se lea
+ *
+ * El frame queda retenido en su slot hasta st77xx_prefetch_release(). Se
+ * espera pedir los frames en orden; un salto se atiende a continuación
+ * del frame que se esté leyendo. Llamar solo desde una tarea.
+ *
+ * @param index Índice del frame
+ * @param timeout_ms Espera máxima
+ * @return Datos del frame (ST77XX_FB_SIZE bytes), o NULL si no existe, es
+ *         erróneo o no llegó a tiempo
+ */
+const uint8_t* st77xx_prefetch_get(int index, uint32_t timeout_ms);
+
+/**
+ * @brief Devuelve el slot del frame @p index para leer los siguientes
+ *
+ * Si la animación entera cabe en el anillo los frames se quedan en memoria.
+ */
+void st77xx_prefetch_release(int index);
+
+/**
+ * @brief Frames de la animación, o -1 mientras no se haya encontrado el final
+ */
+int st77xx_prefetch_count(void);
+
+/**
+ * @brief Detiene la tarea de prefetch y libera el anillo
+ */
+void st77xx_prefetch_stop(void);
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API - Caché de frames decodificados
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Estadísticas de la caché de frames
+ */
+typedef struct {
+    uint32_t hits;          ///< Búsquedas encontradas
+    uint32_t misses;        ///< Búsquedas fallidas
+    uint32_t inserts;       ///< Entradas creadas
+    uint32_t evictions;     ///< Entradas expulsadas por LRU
+    uint32_t rejects;       ///< Inserciones que no cabían en el presupuesto
+    size_t bytes_used;      ///< Bytes ocupados
+    size_t budget;          ///< Presupuesto en bytes
+    int entries;            ///< Entradas actuales
+} st77xx_cache_stats_t;
+
+/**
+ * @brief Clave de caché para un nombre de asset (hash FNV-1a)
+ * @param name Ruta o identificador
+ * @return Clave (nunca 0)
+ */
+uint32_t st77xx_cache_key(const char* name);
+
+/**
+ * @brief Busca un frame en la caché
+ *
+ * Si existe, lo marca como el más reciente y lo fija: no se expulsa hasta
+ * st77xx_cache_release().
+ *
+ * @param key Clave del frame
+ * @param[out] size Bytes del frame (opcional)
+ * @return Datos del frame o NULL si no está
+ */
+const uint16_t* st77xx_cache_get(uint32_t key, size_t* size);
+
+/**
+ * @brief Reserva una entrada nueva de @p size bytes para @p key
+ *
+ * Expulsa entradas no fijadas, de la menos reciente a la más, hasta que
+ * quepa. La entrada devuelta está fijada; el llamador la rellena y luego
+ * llama a st77xx_cache_release(). Si @p key ya existía se sustituye.
+ *
+ * @return Buffer a rellenar o NULL si no cabe en el presupuesto
+ */
+uint16_t* st77xx_cache_insert(uint32_t key, size_t size);
+
+/**
+ * @brief Libera la fijación obtenida con st77xx_cache_get()/insert()
+ * @param data Puntero devuelto por la caché
+ */
+void st77xx_cache_release(const uint16_t* data);
+
+/**
+ * @brief Elimina una entrada (p.ej. si falló su decodificación)
+ * @param key Clave del frame
+ */
+void st77xx_cache_remove(uint32_t key);
+
+/**
+ * @brief Cambia el presupuesto; expulsa lo que sobre
+ * @param bytes Nuevo presupuesto (0 desactiva la caché)
+ */
+void st77xx_cache_set_budget(size_t bytes);
+
+/**
+ * @brief Vacía la caché (las entradas fijadas se conservan)
+ */
+void st77xx_cache_clear(void);
+
+/**
+ * @brief Copia las estadísticas de la caché
+ * @param out Destino
+ */
+void st77xx_cache_get_stats(st77xx_cache_stats_t* out);
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Macros de compatibilidad (legacy)
  * ═══════════════════════════════════════════════════════════════════════════ */
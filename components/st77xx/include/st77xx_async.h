@@ -0,0 +1,81 @@
+/**
+ * @file st77xx_async.h
+ * @brief Copias y rellenos de framebuffer en segundo plano por DMA
+ *
+ * Misma forma que los kernels de st77xx_kernels.h, pero el trabajo lo hace
+ * el motor de async memcpy (GDMA en ESP32-S3/C3/C6, CP_DMA en ESP32-S2)
+ * mientras la CPU sigue decodificando. Las operaciones se encolan en orden
+ * y terminan en ese mismo orden.
+ *
+ * Sin motor DMA (ESP32) o con CONFIG_ST77XX_ASYNC_BLIT desactivado, cada
+ * llamada se resuelve al momento con los kernels de CPU y el callback se
+ * invoca antes de volver, así que el código que las usa no cambia.
+ *
+ * Ningún chip soportado tiene PPA; el backend queda limitado a async memcpy.
+ */
+
+#ifndef ST77XX_ASYNC_H
+#define ST77XX_ASYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "st77xx.h"
+
+#if defined(CONFIG_ST77XX_ASYNC_BLIT) && CONFIG_ST77XX_ASYNC_BLIT
+    #define ST77XX_USE_ASYNC_BLIT 1
+#else
+    #define ST77XX_USE_ASYNC_BLIT 0
+#endif
+
+/** @brief Transferencias DMA pendientes como máximo (una por fila en blits 2D) */
+#define ST77XX_ASYNC_BACKLOG 32
+
+/**
+ * @brief Aviso de fin de una operación
+ *
+ * Con DMA se llama desde la ISR de fin de transferencia: solo puede usar
+ * funciones FromISR. Devuelve true si ha despertado una tarea de mayor
+ * prioridad.
+ */
+typedef bool (*st77xx_async_cb_t)(void* ctx);
+
+/**
+ * @brief Instala el motor de async memcpy (también se hace en el primer uso)
+ * @return ESP_OK, o ESP_ERR_NOT_SUPPORTED si se usará la CPU
+ */
+esp_err_t st77xx_async_init(void);
+
+/**
+ * @brief Copia @p n píxeles
+ * @param cb Opcional: se llama al terminar
+ */
+esp_err_t st77xx_async_copy(uint16_t* dst, const uint16_t* src, size_t n,
+                            st77xx_async_cb_t cb, void* ctx);
+
+/**
+ * @brief Copia un rectángulo de @p w x @p h píxeles con strides independientes
+ */
+esp_err_t st77xx_async_blit(uint16_t* dst, int32_t dst_stride, const uint16_t* src,
+                            int32_t src_stride, int32_t w, int32_t h,
+                            st77xx_async_cb_t cb, void* ctx);
+
+/**
+ * @brief Rellena un rectángulo
+ *
+ * La CPU rellena la primera fila y el DMA la replica en las demás.
+ */
+esp_err_t st77xx_async_fill(uint16_t* dst, int32_t stride, int32_t w, int32_t h,
+                            uint16_t color, st77xx_async_cb_t cb, void* ctx);
+
+/**
+ * @brief Espera a que terminen todas las operaciones encoladas
+ *
+ * Pueden esperar varias tareas a la vez (la que encola y la que envía).
+ *
+ * @return ESP_OK o ESP_ERR_TIMEOUT
+ */
+esp_err_t st77xx_async_wait(uint32_t timeout_ms);
+
+#endif // ST77XX_ASYNC_H
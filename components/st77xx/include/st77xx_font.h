@@ -0,0 +1,139 @@
+/**
+ * @file st77xx_font.h
+ * @brief Fuentes proporcionales antialias (ST7F) mapeadas desde flash
+ *
+ * A diferencia de font.bin (8x12, 1 bpp, escalado por duplicación de
+ * píxeles), una fuente ST7F guarda cada glifo a su tamaño real con avance,
+ * caja y alfa de 2 o 4 bits. La genera tools/st7f_pack.py a partir de un
+ * TTF y se lee con esp_partition_mmap(): en RAM solo queda el índice ASCII
+ * del handle (unos cientos de bytes).
+ *
+ * Formato (little-endian):
+ *   st7f_header_t
+ *   st7f_glyph_t[glyph_count]      (en header.glyph_offset, por codepoint)
+ *   bitmaps                        (en header.bitmap_offset)
+ *
+ * Cada bitmap son height filas de ceil(width * bpp / 8) bytes; el píxel
+ * más a la izquierda ocupa los bits altos. 0 es transparente y el valor
+ * máximo, opaco.
+ */
+
+#ifndef ST77XX_FONT_H
+#define ST77XX_FONT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#define ST7F_MAGIC   "ST7F"
+#define ST7F_VERSION 1
+
+/** @brief Primer y último codepoint con búsqueda directa */
+#define ST7F_ASCII_FIRST 32
+#define ST7F_ASCII_LAST  126
+#define ST7F_NO_GLYPH    0xFFFF
+
+/**
+ * @brief Cabecera de la fuente (28 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    char magic[4];          ///< "ST7F"
+    uint16_t version;       ///< ST7F_VERSION
+    uint16_t header_size;   ///< sizeof(st7f_header_t)
+    uint8_t bpp;            ///< Bits de alfa por píxel: 2 o 4
+    uint8_t flags;          ///< Reservado (0)
+    uint16_t glyph_count;   ///< Entradas de la tabla de glifos
+    uint16_t line_height;   ///< Avance vertical entre líneas
+    uint16_t ascent;        ///< Línea base, desde la parte superior de la línea
+    uint32_t glyph_offset;  ///< Offset de la tabla de glifos
+    uint32_t bitmap_offset; ///< Offset del bloque de bitmaps
+    uint32_t total_size;    ///< Tamaño total de la fuente
+} st7f_header_t;
+
+/**
+ * @brief Glifo (16 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t codepoint;     ///< Unicode; la tabla está ordenada por este campo
+    uint32_t offset;        ///< Offset del bitmap dentro del bloque de bitmaps
+    uint8_t width;          ///< Ancho del bitmap
+    uint8_t height;         ///< Alto del bitmap
+    uint8_t advance;        ///< Avance horizontal hasta el siguiente glifo
+    uint8_t reserved;
+    int16_t x_offset;       ///< Del origen del glifo al borde izquierdo del bitmap
+    int16_t y_offset;       ///< De la parte superior de la línea al borde superior
+} st7f_glyph_t;
+
+/**
+ * @brief Fuente abierta
+ */
+typedef struct {
+    const uint8_t* base;                ///< Inicio de la fuente (flash mapeada o RAM)
+    const st7f_header_t* header;
+    const st7f_glyph_t* glyphs;
+    const uint8_t* bitmaps;
+    esp_partition_mmap_handle_t mmap;
+    bool mapped;                        ///< true si hay que desmapear al cerrar
+    uint16_t ascii[ST7F_ASCII_LAST - ST7F_ASCII_FIRST + 1];  ///< Índice directo
+} st77xx_font_t;
+
+/**
+ * @brief Mapea y valida la fuente de la partición @p label
+ * @param label Etiqueta de la partición (p.ej. "font")
+ * @param[out] font Fuente abierta
+ * @return ESP_OK, ESP_ERR_NOT_FOUND sin partición, ESP_ERR_INVALID_VERSION
+ *         si el contenido no es una fuente ST7F válida u otro error de mmap
+ */
+esp_err_t st77xx_font_open(const char* label, st77xx_font_t* font);
+
+/**
+ * @brief Usa una fuente ST7F que ya está en memoria (no se copia)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG o ESP_ERR_INVALID_VERSION
+ */
+esp_err_t st77xx_font_open_mem(const void* data, size_t size, st77xx_font_t* font);
+
+/**
+ * @brief Libera el mapeo
+ */
+void st77xx_font_close(st77xx_font_t* font);
+
+/**
+ * @brief Busca el glifo de @p codepoint
+ * @return Glifo, o NULL si la fuente no lo tiene
+ */
+const st7f_glyph_t* st77xx_font_glyph(const st77xx_font_t* font, uint32_t codepoint);
+
+/**
+ * @brief Ancho en píxeles de la línea más larga de @p text
+ */
+int32_t st77xx_font_text_width(const st77xx_font_t* font, const char* text);
+
+/**
+ * @brief Dibuja texto UTF-8 mezclando el alfa de cada glifo con el fondo
+ *
+ * Los glifos se recortan una vez a la pantalla; los píxeles opacos se
+ * escriben directamente y el resto con tablas de mezcla precalculadas
+ * para @p color.
+ *
+ * @param font Fuente abierta
+ * @param fb Framebuffer destino (RGB565 nativo)
+ * @param text Texto UTF-8 ('\n' salta de línea)
+ * @param x, y Esquina superior izquierda de la primera línea
+ * @param color Color RGB565
+ */
+void st77xx_font_draw_text(const st77xx_font_t* font, uint16_t* fb, const char* text,
+                           int32_t x, int32_t y, uint16_t color);
+
+/**
+ * @brief Igual que st77xx_font_draw_text() pero sobre una franja
+ * @param stripe Buffer de la franja (ancho ST77XX_WIDTH)
+ * @param y0 Primera fila de pantalla que cubre la franja
+ * @param rows Filas de la franja
+ */
+void st77xx_font_stripe_draw_text(const st77xx_font_t* font, uint16_t* stripe, int32_t y0,
+                                  int32_t rows, const char* text, int32_t x, int32_t y,
+                                  uint16_t color);
+
+#endif // ST77XX_FONT_H
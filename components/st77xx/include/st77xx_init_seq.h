@@ -0,0 +1,80 @@
+/**
+ * @file st77xx_init_seq.h
+ * @brief Secuencia de inicialización común al panel principal y a los adicionales
+ *
+ * Una sola tabla de comandos y parámetros por modelo y las esperas mínimas
+ * del datasheet (ST7789V / ST7796S). Quien la usa solo aporta cómo se
+ * envía un comando a su panel: st77xx_init() por el transporte del driver
+ * y st77xx_panel_create() por su dispositivo SPI.
+ *
+ * Entre st77xx_init_seq_begin() y st77xx_init_seq_display_on() el panel
+ * sigue apagado y ya acepta escrituras en la GRAM: es el hueco para el
+ * splash o el ajuste del reloj, que así cubren parte de la espera tras
+ * SLPOUT.
+ */
+
+#ifndef ST77XX_INIT_SEQ_H
+#define ST77XX_INIT_SEQ_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "st77xx.h"
+#include "st77xx_panel.h"
+
+/** @brief Modelo del panel principal (Kconfig) en st77xx_init_models */
+#if defined(ST77XX_MODEL_ST7789)
+    #define ST77XX_INIT_MODEL ST77XX_PANEL_ST7789
+#else
+    #define ST77XX_INIT_MODEL ST77XX_PANEL_ST7796S
+#endif
+
+/** @brief Valores de la secuencia que dependen del modelo */
+typedef struct {
+    uint8_t gctrl;
+    uint8_t vcoms;
+    uint8_t madctl[4];              // Por st77xx_orientation_t
+} st77xx_init_model_t;
+
+/** @brief Por st77xx_panel_model_t */
+extern const st77xx_init_model_t st77xx_init_models[2];
+
+/**
+ * @brief Envía un comando y sus parámetros (@p size puede ser 0)
+ */
+typedef void (*st77xx_init_tx_fn)(void* ctx, uint8_t cmd, const uint8_t* data, size_t size);
+
+/** @brief Panel a inicializar */
+typedef struct {
+    st77xx_init_tx_fn tx;
+    void* ctx;                      // Argumento de tx
+    st77xx_panel_model_t model;
+    st77xx_orientation_t orientation;
+    bool invert;                    // INVON (paneles IPS)
+    int pin_rst;                    // -1 = SWRESET; ya configurado como salida
+} st77xx_init_target_t;
+
+/**
+ * @brief Reset, SLPOUT y configuración hasta NORON, con el display apagado
+ *
+ * SWRESET solo sin pin de RST. La espera tras el reset depende de si el
+ * panel viene de un encendido (5 ms) o de otro reinicio (120 ms).
+ *
+ * @return Instante de SLPOUT, para st77xx_init_seq_display_on()
+ */
+int64_t st77xx_init_seq_begin(const st77xx_init_target_t* target);
+
+/**
+ * @brief Espera lo que quede de los 120 ms tras SLPOUT y envía DISPON
+ */
+void st77xx_init_seq_display_on(const st77xx_init_target_t* target, int64_t t_slpout);
+
+/**
+ * @brief Espera hasta @p deadline_us: ticks enteros y el resto en activo
+ *
+ * Con CONFIG_FREERTOS_HZ=100 un vTaskDelay() redondea a 10 ms; las esperas
+ * de 5 ms del datasheet costarían el doble.
+ */
+void st77xx_init_wait_until(int64_t deadline_us);
+
+#endif // ST77XX_INIT_SEQ_H
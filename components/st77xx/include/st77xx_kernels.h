@@ -0,0 +1,69 @@
+/**
+ * @file st77xx_kernels.h
+ * @brief Kernels de píxel RGB565: relleno, copia, swap y blit con color clave
+ *
+ * En ESP32-S3 (ST77XX_USE_PIE) el relleno y la copia usan las instrucciones
+ * vectoriales PIE de 128 bits: 8 píxeles por acceso en la parte alineada a
+ * 16 bytes. En el resto de chips, o con la opción desactivada, se usan
+ * bucles portables de 32 bits. La elección es en tiempo de compilación.
+ *
+ * Los kernels no recortan ni registran daño: trabajan sobre punteros y
+ * strides en píxeles. Las primitivas de st77xx.h se apoyan en ellos.
+ */
+
+#ifndef ST77XX_KERNELS_H
+#define ST77XX_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "st77xx.h"
+
+/**
+ * @brief Rellena @p n píxeles con @p color
+ */
+void st77xx_kernel_fill(uint16_t* dst, uint16_t color, size_t n);
+
+/**
+ * @brief Rellena un rectángulo de @p w x @p h píxeles
+ * @param stride Píxeles entre filas de @p dst
+ */
+void st77xx_kernel_fill_rect(uint16_t* dst, int32_t stride, int32_t w, int32_t h, uint16_t color);
+
+/**
+ * @brief Copia @p n píxeles (las regiones no deben solaparse)
+ */
+void st77xx_kernel_copy(uint16_t* dst, const uint16_t* src, size_t n);
+
+/**
+ * @brief Copia un rectángulo de @p w x @p h píxeles
+ */
+void st77xx_kernel_blit(uint16_t* dst, int32_t dst_stride, const uint16_t* src,
+                        int32_t src_stride, int32_t w, int32_t h);
+
+/**
+ * @brief Copia un rectángulo saltando los píxeles iguales a @p key
+ */
+void st77xx_kernel_blit_key(uint16_t* dst, int32_t dst_stride, const uint16_t* src,
+                            int32_t src_stride, int32_t w, int32_t h, uint16_t key);
+
+/**
+ * @brief Intercambia los bytes de @p n píxeles (admite @p dst == @p src)
+ *
+ * Es también la copia del staging DMA: lee el origen (p.ej. PSRAM) y
+ * escribe el destino una sola vez por píxel. Con PIE procesa 16 píxeles
+ * por iteración; en portable, 2 por palabra de 32 bits.
+ */
+void st77xx_kernel_swap(uint16_t* dst, const uint16_t* src, size_t n);
+
+/**
+ * @brief Mide fill, copy y swap y muestra los MB/s en el log
+ *
+ * Compara cada kernel con el swap byte a byte original, de RAM interna y
+ * (si hay) de PSRAM a RAM DMA, y verifica antes el resultado del swap.
+ *
+ * @param pixels Píxeles por pasada (0 = un buffer DMA de ST77XX_DMA_BUFFER_SIZE)
+ * @param rounds Pasadas por kernel (0 = 32)
+ */
+void st77xx_kernel_benchmark(size_t pixels, int rounds);
+
+#endif // ST77XX_KERNELS_H
@@ -0,0 +1,116 @@
+/**
+ * @file st77xx_panel.h
+ * @brief Paneles adicionales en el mismo bus SPI, con estado por instancia
+ *
+ * La API de st77xx.h sigue manejando el panel configurado en Kconfig, con
+ * sus framebuffers, franjas y cachés. Cada panel adicional es un handle
+ * con sus propios pines CS y DC, modelo, resolución, offsets y velocidad,
+ * y se añade como otro dispositivo del bus SPI que st77xx_init() ya
+ * inicializó. RST puede compartirse con el panel principal (pin_rst = -1).
+ *
+ * Los flush de los paneles son asíncronos: una tarea del bus los envía en
+ * porciones de ST77XX_PANEL_SLICE_BYTES, alternando entre paneles. Cuando
+ * el driver principal y esta tarea usan el bus a la vez, cada uno deja
+ * como máximo una transferencia en vuelo, así que un frame completo de un
+ * panel no retrasa la actualización pequeña de otro más de una porción.
+ *
+ * Solo con el bus SPI (CONFIG_ST77XX_BUS_SPI).
+ */
+
+#ifndef ST77XX_PANEL_H
+#define ST77XX_PANEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "st77xx.h"
+
+/** @brief Paneles adicionales como máximo */
+#define ST77XX_MAX_PANELS        3
+
+/** @brief Bytes por porción enviada antes de pasar al siguiente panel */
+#define ST77XX_PANEL_SLICE_BYTES (8 * 1024)
+
+/** @brief Tarea del bus compartido */
+#define ST77XX_BUS_TASK_STACK    3072
+#define ST77XX_BUS_TASK_PRIO     ST77XX_FLUSH_TASK_PRIO
+
+typedef struct st77xx_panel* st77xx_handle_t;
+
+/** @brief Controlador del panel */
+typedef enum {
+    ST77XX_PANEL_ST7789 = 0,
+    ST77XX_PANEL_ST7796S
+} st77xx_panel_model_t;
+
+/** @brief Configuración de un panel adicional */
+typedef struct {
+    st77xx_panel_model_t model;
+    uint16_t width;                 // En la orientación configurada
+    uint16_t height;
+    uint16_t x_offset;              // Desplazamiento en la GRAM del controlador
+    uint16_t y_offset;
+    bool invert;                    // INVON (paneles IPS)
+    st77xx_orientation_t orientation;
+    int pin_cs;
+    int pin_dc;
+    int pin_rst;                    // -1 = compartido o sin conectar
+    int pin_bl;                     // -1 = sin control de backlight
+    uint32_t spi_speed_hz;          // 0 = ST77XX_SPI_SPEED_HZ
+} st77xx_panel_config_t;
+
+/**
+ * @brief Añade un panel al bus y ejecuta su secuencia de inicialización
+ *
+ * Requiere st77xx_init(). La primera llamada crea la tarea del bus.
+ *
+ * @param config Pines, modelo y geometría
+ * @param[out] out Handle del panel
+ * @return ESP_OK, ESP_ERR_INVALID_STATE sin driver o con bus i80,
+ *         ESP_ERR_NO_MEM, o el error del bus SPI
+ */
+esp_err_t st77xx_panel_create(const st77xx_panel_config_t* config, st77xx_handle_t* out);
+
+/**
+ * @brief Espera al flush en curso, quita el panel del bus y libera el handle
+ */
+void st77xx_panel_delete(st77xx_handle_t panel);
+
+/**
+ * @brief Envía un frame completo (asíncrono)
+ * @param fb width x height píxeles RGB565 nativos; debe seguir vivo hasta
+ *           st77xx_panel_wait()
+ */
+void st77xx_panel_flush(st77xx_handle_t panel, const uint16_t* fb);
+
+/**
+ * @brief Envía una región de un framebuffer del tamaño del panel (asíncrono)
+ */
+void st77xx_panel_flush_rect(st77xx_handle_t panel, const uint16_t* fb,
+                             int32_t x, int32_t y, int32_t w, int32_t h);
+
+/**
+ * @brief Rellena una región directamente en el panel (asíncrono)
+ */
+void st77xx_panel_fill_rect(st77xx_handle_t panel, int32_t x, int32_t y,
+                            int32_t w, int32_t h, uint16_t color);
+
+/**
+ * @brief Espera a que termine el flush en curso del panel
+ */
+void st77xx_panel_wait(st77xx_handle_t panel);
+
+/**
+ * @brief Cambia la orientación (MADCTL); espera al flush en curso
+ *
+ * Al pasar entre vertical y horizontal se intercambian el ancho y el alto
+ * del panel, y también sus offsets en la GRAM.
+ */
+void st77xx_panel_set_orientation(st77xx_handle_t panel, st77xx_orientation_t orientation);
+
+/**
+ * @brief Enciende o apaga el backlight por GPIO
+ */
+void st77xx_panel_backlight(st77xx_handle_t panel, bool on);
+
+#endif // ST77XX_PANEL_H
@@ -0,0 +1,96 @@
+/**
+ * @file st77xx_scale.h
+ * @brief Blit escalado RGB565: cover, contain y stretch
+ *
+ * La geometría se calcula una vez con st77xx_scaler_init(): caja de la
+ * imagen en pantalla y la tabla de columnas de origen (posición Q16 de cada
+ * columna: índice y fracción). Dibujar una fila solo cuesta una búsqueda en
+ * la tabla por píxel, sin divisiones ni coma flotante.
+ *
+ * Cuando la imagen escalada mide exactamente 1x, 2x o 4x el origen (lo
+ * habitual al decodificar el JPEG a 1/2, 1/4 o 1/8 para una pantalla de
+ * ese tamaño) se usan rutas directas de copia o duplicado de píxeles.
+ * Opcionalmente se filtra con bilineal en RGB565 (pesos de 5 bits).
+ *
+ * El mismo escalador sirve para un framebuffer completo
+ * (st77xx_blit_scaled()) y franja a franja (st77xx_stripe_blit_scaled()).
+ */
+
+#ifndef ST77XX_SCALE_H
+#define ST77XX_SCALE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "st77xx.h"
+
+/** @brief Ajuste de la imagen al área de destino */
+typedef enum {
+    ST77XX_FIT_COVER = 0,   // Llena el área, recorta lo que sobra
+    ST77XX_FIT_CONTAIN,     // Cabe entera, bandas con el color de fondo
+    ST77XX_FIT_STRETCH,     // Ocupa el área deformando el aspecto
+} st77xx_fit_t;
+
+/**
+ * @brief Filtro de muestreo
+ *
+ * El bilineal mezcla canales: necesita RGB565 nativo (no el orden del panel).
+ */
+typedef enum {
+    ST77XX_FILTER_NEAREST = 0,
+    ST77XX_FILTER_BILINEAR,
+} st77xx_filter_t;
+
+/**
+ * @brief Geometría precalculada de un blit escalado
+ *
+ * Cabe en memoria estática (~1.5 KB): las tablas tienen una entrada por
+ * columna de pantalla. Rellenar con st77xx_scaler_init().
+ */
+typedef struct {
+    const uint16_t* src;
+    int32_t src_w, src_h, src_stride;
+    int32_t area_x, area_y, area_w, area_h;     // Área de destino (recortada a pantalla)
+    int32_t img_x, img_y, img_w, img_h;         // Imagen escalada (puede exceder el área)
+    int32_t vis_x0, vis_x1, vis_y0, vis_y1;     // Parte visible de la imagen
+    int ratio;                                  // 1, 2 o 4 si es escala entera exacta; 0 si no
+    st77xx_filter_t filter;
+    uint16_t background;                        // Color de las bandas en contain
+    uint16_t col[ST77XX_WIDTH];                 // Columna de origen de cada columna visible
+    uint8_t col_frac[ST77XX_WIDTH];             // Peso 0..32 de la columna siguiente (bilineal)
+} st77xx_scaler_t;
+
+/**
+ * @brief Calcula la geometría de un blit escalado
+ *
+ * @param s Escalador a rellenar
+ * @param src Imagen de origen (RGB565, mismo orden de bytes que el destino)
+ * @param src_w, src_h Tamaño del origen
+ * @param src_stride Píxeles entre filas del origen
+ * @param x, y, w, h Área de destino en pantalla
+ * @param fit Ajuste
+ * @param filter Filtro (bilineal se ignora en escalas 1x exactas)
+ * @param background Color de las bandas en ST77XX_FIT_CONTAIN
+ * @return false si los parámetros no son válidos (tamaños hasta 65535)
+ *         o el área queda fuera de pantalla
+ */
+bool st77xx_scaler_init(st77xx_scaler_t* s, const uint16_t* src, int32_t src_w, int32_t src_h,
+                        int32_t src_stride, int32_t x, int32_t y, int32_t w, int32_t h,
+                        st77xx_fit_t fit, st77xx_filter_t filter, uint16_t background);
+
+/**
+ * @brief Dibuja la imagen escalada en un framebuffer de pantalla completa
+ *
+ * Marca el área como modificada si @p fb es el buffer de dibujo.
+ */
+void st77xx_blit_scaled(uint16_t* fb, const st77xx_scaler_t* s);
+
+/**
+ * @brief Dibuja las filas [y0, y0 + rows) de la imagen escalada en una franja
+ *
+ * Pensado para callbacks de st77xx_stripe_render(). Solo se escriben las
+ * columnas del área de destino.
+ */
+void st77xx_stripe_blit_scaled(uint16_t* stripe, int32_t y0, int32_t rows,
+                               const st77xx_scaler_t* s);
+
+#endif // ST77XX_SCALE_H
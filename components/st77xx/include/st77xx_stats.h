@@ -0,0 +1,125 @@
+/**
+ * @file st77xx_stats.h
+ * @brief Tiempos por etapa de cada frame y contadores del bus
+ *
+ * Cada etapa (lectura, decodificación, escalado, swap, SPI, ventana,
+ * espera) acumula microsegundos con esp_timer durante un frame;
+ * st77xx_stats_frame_end() cierra el frame y pasa lo acumulado a un
+ * histograma logarítmico por etapa (4 subdivisiones por octava). De ahí
+ * salen mínimo, media, p99 y máximo de la ventana actual, que empieza en
+ * st77xx_stats_reset().
+ *
+ * El driver mide swap, SPI y ventana; la aplicación mide el resto y marca
+ * el fin de cada frame. Si reproduce con deadlines, también cuenta cómo
+ * acabó cada frame respecto a su intervalo: de ahí salen los fps logrados
+ * frente a los del contenido. Con CONFIG_ST77XX_STATS desactivado todas
+ * las funciones de medida son inline vacías.
+ */
+
+#ifndef ST77XX_STATS_H
+#define ST77XX_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#if defined(CONFIG_ST77XX_STATS) && CONFIG_ST77XX_STATS
+    #define ST77XX_USE_STATS 1
+#else
+    #define ST77XX_USE_STATS 0
+#endif
+
+/** @brief Etapas medidas */
+typedef enum {
+    ST77XX_STAGE_FILE_READ = 0,     // Lectura del archivo (SPIFFS)
+    ST77XX_STAGE_DECODE,            // Decodificación JPEG
+    ST77XX_STAGE_SCALE,             // Escalado o copia al framebuffer
+    ST77XX_STAGE_SWAP,              // Swap de bytes RGB565 para el panel
+    ST77XX_STAGE_SPI,               // Bus ocupado con datos de píxel
+    ST77XX_STAGE_WINDOW,            // CASET/RASET/RAMWR
+    ST77XX_STAGE_DELAY,             // Espera entre frames
+    ST77XX_STAGE_FRAME,             // Frame completo (entre dos frame_end)
+    ST77XX_STAGE_COUNT
+} st77xx_stage_t;
+
+/** @brief Resultado de un frame respecto a su deadline */
+typedef enum {
+    ST77XX_PACE_ON_TIME = 0,        // Mostrado antes de que acabara su intervalo
+    ST77XX_PACE_LATE,               // Mostrado con el intervalo ya terminado
+    ST77XX_PACE_DROPPED,            // Descartado por ir con retraso
+} st77xx_pace_t;
+
+/** @brief Resumen de una etapa (tiempos por frame en microsegundos) */
+typedef struct {
+    uint32_t frames;        // Frames en los que se midió la etapa
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;        // Límite superior del bucket del percentil 99
+    uint32_t max_us;
+} st77xx_stage_stats_t;
+
+/** @brief Estadísticas de la ventana actual */
+typedef struct {
+    st77xx_stage_stats_t stage[ST77XX_STAGE_COUNT];
+    uint64_t bus_bytes;             // Bytes enviados al panel (comandos incluidos)
+    uint32_t bus_transactions;
+    uint64_t bus_bytes_total;       // Desde el arranque
+    uint32_t frames_on_time;        // Resultados de st77xx_stats_add_pace()
+    uint32_t frames_late;
+    uint32_t frames_dropped;
+    uint64_t content_us;            // Suma de los intervalos de esos frames
+    int64_t window_us;              // Duración de la ventana
+} st77xx_stats_t;
+
+#if ST77XX_USE_STATS
+
+/** @brief Marca de tiempo para st77xx_stats_end() */
+int64_t st77xx_stats_begin(void);
+
+/** @brief Suma el tiempo transcurrido desde @p t0 a la etapa en el frame actual */
+void st77xx_stats_end(st77xx_stage_t stage, int64_t t0);
+
+/** @brief Suma @p us a la etapa en el frame actual */
+void st77xx_stats_add(st77xx_stage_t stage, uint32_t us);
+
+/** @brief Cuenta una transacción de @p bytes hacia el panel */
+void st77xx_stats_add_bus(size_t bytes);
+
+/**
+ * @brief Cuenta un frame de una reproducción con deadlines
+ * @param result Cómo acabó respecto a su intervalo
+ * @param delay_us Duración del intervalo según el contenido
+ */
+void st77xx_stats_add_pace(st77xx_pace_t result, uint32_t delay_us);
+
+/**
+ * @brief Cierra el frame: las etapas medidas pasan a sus histogramas
+ *
+ * También mide ST77XX_STAGE_FRAME como el tiempo desde la llamada anterior.
+ */
+void st77xx_stats_frame_end(void);
+
+/** @brief Copia las estadísticas de la ventana actual */
+void st77xx_get_stats(st77xx_stats_t* out);
+
+/** @brief Empieza una ventana nueva */
+void st77xx_stats_reset(void);
+
+/** @brief Muestra en el log una línea por etapa medida, el uso del bus y el ritmo */
+void st77xx_stats_log(void);
+
+#else
+
+static inline int64_t st77xx_stats_begin(void) { return 0; }
+static inline void st77xx_stats_end(st77xx_stage_t stage, int64_t t0) { (void)stage; (void)t0; }
+static inline void st77xx_stats_add(st77xx_stage_t stage, uint32_t us) { (void)stage; (void)us; }
+static inline void st77xx_stats_add_bus(size_t bytes) { (void)bytes; }
+static inline void st77xx_stats_add_pace(st77xx_pace_t result, uint32_t delay_us) { (void)result; (void)delay_us; }
+static inline void st77xx_stats_frame_end(void) {}
+static inline void st77xx_get_stats(st77xx_stats_t* out) { if (out) *out = (st77xx_stats_t){0}; }
+static inline void st77xx_stats_reset(void) {}
+static inline void st77xx_stats_log(void) {}
+
+#endif
+
+#endif // ST77XX_STATS_H
@@ -0,0 +1,133 @@
+/**
+ * @file st77xx_transport.h
+ * @brief Capa de transporte entre el driver y el bus del panel
+ *
+ * El driver solo ve comandos, parámetros y transferencias de datos de
+ * píxel encoladas; cada backend decide cómo llegan al panel. El SPI de 4
+ * hilos controla DC por GPIO; el i80 paralelo usa esp_lcd y el periférico
+ * LCD gestiona DC y WR. El backend se elige con CONFIG_ST77XX_BUS.
+ *
+ * Contrato común:
+ * - tx_cmd() y tx_param() son síncronos y solo se llaman con el bus vacío.
+ * - queue_ctrl() encola comandos y parámetros cortos en la misma cola que
+ *   los píxeles, así que la ventana y sus datos salen sin esperas entre
+ *   ellos. Es opcional: sin él el driver usa tx_cmd() y tx_param().
+ * - queue() encola datos de píxel ya en el orden de bytes del panel; el
+ *   buffer debe ser accesible por DMA y seguir vivo hasta que wait_one()
+ *   devuelva su trabajo.
+ * - Nunca hay más de ST77XX_BUS_QUEUE_SIZE trabajos en vuelo, y wait_one()
+ *   los devuelve en el orden en que se encolaron.
+ */
+
+#ifndef ST77XX_TRANSPORT_H
+#define ST77XX_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "st77xx.h"
+
+/** @brief Bytes como máximo por transacción de control encolada */
+#define ST77XX_BUS_CTRL_MAX 4
+
+/** @brief Transferencia de datos encolada */
+typedef struct {
+    volatile bool pending;
+    volatile int64_t done_us;       // Fin de la transferencia (solo con estadísticas)
+} st77xx_bus_job_t;
+
+/** @brief Operaciones de un backend de bus */
+typedef struct {
+    const char* name;
+
+    /** @brief Reloj actual del bus (SCLK o WR) */
+    uint32_t (*get_clock)(void);
+
+    /** @brief Configura pines, periférico y DMA para transferencias de ST77XX_DMA_BUFFER_SIZE */
+    esp_err_t (*init)(void);
+    void (*deinit)(void);
+
+    /** @brief Envía un byte de comando */
+    void (*tx_cmd)(uint8_t cmd);
+
+    /** @brief Envía parámetros del último comando */
+    void (*tx_param)(const uint8_t* data, size_t size);
+
+    /** @brief Encola @p size bytes de píxel (como máximo ST77XX_DMA_BUFFER_SIZE) */
+    esp_err_t (*queue)(st77xx_bus_job_t* job, const void* data, size_t size);
+
+    /**
+     * @brief Encola un comando (dc = false) o sus parámetros (dc = true)
+     *
+     * Copia los @p size bytes (1 a ST77XX_BUS_CTRL_MAX): pueden ser locales.
+     * Cuenta como un trabajo en vuelo igual que queue(). NULL si el backend
+     * no lo soporta.
+     */
+    esp_err_t (*queue_ctrl)(st77xx_bus_job_t* job, bool dc, const uint8_t* data, size_t size);
+
+    /** @brief Espera a la transferencia encolada más antigua; NULL si falla */
+    st77xx_bus_job_t* (*wait_one)(void);
+
+    /**
+     * @brief Cambia el reloj del bus; solo con el bus vacío. NULL si es fijo
+     */
+    esp_err_t (*set_clock)(uint32_t hz);
+
+    /**
+     * @brief Envía @p cmd y lee @p size bytes sin soltar CS; NULL sin lectura
+     * @param data Buffer accesible por DMA
+     */
+    esp_err_t (*rx_param)(uint8_t cmd, uint8_t* data, size_t size);
+} st77xx_transport_t;
+
+extern const st77xx_transport_t st77xx_transport_spi;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Arbitraje del bus SPI compartido
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/** @brief Usuarios del bus: cada uno encola desde su propia tarea */
+#define ST77XX_BUS_USER_MAIN   (1u << 0)    // API de st77xx.h
+#define ST77XX_BUS_USER_PANELS (1u << 1)    // Tarea de st77xx_panel.h
+
+/**
+ * @brief Marca si @p user tiene transferencias en vuelo o trabajo pendiente
+ */
+void st77xx_bus_set_active(uint32_t user, bool active);
+
+/**
+ * @brief Transferencias que @p user puede tener en vuelo
+ *
+ * Con otro usuario activo el límite es 1: al terminar cada transferencia
+ * el bus pasa al otro usuario, que ya tiene la suya encolada.
+ */
+int st77xx_bus_queue_limit(uint32_t user);
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Calibración del reloj SPI
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Prueba el reloj guardado en NVS o busca el más rápido fiable
+ *
+ * Solo con el bus vacío y sin ventana abierta. Escribe en la primera fila
+ * de la pantalla y la deja en negro.
+ *
+ * @param force true = ignora el valor guardado
+ * @return Reloj aplicado en Hz, 0 si MISO no responde o ningún candidato
+ *         es fiable (reloj sin cambios, nada guardado)
+ */
+uint32_t st77xx_spi_tune_run(bool force);
+
+/** @brief Borra el reloj guardado en NVS */
+void st77xx_spi_tune_forget(void);
+
+#if ST77XX_BUS_I80
+extern const st77xx_transport_t st77xx_transport_i80;
+    #define ST77XX_TRANSPORT st77xx_transport_i80
+#else
+    #define ST77XX_TRANSPORT st77xx_transport_spi
+#endif
+
+#endif // ST77XX_TRANSPORT_H
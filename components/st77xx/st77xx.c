@@ -4,14 +4,21 @@
  */
 
 #include "st77xx.h"
-#include "driver/spi_master.h"
+#include "st77xx_kernels.h"
+#include "st77xx_stats.h"
+#include "st77xx_transport.h"
+#include "st77xx_init_seq.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
 #include "esp_spiffs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "esp_system.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -21,45 +28,149 @@
 
 static const char* TAG = "ST77XX";
 
-#define CMD_MODE  0
-#define DATA_MODE 1
-
-/** @brief Comandos del controlador ST77xx */
+/** @brief Comandos del controlador ST77xx (los de init, en st77xx_init_seq.c) */
 #define CMD_NOP         0x00
-#define CMD_SWRESET     0x01
-#define CMD_SLPOUT      0x11
 #define CMD_NORON       0x13
-#define CMD_INVOFF      0x20
-#define CMD_INVON       0x21
-#define CMD_DISPON      0x29
 #define CMD_CASET       0x2A
 #define CMD_RASET       0x2B
 #define CMD_RAMWR       0x2C
-#define CMD_COLMOD      0x3A
+#define CMD_VSCRDEF     0x33
+#define CMD_TEON        0x35
 #define CMD_MADCTL      0x36
-#define CMD_PORCTRL     0xB2
-#define CMD_GCTRL       0xB7
-#define CMD_VCOMS       0xBB
+#define CMD_VSCSAD      0x37
+#define CMD_STE         0x44
+
+/** @brief Bits de MADCTL */
+#define MADCTL_MY       0x80
+#define MADCTL_MV       0x20
+
+/** @brief Transacción de control ya codificada: un comando o sus parámetros */
+typedef struct {
+    bool dc;                            // false = comando, true = parámetros
+    uint8_t size;
+    uint8_t data[ST77XX_BUS_CTRL_MAX];
+} bus_ctrl_t;
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * Variables estáticas
  * ═══════════════════════════════════════════════════════════════════════════ */
 
-static spi_device_handle_t spi_handle = NULL;
-static uint8_t* dma_buffer = NULL;
+/** @brief Backend del bus elegido en Kconfig */
+static const st77xx_transport_t* const transport = &ST77XX_TRANSPORT;
+
+static uint8_t* dma_buffers[ST77XX_DMA_BUFFER_COUNT] = {0};
+static st77xx_bus_job_t dma_jobs[ST77XX_DMA_BUFFER_COUNT];
+static st77xx_bus_job_t raw_jobs[ST77XX_BUS_QUEUE_SIZE];
+static int raw_next = 0;
+static st77xx_bus_job_t ctrl_jobs[ST77XX_BUS_QUEUE_SIZE];
+static int ctrl_next = 0;
+static uint8_t* stage_buf = NULL;
+static size_t stage_used = 0;
 static size_t dma_buffer_size = 0;
+static int dma_buffer_count = 0;
+static int dma_next = 0;
+static int bus_pending = 0;
+#if ST77XX_USE_STATS
+static int64_t bus_busy_since = 0;              // Inicio de la ráfaga DMA en curso
+#endif
 static bool window_set = false;
+static uint8_t madctl_current = 0;
 static bool backlight_initialized = false;
 static bool driver_initialized = false;
+static TaskHandle_t init_task = NULL;
+static SemaphoreHandle_t init_done = NULL;
+static const uint16_t* init_splash = NULL;
+
+/** @brief Zona de scroll en líneas de gate (TFA + VSA + BFA = ST77XX_GRAM_LINES) */
+static bool scroll_on = false;
+static uint16_t scroll_fixed_left = 0;     // Columnas pedidas en st77xx_scroll_setup()
+static uint16_t scroll_fixed_right = 0;
+static int32_t scroll_tfa = 0;
+static int32_t scroll_vsa = 0;
+static int32_t scroll_pos = 0;             // VSCSAD - TFA
+static bool scroll_flip = false;           // MY: la columna 0 es la última línea
 
 static uint16_t* fb_front = NULL;
 static uint16_t* fb_back = NULL;
 
+static st77xx_present_mode_t present_mode = ST77XX_PRESENT_FULL;
+static st77xx_rect_t dirty_rects[ST77XX_DIRTY_MAX_RECTS];
+static int dirty_count = 0;
+static bool present_full_pending = false;
+
+static st77xx_diff_config_t diff_cfg = {
+    .band_rows = ST77XX_DIFF_BAND_ROWS,
+    .window_cost_px = ST77XX_WINDOW_COST_PX
+};
+static st77xx_diff_stats_t diff_stats = {0};
+
 static uint16_t* stripe_buffer = NULL;
 static int current_stripe = 0;
+static uint16_t* stripe_ring[ST77XX_STRIPE_BUFFERS] = {0};
+static st77xx_bus_job_t stripe_jobs[ST77XX_STRIPE_BUFFERS];
+static int stripe_ring_count = 0;
+static int stripe_ring_next = 0;
+static bool stripe_frame_open = false;
+static int32_t stripe_height_req = ST77XX_STRIPE_HEIGHT;
+static int32_t stripe_height = 0;
+static int stripe_count = 0;
 
 static uint8_t** preloaded_frames = NULL;
 static int preloaded_count = 0;
+static int preload_total = 0;             // Incluye los servidos por la caché
+static char preload_dir[64] = {0};
+static const uint16_t* preload_demand = NULL;
+
+/** @brief Slot del anillo de prefetch */
+typedef struct {
+    uint8_t* data;
+    int frame;                          // Frame que contiene, -1 = libre
+    st77xx_prefetch_state_t state;      // PENDING mientras se lee
+} prefetch_slot_t;
+
+static prefetch_slot_t prefetch_slots[ST77XX_PREFETCH_SLOTS];
+static int prefetch_slot_count = 0;
+static char prefetch_dir[64] = {0};
+static int prefetch_max = 0;
+static volatile int prefetch_total = -1;     // -1 hasta encontrar el final
+static volatile int prefetch_wanted = -1;    // Frame pedido que no está en el anillo
+static volatile bool prefetch_stop_req = false;
+static TaskHandle_t prefetch_task = NULL;
+static SemaphoreHandle_t prefetch_space = NULL;   // Se liberó un slot
+static SemaphoreHandle_t prefetch_filled = NULL;  // Un slot terminó de leerse
+static SemaphoreHandle_t prefetch_done = NULL;    // La tarea terminó
+static portMUX_TYPE prefetch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Entrada de la caché de frames decodificados */
+typedef struct {
+    uint32_t key;           // 0 = libre
+    uint16_t* data;
+    size_t size;
+    uint32_t last_use;
+    uint16_t pins;
+} cache_entry_t;
+
+static cache_entry_t cache_entries[ST77XX_FRAME_CACHE_ENTRIES];
+static size_t cache_budget = ST77XX_FRAME_CACHE_BUDGET;
+static st77xx_cache_stats_t cache_stats = {0};
+static uint32_t cache_clock = 0;
+static SemaphoreHandle_t cache_mutex = NULL;
+static portMUX_TYPE cache_init_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t flush_task = NULL;
+static SemaphoreHandle_t flush_idle = NULL;
+static const uint16_t* volatile flush_job_fb = NULL;
+static volatile bool flush_job_raw = false;
+
+#if ST77XX_PIN_TE >= 0
+static SemaphoreHandle_t te_sem = NULL;
+static volatile uint32_t te_count = 0;          // Pulsos TE desde el arranque
+static volatile int64_t te_last_us = 0;
+static volatile uint32_t te_period_us = 0;      // Media móvil del período
+static uint32_t te_presented = 0;               // Pulso en el que arrancó el último present
+static uint8_t te_interval = 1;
+static bool te_sync = false;
+#endif
 
 /** @brief Mapeo Unicode -> índice de glifo en la fuente */
 static const uint32_t font_char_map[] = {
@@ -73,33 +184,121 @@ static const uint32_t font_char_map[] = {
 };
 static const int font_char_map_count = sizeof(font_char_map) / sizeof(font_char_map[0]);
 
+/** @brief Destino de texto: framebuffer completo o franja (filas y0..y0+rows) */
+typedef struct {
+    uint16_t* buf;          // Fila y0 del destino, ancho ST77XX_WIDTH
+    int32_t y0;
+    int32_t rows;
+} text_target_t;
+
+static uint8_t glyph_lut[256];          // Codepoint Latin-1 -> índice + 1 (0 = sin glifo)
+static uint8_t glyph_runs[256][5];      // Por byte de fila: nº de tramos, (inicio << 4) | largo
+static int font_char_map_wide = 0;      // Primera entrada del mapa fuera de Latin-1
+static bool text_tables_ready = false;
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Prototipos privados
  * ═══════════════════════════════════════════════════════════════════════════ */
 
 static void gpio_init_pins(void);
-static void spi_init_bus(void);
-static void display_reset(void);
+static void bus_init(void);
+static void init_sequence(const uint16_t* splash);
+static void init_tx(void* ctx, uint8_t cmd, const uint8_t* data, size_t size);
 static void send_cmd(uint8_t cmd);
 static void send_data(const uint8_t* data, size_t size);
 static void send_word(uint16_t data);
-static void send_data_dma(const uint8_t* data, size_t size);
+static void send_ctrl(const bus_ctrl_t* seq, int count);
+static void send_ramwr(void);
+static void send_data_dma(const uint8_t* data, size_t size, bool swap);
+static void send_data_raw(const uint8_t* data, size_t size);
+static void stage_push(const uint8_t* data, size_t size, bool swap);
+static void stage_commit(void);
+static void send_rect(const uint16_t* fb, const st77xx_rect_t* r);
+static bool clip_rect(int32_t x, int32_t y, int32_t w, int32_t h, st77xx_rect_t* out);
+static inline uint32_t rect_area(const st77xx_rect_t* r);
+static void damage_add(const uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h);
+static void rect_list_add(st77xx_rect_t* list, int* count, int max, st77xx_rect_t r);
+static int diff_collect(const uint16_t* prev, const uint16_t* next,
+                        st77xx_rect_t* rects, int max_rects);
+static void fill_rect_raw(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+static void bus_queue(st77xx_bus_job_t* job, const void* data, size_t size);
+static void bus_queue_ctrl(const bus_ctrl_t* ctrl);
+static void bus_wait_one(void);
+static void bus_drain(void);
+static void transport_fence(void);
+static void flush_frame(const uint16_t* frame_buffer, bool raw);
+static bool scroll_apply(void);
+static int32_t scroll_gram_col(int32_t x);
+static void te_init(void);
+static void te_deinit(void);
+static void te_wait_present(void);
+static bool flush_task_start(void);
+static void flush_async_start(const uint16_t* frame_buffer, bool raw);
 static void init_backlight_once(void);
+static int32_t stripe_pick_height(void);
+static inline size_t stripe_bytes(int32_t rows);
+static void stripe_wait_idle(const uint16_t* buf);
 static int find_char_index(uint32_t code);
 static uint32_t utf8_next_codepoint(const char** p);
-static void draw_glyph(uint16_t* fb, int32_t x, int32_t y, int index, 
-                       uint16_t color, uint8_t scale, const uint8_t* font);
+static void draw_text(const text_target_t* t, const char* text, int32_t x, int32_t y,
+                      uint16_t color, uint8_t scale, const uint8_t* font);
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * Inicialización
  * ═══════════════════════════════════════════════════════════════════════════ */
 
 void st77xx_init(void) {
+    if (init_done) {
+        st77xx_init_wait(UINT32_MAX);
+        return;
+    }
     if (driver_initialized) {
         ESP_LOGW(TAG, "Driver ya inicializado");
         return;
     }
+    init_sequence(NULL);
+}
+
+static void init_task_main(void* arg) {
+    (void)arg;
+    init_sequence(init_splash);
+    init_task = NULL;
+    xSemaphoreGive(init_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t st77xx_init_async(const uint16_t* splash) {
+    if (driver_initialized || init_done) return ESP_ERR_INVALID_STATE;
+    
+    init_done = xSemaphoreCreateBinary();
+    if (!init_done) return ESP_ERR_NO_MEM;
+    init_splash = splash;
+    if (xTaskCreatePinnedToCore(init_task_main, "st77xx_init", ST77XX_INIT_TASK_STACK,
+                                NULL, ST77XX_FLUSH_TASK_PRIO, &init_task,
+                                ST77XX_FLUSH_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Fallo al crear tarea de init");
+        vSemaphoreDelete(init_done);
+        init_done = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool st77xx_init_wait(uint32_t timeout_ms) {
+    if (!init_done) return driver_initialized;
     
+    TickType_t ticks = (timeout_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xSemaphoreTake(init_done, ticks) != pdTRUE) return false;
+    vSemaphoreDelete(init_done);
+    init_done = NULL;
+    init_splash = NULL;
+    return driver_initialized;
+}
+
+/**
+ * @brief Secuencia de init con las esperas mínimas, síncrona o en init_task
+ */
+static void init_sequence(const uint16_t* splash) {
     ESP_LOGI(TAG, "╔══════════════════════════════════════════════╗");
     ESP_LOGI(TAG, "║  ST77XX Driver - Detección automática        ║");
     ESP_LOGI(TAG, "╠══════════════════════════════════════════════╣");
@@ -107,65 +306,50 @@ void st77xx_init(void) {
     ESP_LOGI(TAG, "║  PSRAM: %-19s              ║", ST77XX_HAS_PSRAM ? "Disponible" : "No disponible");
     ESP_LOGI(TAG, "║  Display: %-17s              ║", ST77XX_CONTROLLER_NAME);
     ESP_LOGI(TAG, "║  Resolución: %dx%-22d  ║", ST77XX_WIDTH, ST77XX_HEIGHT);
-    ESP_LOGI(TAG, "║  SPI: %lu MHz                              ║", (unsigned long)(ST77XX_SPI_SPEED_HZ / 1000000));
+    ESP_LOGI(TAG, "║  Bus: %-4s %3lu MHz                         ║", transport->name,
+             (unsigned long)(transport->get_clock() / 1000000));
     ESP_LOGI(TAG, "╚══════════════════════════════════════════════╝");
     
+    int64_t t_start = esp_timer_get_time();
     gpio_init_pins();
-    spi_init_bus();
-    display_reset();
-    
-    // Secuencia de inicialización común ST77xx
-    ESP_LOGD(TAG, "Enviando SLPOUT...");
-    send_cmd(CMD_SLPOUT);
-    vTaskDelay(pdMS_TO_TICKS(120));  // Datasheet: mínimo 120ms
-    
-    // Color mode: 16-bit RGB565
-    ESP_LOGD(TAG, "Configurando modo color 16-bit...");
-    send_cmd(CMD_COLMOD);
-    send_data((uint8_t[]){0x55}, 1);
-    
-    // Orientación por defecto
-    st77xx_set_orientation(ST77XX_LANDSCAPE_INV);
-    
-    // Porch Control
-    send_cmd(CMD_PORCTRL);
-    send_data((uint8_t[]){0x0C, 0x0C, 0x00, 0x33, 0x33}, 5);
-    
-    // Gate Control
-    send_cmd(CMD_GCTRL);
-#if defined(ST77XX_MODEL_ST7789)
-    send_data((uint8_t[]){0x75}, 1);  // ST7789
-#else
-    send_data((uint8_t[]){0x35}, 1);  // ST7796S
-#endif
+    bus_init();
+    
+    // Reset, SLPOUT y configuración: la misma tabla que los paneles adicionales
+    const st77xx_init_target_t target = {
+        .tx = init_tx,
+        .model = ST77XX_INIT_MODEL,
+        .orientation = ST77XX_LANDSCAPE_INV,
+        .invert = ST77XX_USE_INVERSION,
+        .pin_rst = ST77XX_PIN_RST,
+    };
+    int64_t t_slpout = st77xx_init_seq_begin(&target);
+    madctl_current = st77xx_init_models[ST77XX_INIT_MODEL].madctl[ST77XX_LANDSCAPE_INV];
+    window_set = false;
     
-    // VCOMS
-    send_cmd(CMD_VCOMS);
-#if defined(ST77XX_MODEL_ST7789)
-    send_data((uint8_t[]){0x2B}, 1);  // ST7789
-#else
-    send_data((uint8_t[]){0x1A}, 1);  // ST7796S
+#if ST77XX_SPI_AUTOTUNE
+    // Con el display apagado: los patrones de prueba no se ven
+    st77xx_spi_tune_run(false);
 #endif
     
-    // Inversión según modelo
-#if ST77XX_USE_INVERSION
-    send_cmd(CMD_INVON);
-    ESP_LOGD(TAG, "Inversión: ON");
-#else
-    send_cmd(CMD_INVOFF);
-    ESP_LOGD(TAG, "Inversión: OFF");
-#endif
+    // Splash en la GRAM antes de DISPON: el primer frame visible ya es la imagen
+    if (splash) {
+        st77xx_set_window(0, 0, ST77XX_WIDTH - 1, ST77XX_HEIGHT - 1);
+        window_set = true;
+        send_data_raw((const uint8_t*)splash, ST77XX_FB_SIZE);
+    }
+    
+    // La configuración y el splash ya cubren parte de la espera tras SLPOUT
+    st77xx_init_seq_display_on(&target, t_slpout);
     
-    // Normal mode y display on
-    send_cmd(CMD_NORON);
-    send_cmd(CMD_DISPON);
-    vTaskDelay(pdMS_TO_TICKS(120));
+    // Tearing effect: pulso TE para sincronizar los flush
+    te_init();
     
     // Backlight al máximo
     st77xx_backlight(255);
     
     driver_initialized = true;
-    ESP_LOGI(TAG, "✅ Inicialización completada");
+    ESP_LOGI(TAG, "✅ Inicialización completada en %lu ms",
+             (unsigned long)((esp_timer_get_time() - t_start) / 1000));
 }
 
 void st77xx_init_fast(void) {
@@ -178,24 +362,56 @@ st77xx_info_t st77xx_get_info(void) {
         .controller_name = ST77XX_CONTROLLER_NAME,
         .width = ST77XX_WIDTH,
         .height = ST77XX_HEIGHT,
-        .spi_speed_hz = ST77XX_SPI_SPEED_HZ,
+        .spi_speed_hz = ST77XX_BUS_I80 ? 0 : transport->get_clock(),
+        .bus_name = transport->name,
+        .bus_clock_hz = transport->get_clock(),
         .psram_enabled = ST77XX_USE_PSRAM,
         .initialized = driver_initialized
     };
     return info;
 }
 
+uint32_t st77xx_spi_autotune(bool force) {
+#if ST77XX_SPI_AUTOTUNE
+    if (!driver_initialized) return 0;
+    transport_fence();
+    bus_drain();
+    uint32_t hz = st77xx_spi_tune_run(force);
+    window_set = false;
+    return hz;
+#else
+    (void)force;
+    return 0;
+#endif
+}
+
+void st77xx_spi_autotune_forget(void) {
+#if ST77XX_SPI_AUTOTUNE
+    st77xx_spi_tune_forget();
+#endif
+}
+
 void st77xx_cleanup(void) {
+    st77xx_flush_wait();
+    bus_drain();
     st77xx_cleanup_double_buffers();
+    st77xx_prefetch_stop();
     st77xx_free_preloaded_frames();
+    te_deinit();
     
-    if (dma_buffer) {
-        heap_caps_free(dma_buffer);
-        dma_buffer = NULL;
-        dma_buffer_size = 0;
+    for (int i = 0; i < ST77XX_DMA_BUFFER_COUNT; i++) {
+        if (dma_buffers[i]) {
+            heap_caps_free(dma_buffers[i]);
+            dma_buffers[i] = NULL;
+        }
     }
+    dma_buffer_size = 0;
+    dma_buffer_count = 0;
+    dma_next = 0;
+    transport->deinit();
     
     window_set = false;
+    scroll_on = false;
     driver_initialized = false;
     ESP_LOGI(TAG, "Recursos liberados");
 }
@@ -259,49 +475,144 @@ void st77xx_load_font(uint8_t* font_data) {
 
 void st77xx_flush(const uint16_t* frame_buffer) {
     if (!frame_buffer) return;
-    
-    if (!window_set) {
-        st77xx_set_window(0, 0, ST77XX_WIDTH - 1, ST77XX_HEIGHT - 1);
-        window_set = true;
-    } else {
-        send_cmd(CMD_RAMWR);
-    }
-    
-    send_data_dma((const uint8_t*)frame_buffer, ST77XX_FB_SIZE);
+    transport_fence();
+    flush_frame(frame_buffer, false);
 }
 
 void st77xx_flush_immediate(const uint16_t* frame_buffer) {
     if (!frame_buffer) return;
-    send_cmd(CMD_RAMWR);
-    send_data_dma((const uint8_t*)frame_buffer, ST77XX_FB_SIZE);
+    send_ramwr();
+    send_data_dma((const uint8_t*)frame_buffer, ST77XX_FB_SIZE, ST77XX_SWAP_BYTES_DMA);
 }
 
-void st77xx_set_orientation(st77xx_orientation_t orientation) {
-    uint8_t madctl = 0;
+void st77xx_flush_async(const uint16_t* frame_buffer) {
+    if (!frame_buffer) return;
+    flush_async_start(frame_buffer, false);
+}
+
+void st77xx_flush_raw(const uint16_t* frame_buffer) {
+    if (!frame_buffer) return;
+    transport_fence();
+    flush_frame(frame_buffer, true);
+}
+
+void st77xx_flush_raw_async(const uint16_t* frame_buffer) {
+    if (!frame_buffer) return;
+    flush_async_start(frame_buffer, true);
+}
+
+void st77xx_flush_rect(const uint16_t* frame_buffer, int32_t x, int32_t y, int32_t w, int32_t h) {
+    st77xx_rect_t r;
+    if (!frame_buffer || !clip_rect(x, y, w, h, &r)) return;
+    send_rect(frame_buffer, &r);
+}
+
+void st77xx_write_rect_raw(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* pixels) {
+    st77xx_rect_t r;
+    if (!pixels || !clip_rect(x, y, w, h, &r)) return;
+    // Los píxeles son contiguos (stride = w): no se puede recortar
+    if (r.x0 != x || r.y0 != y || r.x1 != x + w - 1 || r.y1 != y + h - 1) return;
+    
+    st77xx_set_window(r.x0, r.y0, r.x1, r.y1);
+    window_set = false;
+    send_data_raw((const uint8_t*)pixels, (size_t)w * h * sizeof(uint16_t));
+}
+
+void st77xx_fill_rect_direct(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+    static uint16_t line[ST77XX_WIDTH];
+    st77xx_rect_t r;
+    if (dma_buffer_count == 0 || !clip_rect(x, y, w, h, &r)) return;
+    
+    size_t rw = (size_t)(r.x1 - r.x0 + 1);
+    size_t rh = (size_t)(r.y1 - r.y0 + 1);
+    
+    st77xx_set_window(r.x0, r.y0, r.x1, r.y1);
+    window_set = false;
     
-#if defined(ST77XX_MODEL_ST7789)
-    // ST7789 MADCTL values (con MX=1 para corregir espejo horizontal)
-    switch (orientation) {
-        case ST77XX_PORTRAIT:      madctl = 0x40; break;  // MX
-        case ST77XX_LANDSCAPE:     madctl = 0x20; break;  // MV
-        case ST77XX_PORTRAIT_INV:  madctl = 0x80; break;  // MY
-        case ST77XX_LANDSCAPE_INV: madctl = 0xE0; break;  // MY+MX+MV
-        default:                   madctl = 0x40; break;
+    // stage_push copia la línea: da igual que se reutilice en la siguiente llamada
+    st77xx_kernel_fill(line, color, rw);
+    for (size_t row = 0; row < rh; row++) {
+        stage_push((const uint8_t*)line, rw * sizeof(uint16_t), ST77XX_SWAP_BYTES_DMA);
     }
-#else
-    // ST7796S MADCTL values (con MX para corregir espejo horizontal)
-    switch (orientation) {
-        case ST77XX_PORTRAIT:      madctl = 0x48; break;  // MX + BGR
-        case ST77XX_LANDSCAPE:     madctl = 0x28; break;  // MV + BGR
-        case ST77XX_PORTRAIT_INV:  madctl = 0x88; break;  // MY + BGR
-        case ST77XX_LANDSCAPE_INV: madctl = 0xE8; break;  // MY+MX+MV + BGR
-        default:                   madctl = 0x48; break;
+    stage_commit();
+}
+
+int st77xx_flush_diff(const uint16_t* prev, const uint16_t* next) {
+    if (!next) return 0;
+    if (!prev) {
+        st77xx_flush(next);
+        return 1;
     }
-#endif
+    
+    st77xx_rect_t rects[ST77XX_DIFF_MAX_RECTS];
+    int count = diff_collect(prev, next, rects, ST77XX_DIFF_MAX_RECTS);
+    
+    // Coste estimado frente a enviar el frame completo
+    uint64_t pixels = 0;
+    for (int i = 0; i < count; i++) pixels += rect_area(&rects[i]);
+    uint64_t cost = pixels + (uint64_t)count * diff_cfg.window_cost_px;
+    uint64_t full_cost = (uint64_t)ST77XX_WIDTH * ST77XX_HEIGHT + diff_cfg.window_cost_px;
+    
+    diff_stats.frames++;
+    if (cost >= full_cost) {
+        st77xx_flush(next);
+        count = 1;
+        pixels = (uint64_t)ST77XX_WIDTH * ST77XX_HEIGHT;
+        diff_stats.full_frames++;
+    } else {
+        // Sin cambios también se espera al pulso: mantiene la cadencia
+        te_wait_present();
+        for (int i = 0; i < count; i++) send_rect(next, &rects[i]);
+    }
+    
+    uint32_t sent = (uint32_t)(pixels * sizeof(uint16_t));
+    diff_stats.windows += count;
+    diff_stats.bytes_sent += sent;
+    diff_stats.bytes_saved += ST77XX_FB_SIZE - sent;
+    diff_stats.last_windows = count;
+    diff_stats.last_bytes_sent = sent;
+    return count;
+}
+
+void st77xx_set_diff_config(const st77xx_diff_config_t* config) {
+    if (!config) {
+        diff_cfg.band_rows = ST77XX_DIFF_BAND_ROWS;
+        diff_cfg.window_cost_px = ST77XX_WINDOW_COST_PX;
+        return;
+    }
+    diff_cfg = *config;
+    if (diff_cfg.band_rows == 0) diff_cfg.band_rows = 1;
+}
+
+void st77xx_get_diff_stats(st77xx_diff_stats_t* stats) {
+    if (stats) *stats = diff_stats;
+}
+
+void st77xx_reset_diff_stats(void) {
+    memset(&diff_stats, 0, sizeof(diff_stats));
+}
+
+void st77xx_flush_wait(void) {
+    if (!flush_idle || xTaskGetCurrentTaskHandle() == flush_task) return;
+    xSemaphoreTake(flush_idle, portMAX_DELAY);
+    xSemaphoreGive(flush_idle);
+}
+
+bool st77xx_flush_busy(void) {
+    return flush_idle && uxSemaphoreGetCount(flush_idle) == 0;
+}
+
+void st77xx_set_orientation(st77xx_orientation_t orientation) {
+    // Mismos valores que la secuencia de init
+    uint8_t madctl = st77xx_init_models[ST77XX_INIT_MODEL].madctl[orientation & 3];
     
     send_cmd(CMD_MADCTL);
     send_data(&madctl, 1);
+    madctl_current = madctl;
     window_set = false;  // Reset ventana al cambiar orientación
+    
+    // La zona de scroll depende del sentido de MY: se recalcula
+    if (scroll_on && !scroll_apply()) st77xx_scroll_reset();
 }
 
 void st77xx_backlight(uint8_t duty) {
@@ -317,15 +628,82 @@ void st77xx_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
     if (x1 >= ST77XX_WIDTH) x1 = ST77XX_WIDTH - 1;
     if (y1 >= ST77XX_HEIGHT) y1 = ST77XX_HEIGHT - 1;
     
-    send_cmd(CMD_CASET);
-    send_word(x0 + ST77XX_X_OFFSET);
-    send_word(x1 + ST77XX_X_OFFSET);
-    
-    send_cmd(CMD_RASET);
-    send_word(y0 + ST77XX_Y_OFFSET);
-    send_word(y1 + ST77XX_Y_OFFSET);
+    uint16_t xs = x0 + ST77XX_X_OFFSET, xe = x1 + ST77XX_X_OFFSET;
+    uint16_t ys = y0 + ST77XX_Y_OFFSET, ye = y1 + ST77XX_Y_OFFSET;
+    const bus_ctrl_t seq[] = {
+        { false, 1, { CMD_CASET } },
+        { true,  4, { xs >> 8, xs & 0xFF, xe >> 8, xe & 0xFF } },
+        { false, 1, { CMD_RASET } },
+        { true,  4, { ys >> 8, ys & 0xFF, ye >> 8, ye & 0xFF } },
+        { false, 1, { CMD_RAMWR } }
+    };
     
-    send_cmd(CMD_RAMWR);
+    int64_t t0 = st77xx_stats_begin();
+    send_ctrl(seq, sizeof(seq) / sizeof(seq[0]));
+    st77xx_stats_end(ST77XX_STAGE_WINDOW, t0);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Scroll por hardware
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+bool st77xx_scroll_setup(uint16_t fixed_left, uint16_t fixed_right) {
+    scroll_fixed_left = fixed_left;
+    scroll_fixed_right = fixed_right;
+    if (!scroll_apply()) {
+        ESP_LOGW(TAG, "Scroll no disponible (orientación vertical o zona vacía)");
+        if (scroll_on) st77xx_scroll_reset();
+        return false;
+    }
+    scroll_on = true;
+    return true;
+}
+
+void st77xx_scroll_push(const uint16_t* pixels, int32_t cols) {
+    if (!scroll_on || cols <= 0) return;
+    if (cols > scroll_vsa) cols = scroll_vsa;
+    
+    // Con MY la pantalla avanza hacia líneas de gate mayores
+    scroll_pos = (scroll_pos + (scroll_flip ? scroll_vsa - cols : cols)) % scroll_vsa;
+    uint16_t ssa = (uint16_t)(scroll_tfa + scroll_pos);
+    send_cmd(CMD_VSCSAD);
+    send_word(ssa);
+    
+    if (!pixels || dma_buffer_count == 0) return;
+    
+    // Las columnas nuevas son contiguas en la GRAM salvo donde la zona da la vuelta
+    int32_t x_end = ST77XX_WIDTH - scroll_fixed_right;
+    int32_t j = 0;
+    while (j < cols) {
+        int32_t g0 = scroll_gram_col(x_end - cols + j);
+        int32_t run = 1;
+        while (j + run < cols && scroll_gram_col(x_end - cols + j + run) == g0 + run) run++;
+        
+        st77xx_set_window(g0, 0, g0 + run - 1, ST77XX_HEIGHT - 1);
+        const uint16_t* src = pixels + j;
+        for (int32_t row = 0; row < ST77XX_HEIGHT; row++) {
+            stage_push((const uint8_t*)src, (size_t)run * sizeof(uint16_t), ST77XX_SWAP_BYTES_DMA);
+            src += cols;
+        }
+        stage_commit();
+        j += run;
+    }
+    window_set = false;
+}
+
+int32_t st77xx_scroll_map(int32_t x) {
+    if (!scroll_on) return x;
+    return scroll_gram_col(x);
+}
+
+bool st77xx_scroll_active(void) {
+    return scroll_on;
+}
+
+void st77xx_scroll_reset(void) {
+    scroll_on = false;
+    scroll_pos = 0;
+    send_cmd(CMD_NORON);  // Sale del modo scroll
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -364,12 +742,111 @@ void st77xx_swap_and_display(void) {
     uint16_t* tmp = fb_front;
     fb_front = fb_back;
     fb_back = tmp;
-    st77xx_flush(fb_front);
+    
+    if (present_mode == ST77XX_PRESENT_FULL) {
+        st77xx_flush(fb_front);
+        return;
+    }
+    
+    if (present_mode == ST77XX_PRESENT_DIFF) {
+        // fb_back es ahora el frame que estaba en pantalla
+        if (present_full_pending) {
+            st77xx_flush(fb_front);
+            present_full_pending = false;
+        } else {
+            st77xx_flush_diff(fb_back, fb_front);
+        }
+        return;
+    }
+    
+    // Enviar las regiones dañadas y replicarlas en el nuevo back buffer
+    te_wait_present();
+    for (int i = 0; i < dirty_count; i++) {
+        const st77xx_rect_t* r = &dirty_rects[i];
+        send_rect(fb_front, r);
+        
+        size_t row_bytes = (size_t)(r->x1 - r->x0 + 1) * sizeof(uint16_t);
+        for (int32_t row = r->y0; row <= r->y1; row++) {
+            size_t offset = (size_t)row * ST77XX_WIDTH + r->x0;
+            memcpy(&fb_back[offset], &fb_front[offset], row_bytes);
+        }
+    }
+    dirty_count = 0;
+}
+
+void st77xx_set_present_mode(st77xx_present_mode_t mode) {
+    present_mode = mode;
+    dirty_count = 0;
+    present_full_pending = (mode == ST77XX_PRESENT_DIFF);
+    if (mode == ST77XX_PRESENT_DIRTY) {
+        // Primer swap completo: sincroniza pantalla y ambos buffers
+        dirty_rects[dirty_count++] = (st77xx_rect_t){ 0, 0, ST77XX_WIDTH - 1, ST77XX_HEIGHT - 1 };
+    }
+}
+
+void st77xx_mark_dirty(int32_t x, int32_t y, int32_t w, int32_t h) {
+    damage_add(fb_back, x, y, w, h);
 }
 
 void st77xx_cleanup_double_buffers(void) {
     if (fb_front) { heap_caps_free(fb_front); fb_front = NULL; }
     if (fb_back) { heap_caps_free(fb_back); fb_back = NULL; }
+    dirty_count = 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Sincronización TE
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+bool st77xx_set_te_sync(bool enable) {
+#if ST77XX_PIN_TE >= 0
+    if (!te_sem) return false;
+    if (enable && !te_sync) {
+        // El siguiente present sale con el primer pulso
+        te_presented = te_count;
+    }
+    te_sync = enable;
+    return true;
+#else
+    (void)enable;
+    return false;
+#endif
+}
+
+bool st77xx_te_active(void) {
+#if ST77XX_PIN_TE >= 0
+    return te_sync;
+#else
+    return false;
+#endif
+}
+
+uint32_t st77xx_get_refresh_period_us(void) {
+#if ST77XX_PIN_TE >= 0
+    return te_sem ? te_period_us : 0;
+#else
+    return 0;
+#endif
+}
+
+void st77xx_set_present_interval(uint8_t refreshes) {
+#if ST77XX_PIN_TE >= 0
+    te_interval = refreshes ? refreshes : 1;
+#else
+    (void)refreshes;
+#endif
+}
+
+void st77xx_frame_delay(uint32_t delay_ms) {
+#if ST77XX_PIN_TE >= 0
+    uint32_t period = te_period_us;
+    if (te_sync && period) {
+        uint32_t n = (uint32_t)(((uint64_t)delay_ms * 1000 + period / 2) / period);
+        st77xx_set_present_interval(n > UINT8_MAX ? UINT8_MAX : (uint8_t)n);
+        return;
+    }
+#endif
+    vTaskDelay(pdMS_TO_TICKS(delay_ms));
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -379,87 +856,184 @@ void st77xx_cleanup_double_buffers(void) {
 void st77xx_init_stripe_mode(void) {
     if (stripe_buffer) return;  // Ya inicializado
     
-    stripe_buffer = (uint16_t*)heap_caps_malloc(ST77XX_STRIPE_SIZE, MALLOC_CAP_8BIT | MALLOC_CAP_DMA);
-    if (!stripe_buffer) {
-        ESP_LOGE(TAG, "❌ Error al asignar stripe buffer (%u bytes)", (unsigned)ST77XX_STRIPE_SIZE);
+    // Anillo de franjas; si falta memoria se reduce la altura
+    int32_t rows = stripe_pick_height();
+    while (rows > 0) {
+        size_t size = (size_t)ST77XX_WIDTH * rows * sizeof(uint16_t);
+        stripe_ring_count = 0;
+        for (int i = 0; i < ST77XX_STRIPE_BUFFERS; i++) {
+            stripe_ring[i] = (uint16_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT | MALLOC_CAP_DMA);
+            if (!stripe_ring[i]) break;
+            stripe_jobs[i].pending = false;
+            stripe_ring_count++;
+        }
+        if (stripe_ring_count > 0) break;
+        rows = (rows > ST77XX_STRIPE_ALIGN) ? rows - ST77XX_STRIPE_ALIGN : rows / 2;
+    }
+    
+    if (stripe_ring_count == 0) {
+        ESP_LOGE(TAG, "❌ Error al asignar stripe buffer");
         return;
     }
     
+    stripe_height = rows;
+    stripe_count = (ST77XX_HEIGHT + rows - 1) / rows;
+    stripe_buffer = stripe_ring[0];
+    stripe_ring_next = 0;
+    stripe_frame_open = false;
     current_stripe = 0;
-    ESP_LOGI(TAG, "✅ Stripe mode: %u bytes buffer, %d franjas de %d líneas", 
-             (unsigned)ST77XX_STRIPE_SIZE, ST77XX_STRIPE_COUNT, ST77XX_STRIPE_HEIGHT);
+    ESP_LOGI(TAG, "✅ Stripe mode: %d x %u bytes buffer, %d franjas de %d líneas (última %d)", 
+             stripe_ring_count, (unsigned)stripe_bytes(rows), stripe_count, (int)rows,
+             (int)st77xx_stripe_get_rows(stripe_count - 1));
+}
+
+void st77xx_stripe_set_height(int32_t rows) {
+    if (rows < 0) rows = 0;
+    if (rows > (int32_t)ST77XX_STRIPE_MAX_HEIGHT) rows = ST77XX_STRIPE_MAX_HEIGHT;
+    stripe_height_req = rows;
+    
+    if (stripe_buffer) {
+        st77xx_cleanup_stripe_mode();
+        st77xx_init_stripe_mode();
+    }
+}
+
+int32_t st77xx_stripe_get_height(void) {
+    return stripe_height;
+}
+
+int st77xx_stripe_get_count(void) {
+    return stripe_count;
+}
+
+int32_t st77xx_stripe_get_rows(int index) {
+    if (index < 0 || index >= stripe_count) return 0;
+    int32_t y0 = (int32_t)index * stripe_height;
+    return (y0 + stripe_height > ST77XX_HEIGHT) ? ST77XX_HEIGHT - y0 : stripe_height;
 }
 
 uint16_t* st77xx_stripe_get_buffer(void) {
+    stripe_wait_idle(stripe_buffer);
     return stripe_buffer;
 }
 
 void st77xx_stripe_fill(uint16_t color) {
     if (!stripe_buffer) return;
-    
-    size_t total = (size_t)ST77XX_WIDTH * ST77XX_STRIPE_HEIGHT;
-    uint32_t color32 = ((uint32_t)color << 16) | color;
-    uint32_t* ptr32 = (uint32_t*)stripe_buffer;
-    size_t words = total / 2;
-    
-    while (words >= 8) {
-        *ptr32++ = color32; *ptr32++ = color32;
-        *ptr32++ = color32; *ptr32++ = color32;
-        *ptr32++ = color32; *ptr32++ = color32;
-        *ptr32++ = color32; *ptr32++ = color32;
-        words -= 8;
-    }
-    while (words--) *ptr32++ = color32;
+    stripe_wait_idle(stripe_buffer);
+    st77xx_kernel_fill(stripe_buffer, color, (size_t)ST77XX_WIDTH * stripe_height);
 }
 
 void st77xx_stripe_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
     if (!stripe_buffer) return;
     
     // Clipping a la franja
-    if (x >= ST77XX_WIDTH || y >= ST77XX_STRIPE_HEIGHT) return;
+    if (x >= ST77XX_WIDTH || y >= stripe_height) return;
     if (x < 0) { w += x; x = 0; }
     if (y < 0) { h += y; y = 0; }
     if (x + w > ST77XX_WIDTH) w = ST77XX_WIDTH - x;
-    if (y + h > ST77XX_STRIPE_HEIGHT) h = ST77XX_STRIPE_HEIGHT - y;
+    if (y + h > stripe_height) h = stripe_height - y;
     if (w <= 0 || h <= 0) return;
     
-    for (int32_t row = y; row < y + h; row++) {
-        uint16_t* line = &stripe_buffer[row * ST77XX_WIDTH + x];
-        for (int32_t col = 0; col < w; col++) {
-            line[col] = color;
-        }
-    }
+    stripe_wait_idle(stripe_buffer);
+    st77xx_kernel_fill_rect(&stripe_buffer[y * ST77XX_WIDTH + x], ST77XX_WIDTH, w, h, color);
 }
 
 void st77xx_stripe_begin_frame(void) {
+    // Las franjas del frame anterior pueden seguir en vuelo
+    transport_fence();
+    bus_drain();
+    // Con TE solo marca la cadencia: el render de cada franja va detrás
+    te_wait_present();
     current_stripe = 0;
+    stripe_frame_open = false;
 }
 
 int st77xx_stripe_flush_next(void) {
-    if (!stripe_buffer || current_stripe >= ST77XX_STRIPE_COUNT) {
+    if (!stripe_buffer || current_stripe >= stripe_count) {
         return -1;  // Frame terminado
     }
     
     // Calcular posición Y de esta franja
-    uint16_t y0 = current_stripe * ST77XX_STRIPE_HEIGHT;
-    uint16_t y1 = y0 + ST77XX_STRIPE_HEIGHT - 1;
+    int32_t rows = st77xx_stripe_get_rows(current_stripe);
+    uint16_t y0 = current_stripe * stripe_height;
+    uint16_t y1 = y0 + rows - 1;
     
     // Establecer ventana para esta franja
     st77xx_set_window(0, y0, ST77XX_WIDTH - 1, y1);
-    send_cmd(CMD_RAMWR);
+    window_set = false;
     
     // Enviar datos de la franja
-    send_data_dma((const uint8_t*)stripe_buffer, ST77XX_STRIPE_SIZE);
+    send_data_dma((const uint8_t*)stripe_buffer, stripe_bytes(rows), ST77XX_SWAP_BYTES_DMA);
+    
+    current_stripe++;
+    return (current_stripe < stripe_count) ? current_stripe : -1;
+}
+
+uint16_t* st77xx_stripe_acquire(void) {
+    if (stripe_ring_count == 0 || current_stripe >= stripe_count) return NULL;
+    
+    if (!stripe_frame_open) {
+        // Ventana completa una sola vez; las franjas se envían en continuo
+        transport_fence();
+        st77xx_set_window(0, 0, ST77XX_WIDTH - 1, ST77XX_HEIGHT - 1);
+        window_set = true;
+        stripe_frame_open = true;
+    }
+    
+    // Esperar solo si el DMA aún lee esta franja
+    while (stripe_jobs[stripe_ring_next].pending) bus_wait_one();
+    stripe_buffer = stripe_ring[stripe_ring_next];
+    return stripe_buffer;
+}
+
+void st77xx_stripe_submit(void) {
+    if (!stripe_frame_open || current_stripe >= stripe_count) return;
+    
+    uint16_t* buf = stripe_ring[stripe_ring_next];
+    size_t pixels = (size_t)ST77XX_WIDTH * st77xx_stripe_get_rows(current_stripe);
+    
+#if ST77XX_SWAP_BYTES_DMA
+    // Swap en el propio buffer: no hace falta copiar a un buffer de rebote
+    int64_t t0 = st77xx_stats_begin();
+    st77xx_kernel_swap(buf, buf, pixels);
+    st77xx_stats_end(ST77XX_STAGE_SWAP, t0);
+#endif
+    
+    bus_queue(&stripe_jobs[stripe_ring_next], buf, pixels * sizeof(uint16_t));
+    stripe_ring_next = (stripe_ring_next + 1) % stripe_ring_count;
     
     current_stripe++;
-    return (current_stripe < ST77XX_STRIPE_COUNT) ? current_stripe : -1;
+    if (current_stripe >= stripe_count) stripe_frame_open = false;
+}
+
+bool st77xx_stripe_render(st77xx_stripe_render_cb_t cb, void* ctx) {
+    if (!cb || stripe_ring_count == 0) return false;
+    
+    st77xx_stripe_begin_frame();
+    for (int i = 0; i < stripe_count; i++) {
+        uint16_t* buf = st77xx_stripe_acquire();
+        if (!buf) return false;
+        cb(buf, i, (int32_t)i * stripe_height, st77xx_stripe_get_rows(i), ctx);
+        st77xx_stripe_submit();
+    }
+    return true;
 }
 
 void st77xx_cleanup_stripe_mode(void) {
-    if (stripe_buffer) {
-        heap_caps_free(stripe_buffer);
-        stripe_buffer = NULL;
+    transport_fence();
+    bus_drain();
+    for (int i = 0; i < ST77XX_STRIPE_BUFFERS; i++) {
+        if (stripe_ring[i]) {
+            heap_caps_free(stripe_ring[i]);
+            stripe_ring[i] = NULL;
+        }
     }
+    stripe_buffer = NULL;
+    stripe_ring_count = 0;
+    stripe_ring_next = 0;
+    stripe_frame_open = false;
+    stripe_height = 0;
+    stripe_count = 0;
     current_stripe = 0;
 }
 
@@ -472,20 +1046,24 @@ bool st77xx_stripe_draw_image(const char* path) {
         return false;
     }
     
+    // La franja puede seguir en vuelo desde el último st77xx_stripe_submit()
+    stripe_wait_idle(stripe_buffer);
+    
     // OPTIMIZACIÓN: Establecer ventana completa UNA SOLA VEZ
     st77xx_set_window(0, 0, ST77XX_WIDTH - 1, ST77XX_HEIGHT - 1);
-    send_cmd(CMD_RAMWR);
+    window_set = true;
     
     // Enviar todas las franjas sin pausas (streaming continuo)
-    for (int stripe = 0; stripe < ST77XX_STRIPE_COUNT; stripe++) {
+    for (int stripe = 0; stripe < stripe_count; stripe++) {
         // Leer franja desde archivo
-        size_t bytes_read = fread(stripe_buffer, 1, ST77XX_STRIPE_SIZE, f);
-        if (bytes_read < ST77XX_STRIPE_SIZE) {
-            memset(((uint8_t*)stripe_buffer) + bytes_read, 0, ST77XX_STRIPE_SIZE - bytes_read);
+        size_t size = stripe_bytes(st77xx_stripe_get_rows(stripe));
+        size_t bytes_read = fread(stripe_buffer, 1, size, f);
+        if (bytes_read < size) {
+            memset(((uint8_t*)stripe_buffer) + bytes_read, 0, size - bytes_read);
         }
         
         // Enviar directamente sin re-establecer ventana
-        send_data_dma((const uint8_t*)stripe_buffer, ST77XX_STRIPE_SIZE);
+        send_data_dma((const uint8_t*)stripe_buffer, size, ST77XX_SWAP_BYTES_DMA);
     }
     
     fclose(f);
@@ -498,33 +1076,26 @@ bool st77xx_stripe_draw_image(const char* path) {
 
 void st77xx_fill_screen(uint16_t* fb, uint16_t color) {
     if (!fb) return;
-    
-    size_t total = (size_t)ST77XX_WIDTH * ST77XX_HEIGHT;
-    uint32_t color32 = ((uint32_t)color << 16) | color;
-    uint32_t* ptr32 = (uint32_t*)fb;
-    size_t words = total / 2;
-    
-    // Loop unrolling: 8 words por iteración
-    while (words >= 8) {
-        *ptr32++ = color32; *ptr32++ = color32;
-        *ptr32++ = color32; *ptr32++ = color32;
-        *ptr32++ = color32; *ptr32++ = color32;
-        *ptr32++ = color32; *ptr32++ = color32;
-        words -= 8;
-    }
-    while (words--) *ptr32++ = color32;
-    
-    if (total % 2) fb[total - 1] = color;
+    st77xx_kernel_fill(fb, color, (size_t)ST77XX_WIDTH * ST77XX_HEIGHT);
+    damage_add(fb, 0, 0, ST77XX_WIDTH, ST77XX_HEIGHT);
 }
 
 void st77xx_draw_pixel(uint16_t* fb, int32_t x, int32_t y, uint16_t color) {
     if (!fb || x < 0 || x >= ST77XX_WIDTH || y < 0 || y >= ST77XX_HEIGHT) return;
     fb[y * ST77XX_WIDTH + x] = color;
+    damage_add(fb, x, y, 1, 1);
 }
 
 void st77xx_fill_rect(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
     if (!fb) return;
-    
+    fill_rect_raw(fb, x, y, w, h, color);
+    damage_add(fb, x, y, w, h);
+}
+
+/**
+ * @brief Rellena un rectángulo sin registrar daño (uso interno)
+ */
+static void fill_rect_raw(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
     // Clipping
     if (x >= ST77XX_WIDTH || y >= ST77XX_HEIGHT || (x + w) <= 0 || (y + h) <= 0) return;
     if (x < 0) { w += x; x = 0; }
@@ -532,30 +1103,36 @@ void st77xx_fill_rect(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h,
     if ((x + w) > ST77XX_WIDTH) w = ST77XX_WIDTH - x;
     if ((y + h) > ST77XX_HEIGHT) h = ST77XX_HEIGHT - y;
     
-    // Optimización para rectángulos de ancho completo
-    if (x == 0 && w == ST77XX_WIDTH) {
-        uint16_t* start = &fb[y * ST77XX_WIDTH];
-        size_t pixels = (size_t)w * h;
-        uint32_t color32 = ((uint32_t)color << 16) | color;
-        uint32_t* ptr32 = (uint32_t*)start;
-        size_t words = pixels / 2;
-        
-        while (words >= 4) {
-            *ptr32++ = color32; *ptr32++ = color32;
-            *ptr32++ = color32; *ptr32++ = color32;
-            words -= 4;
-        }
-        while (words--) *ptr32++ = color32;
-        if (pixels % 2) start[pixels - 1] = color;
-    } else {
-        // Método tradicional
-        for (int32_t row = 0; row < h; row++) {
-            uint16_t* dst = &fb[(y + row) * ST77XX_WIDTH + x];
-            for (int32_t col = 0; col < w; col++) {
-                *dst++ = color;
-            }
-        }
-    }
+    st77xx_kernel_fill_rect(&fb[y * ST77XX_WIDTH + x], ST77XX_WIDTH, w, h, color);
+}
+
+/**
+ * @brief Recorta la imagen @p w x @p h en (x, y) a la pantalla
+ * @param[in,out] src Se avanza al primer píxel visible
+ * @return false si no queda nada visible
+ */
+static bool clip_blit(int32_t* x, int32_t* y, int32_t* w, int32_t* h,
+                      const uint16_t** src, int32_t src_stride) {
+    if (*x >= ST77XX_WIDTH || *y >= ST77XX_HEIGHT || *x + *w <= 0 || *y + *h <= 0) return false;
+    if (*x < 0) { *src -= *x; *w += *x; *x = 0; }
+    if (*y < 0) { *src -= (ptrdiff_t)(*y) * src_stride; *h += *y; *y = 0; }
+    if (*x + *w > ST77XX_WIDTH) *w = ST77XX_WIDTH - *x;
+    if (*y + *h > ST77XX_HEIGHT) *h = ST77XX_HEIGHT - *y;
+    return *w > 0 && *h > 0;
+}
+
+void st77xx_blit(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h,
+                 const uint16_t* src, int32_t src_stride) {
+    if (!fb || !src || !clip_blit(&x, &y, &w, &h, &src, src_stride)) return;
+    st77xx_kernel_blit(&fb[y * ST77XX_WIDTH + x], ST77XX_WIDTH, src, src_stride, w, h);
+    damage_add(fb, x, y, w, h);
+}
+
+void st77xx_blit_key(uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h,
+                     const uint16_t* src, int32_t src_stride, uint16_t key) {
+    if (!fb || !src || !clip_blit(&x, &y, &w, &h, &src, src_stride)) return;
+    st77xx_kernel_blit_key(&fb[y * ST77XX_WIDTH + x], ST77XX_WIDTH, src, src_stride, w, h, key);
+    damage_add(fb, x, y, w, h);
 }
 
 bool st77xx_draw_image(uint16_t* fb, const char* path) {
@@ -580,6 +1157,7 @@ bool st77xx_draw_image(uint16_t* fb, const char* path) {
     size_t read = fread(fb, 1, ST77XX_FB_SIZE, file);
     fclose(file);
     
+    damage_add(fb, 0, 0, ST77XX_WIDTH, ST77XX_HEIGHT);
     return (read == ST77XX_FB_SIZE);
 }
 
@@ -590,29 +1168,38 @@ void st77xx_draw_text(uint16_t* fb, const char* text, int32_t x, int32_t y,
 
 void st77xx_draw_text_unicode(uint16_t* fb, const char* text, int32_t x, int32_t y,
                               uint16_t color, uint8_t scale, const uint8_t* font) {
-    if (!fb || !text || !font) return;
+    if (!fb || !text || !font || scale == 0) return;
     
-    int32_t cx = x, cy = y;
-    const char* p = text;
+    text_target_t target = { .buf = fb, .y0 = 0, .rows = ST77XX_HEIGHT };
+    draw_text(&target, text, x, y, color, scale, font);
     
-    while (*p) {
+    // Daño por línea de texto en vez de por glifo
+    int32_t line_h = (ST77XX_FONT_HEIGHT + 2) * scale;
+    int32_t cols = 0, cy = y;
+    const char* p = text;
+    while (1) {
         uint32_t cp = utf8_next_codepoint(&p);
-        if (cp == 0) break;
-        
-        if (cp == '\n') {
-            cy += (ST77XX_FONT_HEIGHT + 2) * scale;
-            cx = x;
+        if (cp == '\n' || cp == 0) {
+            if (cols > 0) damage_add(fb, x, cy, cols * ST77XX_FONT_WIDTH * scale, ST77XX_FONT_HEIGHT * scale);
+            if (cp == 0) break;
+            cy += line_h;
+            cols = 0;
             continue;
         }
-        
-        int idx = find_char_index(cp);
-        if (idx >= 0) {
-            draw_glyph(fb, cx, cy, idx, color, scale, font);
-        }
-        cx += ST77XX_FONT_WIDTH * scale;
+        cols++;
     }
 }
 
+void st77xx_stripe_draw_text(uint16_t* stripe, int32_t y0, int32_t rows, const char* text,
+                             int32_t x, int32_t y, uint16_t color, uint8_t scale,
+                             const uint8_t* font) {
+    if (!stripe || !text || !font || scale == 0 || rows <= 0) return;
+    
+    stripe_wait_idle(stripe);
+    text_target_t target = { .buf = stripe, .y0 = y0, .rows = rows };
+    draw_text(&target, text, x, y, color, scale, font);
+}
+
 uint16_t st77xx_rgb888_to_rgb565(uint8_t r, uint8_t g, uint8_t b) {
     return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
 }
@@ -637,7 +1224,9 @@ int st77xx_preload_frames(const char* base_dir, int max_preload) {
         ESP_LOGE(TAG, "Error al asignar array de frames");
         return 0;
     }
+    snprintf(preload_dir, sizeof(preload_dir), "%s", base_dir);
     
+    bool out_of_memory = false;
     for (int i = 0; i < max_preload; i++) {
         char path[128];
         snprintf(path, sizeof(path), "%s/%d.bin", base_dir, i + 1);
@@ -652,6 +1241,7 @@ int st77xx_preload_frames(const char* base_dir, int max_preload) {
         if (!buf) { 
             ESP_LOGE(TAG, "Error al asignar buffer para frame %d", i + 1);
             fclose(f); 
+            out_of_memory = true;
             break; 
         }
         
@@ -668,25 +1258,78 @@ int st77xx_preload_frames(const char* base_dir, int max_preload) {
         ESP_LOGI(TAG, "Preloaded: %s (%d/%d)", path, i + 1, max_preload);
     }
     
-    if (preloaded_count == 0) {
+    // Los que no cupieron se sirven bajo demanda desde la caché
+    preload_total = preloaded_count;
+    if (out_of_memory && cache_budget >= ST77XX_FB_SIZE) {
+        for (int i = preloaded_count; i < max_preload; i++) {
+            char path[128];
+            snprintf(path, sizeof(path), "%s/%d.bin", base_dir, i + 1);
+            FILE* f = fopen(path, "rb");
+            if (!f) break;
+            fclose(f);
+            preload_total++;
+        }
+        if (preload_total > preloaded_count) {
+            ESP_LOGI(TAG, "%d frames bajo demanda vía caché", preload_total - preloaded_count);
+        }
+    }
+    
+    if (preload_total == 0) {
         heap_caps_free(preloaded_frames);
         preloaded_frames = NULL;
         ESP_LOGE(TAG, "No se cargó ningún frame desde %s", base_dir);
     }
     
-    return preloaded_count;
+    return preload_total;
 }
 
 const uint8_t* st77xx_get_preloaded_frame(int index) {
-    if (index < 0 || index >= preloaded_count) return NULL;
-    return preloaded_frames[index];
+    if (index < 0 || index >= preload_total) return NULL;
+    if (index < preloaded_count) return preloaded_frames[index];
+    
+    // El frame servido en la llamada anterior ya se puede expulsar
+    if (preload_demand) {
+        st77xx_cache_release(preload_demand);
+        preload_demand = NULL;
+    }
+    
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%d.bin", preload_dir, index + 1);
+    uint32_t key = st77xx_cache_key(path);
+    
+    const uint16_t* hit = st77xx_cache_get(key, NULL);
+    if (hit) {
+        preload_demand = hit;
+        return (const uint8_t*)hit;
+    }
+    
+    uint16_t* buf = st77xx_cache_insert(key, ST77XX_FB_SIZE);
+    if (!buf) return NULL;
+    
+    FILE* f = fopen(path, "rb");
+    size_t r = f ? fread(buf, 1, ST77XX_FB_SIZE, f) : 0;
+    if (f) fclose(f);
+    
+    if (r != ST77XX_FB_SIZE) {
+        ESP_LOGW(TAG, "No se pudo leer: %s", path);
+        st77xx_cache_release(buf);
+        st77xx_cache_remove(key);
+        return NULL;
+    }
+    preload_demand = buf;
+    return (const uint8_t*)buf;
 }
 
 int st77xx_get_preloaded_count(void) {
-    return preloaded_count;
+    return preload_total;
 }
 
 void st77xx_free_preloaded_frames(void) {
+    if (preload_demand) {
+        st77xx_cache_release(preload_demand);
+        preload_demand = NULL;
+    }
+    preload_total = 0;
     if (!preloaded_frames) return;
     for (int i = 0; i < preloaded_count; i++) {
         if (preloaded_frames[i]) heap_caps_free(preloaded_frames[i]);
@@ -697,87 +1340,728 @@ void st77xx_free_preloaded_frames(void) {
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
- * Funciones privadas - GPIO/SPI
+ * Caché de frames decodificados (LRU)
  * ═══════════════════════════════════════════════════════════════════════════ */
 
-static void gpio_init_pins(void) {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << ST77XX_PIN_DC) | (1ULL << ST77XX_PIN_RST),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
-    };
-    gpio_config(&io_conf);
+static void cache_lock(void) {
+    if (!cache_mutex) {
+        portENTER_CRITICAL(&cache_init_lock);
+        bool create = (cache_mutex == NULL);
+        portEXIT_CRITICAL(&cache_init_lock);
+        if (create) {
+            SemaphoreHandle_t m = xSemaphoreCreateMutex();
+            portENTER_CRITICAL(&cache_init_lock);
+            if (!cache_mutex) {
+                cache_mutex = m;
+                m = NULL;
+            }
+            portEXIT_CRITICAL(&cache_init_lock);
+            if (m) vSemaphoreDelete(m);  // Otra tarea la creó antes
+        }
+    }
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+}
+
+static void cache_unlock(void) {
+    xSemaphoreGive(cache_mutex);
+}
+
+static int cache_find(uint32_t key) {
+    for (int i = 0; i < ST77XX_FRAME_CACHE_ENTRIES; i++) {
+        if (cache_entries[i].key == key) return i;
+    }
+    return -1;
+}
+
+static void cache_drop(int i) {
+    cache_entry_t* e = &cache_entries[i];
+    heap_caps_free(e->data);
+    cache_stats.bytes_used -= e->size;
+    cache_stats.entries--;
+    memset(e, 0, sizeof(*e));
+}
+
+/**
+ * @brief Expulsa la entrada no fijada menos reciente
+ * @return false si todas están fijadas
+ */
+static bool cache_evict_lru(void) {
+    int victim = -1;
+    for (int i = 0; i < ST77XX_FRAME_CACHE_ENTRIES; i++) {
+        const cache_entry_t* e = &cache_entries[i];
+        if (!e->key || e->pins) continue;
+        if (victim < 0 || e->last_use < cache_entries[victim].last_use) victim = i;
+    }
+    if (victim < 0) return false;
+    cache_drop(victim);
+    cache_stats.evictions++;
+    return true;
+}
+
+uint32_t st77xx_cache_key(const char* name) {
+    uint32_t h = 2166136261u;
+    while (name && *name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return h ? h : 1;
 }
 
-static void spi_init_bus(void) {
-    spi_bus_config_t buscfg = {
-        .mosi_io_num = ST77XX_PIN_MOSI,
-        .miso_io_num = ST77XX_PIN_MISO,
-        .sclk_io_num = ST77XX_PIN_SCLK,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .max_transfer_sz = ST77XX_DMA_BUFFER_SIZE,
-        .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS
+const uint16_t* st77xx_cache_get(uint32_t key, size_t* size) {
+    if (!key) return NULL;
+    
+    cache_lock();
+    int i = cache_find(key);
+    const uint16_t* data = NULL;
+    if (i >= 0) {
+        cache_entry_t* e = &cache_entries[i];
+        e->last_use = ++cache_clock;
+        e->pins++;
+        data = e->data;
+        if (size) *size = e->size;
+        cache_stats.hits++;
+    } else {
+        cache_stats.misses++;
+    }
+    cache_unlock();
+    return data;
+}
+
+uint16_t* st77xx_cache_insert(uint32_t key, size_t size) {
+    if (!key || !size) return NULL;
+    
+    cache_lock();
+    if (size > cache_budget) {
+        cache_stats.rejects++;
+        cache_unlock();
+        return NULL;
+    }
+    
+    int i = cache_find(key);
+    if (i >= 0) {
+        if (cache_entries[i].pins) {
+            // En uso: no se puede sustituir
+            cache_stats.rejects++;
+            cache_unlock();
+            return NULL;
+        }
+        cache_drop(i);
+    }
+    
+    // Hueco en presupuesto y en la tabla
+    while (cache_stats.bytes_used + size > cache_budget && cache_evict_lru()) {}
+    if (cache_stats.entries >= ST77XX_FRAME_CACHE_ENTRIES) cache_evict_lru();
+    i = cache_find(0);
+    
+    uint16_t* data = NULL;
+    if (i >= 0 && cache_stats.bytes_used + size <= cache_budget) {
+        uint32_t caps = MALLOC_CAP_8BIT;
+#if ST77XX_USE_PSRAM
+        caps |= MALLOC_CAP_SPIRAM;
+#endif
+        data = heap_caps_malloc(size, caps);
+    }
+    
+    if (!data) {
+        cache_stats.rejects++;
+        cache_unlock();
+        return NULL;
+    }
+    
+    cache_entries[i] = (cache_entry_t){
+        .key = key,
+        .data = data,
+        .size = size,
+        .last_use = ++cache_clock,
+        .pins = 1
     };
+    cache_stats.bytes_used += size;
+    cache_stats.entries++;
+    cache_stats.inserts++;
+    cache_unlock();
+    return data;
+}
+
+void st77xx_cache_release(const uint16_t* data) {
+    if (!data) return;
+    
+    cache_lock();
+    for (int i = 0; i < ST77XX_FRAME_CACHE_ENTRIES; i++) {
+        cache_entry_t* e = &cache_entries[i];
+        if (e->key && e->data == data) {
+            if (e->pins) e->pins--;
+            break;
+        }
+    }
+    cache_unlock();
+}
+
+void st77xx_cache_remove(uint32_t key) {
+    if (!key) return;
+    
+    cache_lock();
+    int i = cache_find(key);
+    if (i >= 0 && !cache_entries[i].pins) cache_drop(i);
+    cache_unlock();
+}
+
+void st77xx_cache_set_budget(size_t bytes) {
+    cache_lock();
+    cache_budget = bytes;
+    while (cache_stats.bytes_used > cache_budget && cache_evict_lru()) {}
+    cache_unlock();
+}
+
+void st77xx_cache_clear(void) {
+    cache_lock();
+    for (int i = 0; i < ST77XX_FRAME_CACHE_ENTRIES; i++) {
+        if (cache_entries[i].key && !cache_entries[i].pins) cache_drop(i);
+    }
+    cache_unlock();
+}
+
+void st77xx_cache_get_stats(st77xx_cache_stats_t* out) {
+    if (!out) return;
+    cache_lock();
+    *out = cache_stats;
+    out->budget = cache_budget;
+    cache_unlock();
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Prefetch asíncrono de frames
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/** @brief Slot que contiene @p frame, o -1. Llamar con prefetch_lock tomado */
+static int prefetch_find(int frame) {
+    for (int i = 0; i < prefetch_slot_count; i++) {
+        if (prefetch_slots[i].frame == frame) return i;
+    }
+    return -1;
+}
+
+/** @brief Todos los frames caben en el anillo: se quedan residentes */
+static inline bool prefetch_all_resident(void) {
+    return prefetch_total >= 0 && prefetch_total <= prefetch_slot_count;
+}
+
+/** @brief Frame siguiente en orden de reproducción */
+static int prefetch_advance(int frame) {
+    frame++;
+    if (frame >= prefetch_max) {
+        if (prefetch_total < 0) prefetch_total = prefetch_max;
+        return 0;
+    }
+    return (prefetch_total >= 0 && frame >= prefetch_total) ? 0 : frame;
+}
+
+static void prefetch_task_main(void* arg) {
+    (void)arg;
+    int next = 0;
+    
+    while (!prefetch_stop_req) {
+        portENTER_CRITICAL(&prefetch_lock);
+        // Un frame pedido fuera de orden (salto) pasa por delante
+        int wanted = prefetch_wanted;
+        if (wanted >= 0 && prefetch_find(wanted) < 0) next = wanted;
+        
+        bool resident = prefetch_find(next) >= 0;
+        int slot = resident ? -1 : prefetch_find(-1);
+        if (slot >= 0) {
+            prefetch_slots[slot].frame = next;
+            prefetch_slots[slot].state = ST77XX_PREFETCH_PENDING;
+        }
+        portEXIT_CRITICAL(&prefetch_lock);
+        
+        if (resident && !prefetch_all_resident()) {
+            next = prefetch_advance(next);
+            continue;
+        }
+        if (slot < 0) {
+            // Anillo lleno o animación entera en memoria: esperar a que se libere un slot
+            xSemaphoreTake(prefetch_space, portMAX_DELAY);
+            continue;
+        }
+        
+        char path[128];
+        snprintf(path, sizeof(path), "%s/%d.bin", prefetch_dir, next + 1);
+        FILE* f = fopen(path, "rb");
+        if (!f) {
+            // Primer hueco en la numeración: fin de la animación
+            portENTER_CRITICAL(&prefetch_lock);
+            prefetch_slots[slot].frame = -1;
+            if (prefetch_total < 0 || next < prefetch_total) prefetch_total = next;
+            if (prefetch_wanted >= prefetch_total) prefetch_wanted = -1;
+            portEXIT_CRITICAL(&prefetch_lock);
+            
+            ESP_LOGI(TAG, "Prefetch: %d frames en %s", next, prefetch_dir);
+            xSemaphoreGive(prefetch_filled);
+            if (next == 0) break;
+            next = 0;
+            continue;
+        }
+        
+        size_t r = fread(prefetch_slots[slot].data, 1, ST77XX_FB_SIZE, f);
+        fclose(f);
+        
+        st77xx_prefetch_state_t state = ST77XX_PREFETCH_READY;
+        if (r != ST77XX_FB_SIZE) {
+            // El frame se marca como erróneo en vez de cortar la animación
+            ESP_LOGW(TAG, "Prefetch: tamaño incorrecto en %s: %u/%u",
+                     path, (unsigned)r, (unsigned)ST77XX_FB_SIZE);
+            state = ST77XX_PREFETCH_ERROR;
+        }
+        
+        portENTER_CRITICAL(&prefetch_lock);
+        prefetch_slots[slot].state = state;
+        if (prefetch_wanted == next) prefetch_wanted = -1;
+        portEXIT_CRITICAL(&prefetch_lock);
+        xSemaphoreGive(prefetch_filled);
+        
+        next = prefetch_advance(next);
+    }
+    
+    xSemaphoreGive(prefetch_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t st77xx_prefetch_start(const char* base_dir, int max_frames, uint32_t timeout_ms) {
+    if (!base_dir || max_frames <= 0) return ESP_ERR_INVALID_ARG;
+    if (prefetch_task) return ESP_ERR_INVALID_STATE;
+    
+    uint32_t caps = MALLOC_CAP_8BIT;
+#if ST77XX_USE_PSRAM
+    caps |= MALLOC_CAP_SPIRAM;
+#endif
+    
+    // Tantos slots como quepan, al menos uno
+    int slots = max_frames < ST77XX_PREFETCH_SLOTS ? max_frames : ST77XX_PREFETCH_SLOTS;
+    prefetch_slot_count = 0;
+    for (int i = 0; i < slots; i++) {
+        uint8_t* buf = heap_caps_malloc(ST77XX_FB_SIZE, caps);
+        if (!buf) {
+            ESP_LOGW(TAG, "Prefetch: solo %d/%d slots", i, slots);
+            break;
+        }
+        prefetch_slots[i] = (prefetch_slot_t){ .data = buf, .frame = -1 };
+        prefetch_slot_count++;
+    }
+    
+    prefetch_space = xSemaphoreCreateBinary();
+    prefetch_filled = xSemaphoreCreateBinary();
+    prefetch_done = xSemaphoreCreateBinary();
+    if (prefetch_slot_count == 0 || !prefetch_space || !prefetch_filled || !prefetch_done) {
+        ESP_LOGE(TAG, "Prefetch: sin memoria");
+        st77xx_prefetch_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    snprintf(prefetch_dir, sizeof(prefetch_dir), "%s", base_dir);
+    prefetch_max = max_frames;
+    prefetch_total = -1;
+    prefetch_wanted = -1;
+    prefetch_stop_req = false;
+    
+    if (xTaskCreatePinnedToCore(prefetch_task_main, "st77xx_prefetch", ST77XX_PREFETCH_TASK_STACK,
+                                NULL, ST77XX_PREFETCH_TASK_PRIO, &prefetch_task,
+                                ST77XX_PREFETCH_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Fallo al crear tarea de prefetch");
+        prefetch_task = NULL;
+        st77xx_prefetch_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Prefetch: %d slots de %u bytes desde %s",
+             prefetch_slot_count, (unsigned)ST77XX_FB_SIZE, base_dir);
+    
+    // Arranque progresivo: basta con que el frame 0 esté en memoria
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+    st77xx_prefetch_state_t state;
+    while ((state = st77xx_prefetch_state(0)) == ST77XX_PREFETCH_PENDING) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= limit) {
+            ESP_LOGE(TAG, "Prefetch: el frame 0 no llegó en %lu ms", (unsigned long)timeout_ms);
+            st77xx_prefetch_stop();
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreTake(prefetch_filled, limit - elapsed);
+    }
+    
+    if (state == ST77XX_PREFETCH_MISSING) {
+        ESP_LOGE(TAG, "No hay frames en %s", base_dir);
+        st77xx_prefetch_stop();
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (state != ST77XX_PREFETCH_READY) {
+        ESP_LOGE(TAG, "Frame 0 con tamaño incorrecto en %s", base_dir);
+        st77xx_prefetch_stop();
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+st77xx_prefetch_state_t st77xx_prefetch_state(int index) {
+    if (index < 0) return ST77XX_PREFETCH_MISSING;
+    
+    st77xx_prefetch_state_t state = ST77XX_PREFETCH_PENDING;
+    portENTER_CRITICAL(&prefetch_lock);
+    int slot = prefetch_find(index);
+    if (slot >= 0) {
+        state = prefetch_slots[slot].state;
+    } else if ((prefetch_total >= 0 && index >= prefetch_total) || index >= prefetch_max) {
+        state = ST77XX_PREFETCH_MISSING;
+    }
+    portEXIT_CRITICAL(&prefetch_lock);
+    return state;
+}
+
+const uint8_t* st77xx_prefetch_get(int index, uint32_t timeout_ms) {
+    if (!prefetch_task) return NULL;
+    
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+    
+    while (1) {
+        portENTER_CRITICAL(&prefetch_lock);
+        int slot = prefetch_find(index);
+        st77xx_prefetch_state_t state = slot >= 0 ? prefetch_slots[slot].state
+                                                  : ST77XX_PREFETCH_PENDING;
+        if (state == ST77XX_PREFETCH_ERROR) {
+            // Un frame erróneo no debe ocupar el anillo
+            prefetch_slots[slot].frame = -1;
+        } else if (slot < 0) {
+            prefetch_wanted = index;
+        }
+        portEXIT_CRITICAL(&prefetch_lock);
+        
+        if (state == ST77XX_PREFETCH_READY) return prefetch_slots[slot].data;
+        if (state == ST77XX_PREFETCH_ERROR) {
+            xSemaphoreGive(prefetch_space);
+            return NULL;
+        }
+        if (st77xx_prefetch_state(index) == ST77XX_PREFETCH_MISSING) return NULL;
+        
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= limit) return NULL;
+        xSemaphoreGive(prefetch_space);     // Despertar al lector por si estaba esperando
+        xSemaphoreTake(prefetch_filled, limit - elapsed);
+    }
+}
+
+void st77xx_prefetch_release(int index) {
+    if (!prefetch_task || prefetch_all_resident()) return;
+    
+    portENTER_CRITICAL(&prefetch_lock);
+    int slot = prefetch_find(index);
+    if (slot >= 0 && prefetch_slots[slot].state != ST77XX_PREFETCH_PENDING) {
+        prefetch_slots[slot].frame = -1;
+    } else {
+        slot = -1;
+    }
+    portEXIT_CRITICAL(&prefetch_lock);
+    
+    if (slot >= 0) xSemaphoreGive(prefetch_space);
+}
+
+int st77xx_prefetch_count(void) {
+    return prefetch_total;
+}
+
+void st77xx_prefetch_stop(void) {
+    if (prefetch_task) {
+        prefetch_stop_req = true;
+        xSemaphoreGive(prefetch_space);
+        xSemaphoreTake(prefetch_done, portMAX_DELAY);
+        prefetch_task = NULL;
+    }
+    
+    for (int i = 0; i < prefetch_slot_count; i++) {
+        heap_caps_free(prefetch_slots[i].data);
+        prefetch_slots[i] = (prefetch_slot_t){ .data = NULL, .frame = -1 };
+    }
+    prefetch_slot_count = 0;
+    prefetch_total = -1;
+    
+    if (prefetch_space) { vSemaphoreDelete(prefetch_space); prefetch_space = NULL; }
+    if (prefetch_filled) { vSemaphoreDelete(prefetch_filled); prefetch_filled = NULL; }
+    if (prefetch_done) { vSemaphoreDelete(prefetch_done); prefetch_done = NULL; }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Funciones privadas - Stripe
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static inline size_t stripe_bytes(int32_t rows) {
+    return (size_t)ST77XX_WIDTH * rows * sizeof(uint16_t);
+}
+
+/**
+ * @brief Espera a que el DMA deje de leer @p buf si es una franja del anillo
+ *
+ * Tras st77xx_stripe_submit() stripe_buffer sigue apuntando a la última
+ * franja encolada: las funciones que escriben en él esperan aquí.
+ */
+static void stripe_wait_idle(const uint16_t* buf) {
+    for (int i = 0; i < stripe_ring_count; i++) {
+        if (stripe_ring[i] != buf) continue;
+        while (stripe_jobs[i].pending) bus_wait_one();
+        return;
+    }
+}
+
+/**
+ * @brief Elige la altura de franja según el chunk DMA y la memoria DMA libre
+ *
+ * Sin altura fija se usa la mayor que cabe en una transacción DMA y en el
+ * presupuesto de RAM DMA para todo el anillo, redondeada a ST77XX_STRIPE_ALIGN.
+ */
+static int32_t stripe_pick_height(void) {
+    int32_t max_rows = ST77XX_STRIPE_MAX_HEIGHT;
+    if (max_rows > ST77XX_HEIGHT) max_rows = ST77XX_HEIGHT;
+    if (stripe_height_req > 0) {
+        return (stripe_height_req < max_rows) ? stripe_height_req : max_rows;
+    }
     
-    spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = ST77XX_SPI_SPEED_HZ,
-        .mode = 0,
-        .spics_io_num = ST77XX_PIN_CS,
-        .queue_size = ST77XX_SPI_QUEUE_SIZE,
-        .flags = SPI_DEVICE_NO_DUMMY
+    size_t budget = heap_caps_get_free_size(MALLOC_CAP_DMA) / 100 * ST77XX_STRIPE_DMA_BUDGET;
+    budget /= ST77XX_STRIPE_BUFFERS;
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+    if (budget > largest) budget = largest;
+    
+    int32_t rows = (int32_t)(budget / stripe_bytes(1));
+    if (rows > max_rows) rows = max_rows;
+    if (rows >= ST77XX_STRIPE_ALIGN) {
+        rows -= rows % ST77XX_STRIPE_ALIGN;
+    } else if (rows < 1) {
+        rows = 1;
+    }
+    return rows;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Funciones privadas - Regiones dañadas
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static bool clip_rect(int32_t x, int32_t y, int32_t w, int32_t h, st77xx_rect_t* out) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > ST77XX_WIDTH) w = ST77XX_WIDTH - x;
+    if (y + h > ST77XX_HEIGHT) h = ST77XX_HEIGHT - y;
+    if (w <= 0 || h <= 0) return false;
+    
+    out->x0 = (uint16_t)x;
+    out->y0 = (uint16_t)y;
+    out->x1 = (uint16_t)(x + w - 1);
+    out->y1 = (uint16_t)(y + h - 1);
+    return true;
+}
+
+static inline uint32_t rect_area(const st77xx_rect_t* r) {
+    return (uint32_t)(r->x1 - r->x0 + 1) * (uint32_t)(r->y1 - r->y0 + 1);
+}
+
+static inline st77xx_rect_t rect_union(const st77xx_rect_t* a, const st77xx_rect_t* b) {
+    st77xx_rect_t u = {
+        .x0 = a->x0 < b->x0 ? a->x0 : b->x0,
+        .y0 = a->y0 < b->y0 ? a->y0 : b->y0,
+        .x1 = a->x1 > b->x1 ? a->x1 : b->x1,
+        .y1 = a->y1 > b->y1 ? a->y1 : b->y1
     };
+    return u;
+}
+
+static inline bool rect_contains(const st77xx_rect_t* outer, const st77xx_rect_t* inner) {
+    return inner->x0 >= outer->x0 && inner->x1 <= outer->x1 &&
+           inner->y0 >= outer->y0 && inner->y1 <= outer->y1;
+}
+
+/**
+ * @brief Registra daño si fb es el back buffer y el modo dirty está activo
+ */
+static void damage_add(const uint16_t* fb, int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (present_mode != ST77XX_PRESENT_DIRTY || !fb || fb != fb_back) return;
     
-    esp_err_t ret = spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Fallo SPI bus: %s", esp_err_to_name(ret));
+    st77xx_rect_t r;
+    if (clip_rect(x, y, w, h, &r)) {
+        rect_list_add(dirty_rects, &dirty_count, ST77XX_DIRTY_MAX_RECTS, r);
+    }
+}
+
+/**
+ * @brief Añade un rectángulo a la lista fusionándolo cuando compensa
+ *
+ * Dos regiones se unen si el área extra de su unión cuesta menos que la
+ * configuración de una ventana adicional. Con la lista llena se fusiona
+ * con la región que menos crece.
+ */
+static void rect_list_add(st77xx_rect_t* list, int* count, int max, st77xx_rect_t r) {
+    bool merged = true;
+    
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < *count; i++) {
+            st77xx_rect_t* e = &list[i];
+            if (rect_contains(e, &r)) return;
+            
+            st77xx_rect_t u = rect_union(e, &r);
+            if (rect_area(&u) <= rect_area(e) + rect_area(&r) + diff_cfg.window_cost_px) {
+                // Sacar e de la lista y reintentar con la unión
+                r = u;
+                list[i] = list[--(*count)];
+                merged = true;
+                break;
+            }
+        }
+    }
+    
+    if (*count < max) {
+        list[(*count)++] = r;
+        return;
+    }
+    
+    // Lista llena: fusionar con la región que menos crece
+    int best = 0;
+    uint32_t best_growth = UINT32_MAX;
+    for (int i = 0; i < *count; i++) {
+        st77xx_rect_t u = rect_union(&list[i], &r);
+        uint32_t growth = rect_area(&u) - rect_area(&list[i]);
+        if (growth < best_growth) { best_growth = growth; best = i; }
+    }
+    st77xx_rect_t u = rect_union(&list[best], &r);
+    list[best] = list[--(*count)];
+    rect_list_add(list, count, max, u);
+}
+
+/**
+ * @brief Busca los spans cambiados entre dos frames, banda a banda
+ *
+ * Para cada banda se marcan las palabras de 32 bits (2 píxeles) que
+ * difieren en alguna de sus filas. Los huecos más baratos que una ventana
+ * se rellenan y cada span resultante se añade a la lista de regiones.
+ */
+static int diff_collect(const uint16_t* prev, const uint16_t* next,
+                        st77xx_rect_t* rects, int max_rects) {
+    static uint8_t changed[ST77XX_WIDTH / 2];
+    const int words_per_row = ST77XX_WIDTH / 2;
+    int count = 0;
+    
+    for (int32_t band_y = 0; band_y < ST77XX_HEIGHT; band_y += diff_cfg.band_rows) {
+        int32_t rows = diff_cfg.band_rows;
+        if (band_y + rows > ST77XX_HEIGHT) rows = ST77XX_HEIGHT - band_y;
+        
+        memset(changed, 0, sizeof(changed));
+        int32_t first_row = -1, last_row = -1;
+        
+        for (int32_t row = band_y; row < band_y + rows; row++) {
+            const uint32_t* a = (const uint32_t*)&prev[(size_t)row * ST77XX_WIDTH];
+            const uint32_t* b = (const uint32_t*)&next[(size_t)row * ST77XX_WIDTH];
+            bool row_changed = false;
+            for (int wd = 0; wd < words_per_row; wd++) {
+                if (a[wd] != b[wd]) {
+                    changed[wd] = 1;
+                    row_changed = true;
+                }
+            }
+            if (row_changed) {
+                if (first_row < 0) first_row = row;
+                last_row = row;
+            }
+        }
+        if (first_row < 0) continue;
+        
+        // Extraer spans, uniendo huecos cuyo coste no justifica otra ventana
+        int32_t band_h = last_row - first_row + 1;
+        int32_t span_start = -1, span_end = -1;
+        for (int wd = 0; wd <= words_per_row; wd++) {
+            bool is_changed = (wd < words_per_row) && changed[wd];
+            if (is_changed) {
+                if (span_start < 0) {
+                    span_start = wd;
+                } else if ((uint32_t)((wd - span_end - 1) * 2 * band_h) > diff_cfg.window_cost_px) {
+                    st77xx_rect_t r = { span_start * 2, first_row, span_end * 2 + 1, last_row };
+                    rect_list_add(rects, &count, max_rects, r);
+                    span_start = wd;
+                }
+                span_end = wd;
+            } else if (wd == words_per_row && span_start >= 0) {
+                st77xx_rect_t r = { span_start * 2, first_row, span_end * 2 + 1, last_row };
+                rect_list_add(rects, &count, max_rects, r);
+            }
+        }
     }
     
-    ret = spi_bus_add_device(SPI2_HOST, &devcfg, &spi_handle);
+    return count;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Funciones privadas - GPIO/bus
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void gpio_init_pins(void) {
+    // DC, CS y el reloj los configura el backend del bus
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << ST77XX_PIN_RST,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    gpio_config(&io_conf);
+    
+#if ST77XX_PIN_TE >= 0
+    // TE: entrada con interrupción en el flanco de subida del pulso
+    gpio_config_t te_conf = {
+        .pin_bit_mask = 1ULL << ST77XX_PIN_TE,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE
+    };
+    gpio_config(&te_conf);
+#endif
+}
+
+static void bus_init(void) {
+    esp_err_t ret = transport->init();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Fallo SPI device: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Fallo al iniciar bus %s: %s", transport->name, esp_err_to_name(ret));
     }
     
-    // Buffer DMA estático
+    // Buffers DMA de rebote (ping-pong)
+    // Si falta memoria se trabaja con los que se hayan podido asignar
     dma_buffer_size = ST77XX_DMA_BUFFER_SIZE;
-    dma_buffer = heap_caps_malloc(dma_buffer_size, MALLOC_CAP_DMA);
-    if (!dma_buffer) {
-        ESP_LOGE(TAG, "Fallo al asignar DMA buffer");
+    dma_buffer_count = 0;
+    for (int i = 0; i < ST77XX_DMA_BUFFER_COUNT; i++) {
+        dma_buffers[i] = heap_caps_malloc(dma_buffer_size, MALLOC_CAP_DMA);
+        if (!dma_buffers[i]) {
+            ESP_LOGE(TAG, "Fallo al asignar DMA buffer %d/%d", i + 1, ST77XX_DMA_BUFFER_COUNT);
+            break;
+        }
+        dma_buffer_count++;
     }
 }
 
-static void display_reset(void) {
-    gpio_set_level(ST77XX_PIN_RST, 0);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    gpio_set_level(ST77XX_PIN_RST, 1);
-    vTaskDelay(pdMS_TO_TICKS(120));
-    send_cmd(CMD_SWRESET);
-    vTaskDelay(pdMS_TO_TICKS(120));
+/**
+ * @brief Comando de la secuencia de init por el transporte del driver
+ */
+static void init_tx(void* ctx, uint8_t cmd, const uint8_t* data, size_t size) {
+    (void)ctx;
+    send_cmd(cmd);
+    send_data(data, size);
 }
 
 static void send_cmd(uint8_t cmd) {
-    gpio_set_level(ST77XX_PIN_DC, CMD_MODE);
-    spi_transaction_t t = {0};
-    t.length = 8;
-    t.tx_buffer = &cmd;
-    spi_device_polling_transmit(spi_handle, &t);
+    transport_fence();
+    bus_drain();  // DC no puede cambiar con datos aún en vuelo
+    transport->tx_cmd(cmd);
+    st77xx_stats_add_bus(1);
 }
 
 static void send_data(const uint8_t* data, size_t size) {
     if (!size) return;
-    gpio_set_level(ST77XX_PIN_DC, DATA_MODE);
-    
-    while (size > 0) {
-        size_t chunk = (size > ST77XX_DMA_BUFFER_SIZE) ? ST77XX_DMA_BUFFER_SIZE : size;
-        spi_transaction_t t = {0};
-        t.length = chunk * 8;
-        t.tx_buffer = data;
-        spi_device_polling_transmit(spi_handle, &t);
-        data += chunk;
-        size -= chunk;
-    }
+    transport_fence();
+    bus_drain();
+    transport->tx_param(data, size);
+    st77xx_stats_add_bus(size);
 }
 
 static void send_word(uint16_t data) {
@@ -785,33 +2069,326 @@ static void send_word(uint16_t data) {
     send_data(buf, 2);
 }
 
-static void send_data_dma(const uint8_t* data, size_t size) {
-    if (!size || !dma_buffer) return;
+/**
+ * @brief Envía comandos y parámetros cortos por la cola del bus
+ *
+ * Con queue_ctrl() no se vacía el bus: la secuencia sale detrás de los
+ * píxeles ya encolados y los siguientes salen detrás de ella, así que una
+ * región pequeña cuesta poco más que sus bytes. Sin él, cada entrada es
+ * una transferencia síncrona con el bus vacío.
+ */
+static void send_ctrl(const bus_ctrl_t* seq, int count) {
+    if (!transport->queue_ctrl) {
+        for (int i = 0; i < count; i++) {
+            if (seq[i].dc) {
+                send_data(seq[i].data, seq[i].size);
+            } else {
+                send_cmd(seq[i].data[0]);
+            }
+        }
+        return;
+    }
     
-    gpio_set_level(ST77XX_PIN_DC, DATA_MODE);
+    transport_fence();
+    stage_commit();  // Lo ya preparado va antes que el comando
+    for (int i = 0; i < count; i++) bus_queue_ctrl(&seq[i]);
+}
+
+/**
+ * @brief Reanuda la escritura en la ventana actual
+ */
+static void send_ramwr(void) {
+    const bus_ctrl_t ramwr = { false, 1, { CMD_RAMWR } };
+    send_ctrl(&ramwr, 1);
+}
+
+/**
+ * @brief Envía datos de píxel a través de los buffers de rebote encolados
+ *
+ * Mientras el DMA envía un chunk, la CPU prepara el siguiente en otro
+ * buffer. Retorna en cuanto el último chunk está encolado: los datos ya
+ * están copiados, así que el llamador puede reutilizar su buffer.
+ */
+static void send_data_dma(const uint8_t* data, size_t size, bool swap) {
+    if (!size || dma_buffer_count == 0) return;
     
+    transport_fence();
+    stage_push(data, size, swap);
+    stage_commit();
+}
+
+/**
+ * @brief Copia (con swap opcional) datos al buffer de rebote en preparación
+ *
+ * Cada buffer lleno se encola y se continúa en el siguiente, esperando
+ * solo si el DMA aún no lo ha liberado.
+ */
+static void stage_push(const uint8_t* data, size_t size, bool swap) {
     while (size > 0) {
-        size_t chunk = (size > dma_buffer_size) ? dma_buffer_size : size;
-        
-#if ST77XX_SWAP_BYTES_DMA
-        // Swap bytes para RGB565 correcto
-        for (size_t i = 0; i + 1 < chunk; i += 2) {
-            dma_buffer[i] = data[i + 1];
-            dma_buffer[i + 1] = data[i];
+        if (!stage_buf) {
+            // Esperar a que el DMA libere este buffer
+            while (dma_jobs[dma_next].pending) bus_wait_one();
+            stage_buf = dma_buffers[dma_next];
+            stage_used = 0;
         }
-        if (chunk % 2) dma_buffer[chunk - 1] = data[chunk - 1];
-#else
-        memcpy(dma_buffer, data, chunk);
-#endif
         
-        spi_transaction_t t = {0};
-        t.length = chunk * 8;
-        t.tx_buffer = dma_buffer;
-        spi_device_polling_transmit(spi_handle, &t);
+        size_t chunk = dma_buffer_size - stage_used;
+        if (chunk > size) chunk = size;
+        uint8_t* buf = stage_buf + stage_used;
         
+        if (swap && !(((uintptr_t)buf | (uintptr_t)data) & 1)) {
+            // Copia y swap en una sola pasada (p.ej. PSRAM -> RAM DMA)
+            int64_t t0 = st77xx_stats_begin();
+            st77xx_kernel_swap((uint16_t*)buf, (const uint16_t*)data, chunk / 2);
+            if (chunk % 2) buf[chunk - 1] = data[chunk - 1];
+            st77xx_stats_end(ST77XX_STAGE_SWAP, t0);
+        } else if (swap) {
+            // Punteros impares: no se puede acceder por píxeles
+            for (size_t i = 0; i + 1 < chunk; i += 2) {
+                buf[i] = data[i + 1];
+                buf[i + 1] = data[i];
+            }
+            if (chunk % 2) buf[chunk - 1] = data[chunk - 1];
+        } else {
+            memcpy(buf, data, chunk);
+        }
+        
+        stage_used += chunk;
+        data += chunk;
+        size -= chunk;
+        if (stage_used == dma_buffer_size) stage_commit();
+    }
+}
+
+/**
+ * @brief Encola el buffer de rebote en preparación (si tiene datos)
+ */
+static void stage_commit(void) {
+    if (!stage_buf) return;
+    if (stage_used > 0) {
+        bus_queue(&dma_jobs[dma_next], stage_buf, stage_used);
+        dma_next = (dma_next + 1) % dma_buffer_count;
+    }
+    stage_buf = NULL;
+    stage_used = 0;
+}
+
+/**
+ * @brief Envía una región de un framebuffer: ventana + filas con stride
+ *
+ * Las filas se empaquetan de forma contigua en los buffers de rebote, de
+ * modo que una región estrecha no genera una transacción por fila.
+ */
+static void send_rect(const uint16_t* fb, const st77xx_rect_t* r) {
+    if (dma_buffer_count == 0) return;
+    
+    size_t w = (size_t)(r->x1 - r->x0 + 1);
+    size_t h = (size_t)(r->y1 - r->y0 + 1);
+    
+    st77xx_set_window(r->x0, r->y0, r->x1, r->y1);
+    window_set = false;  // La ventana completa debe restablecerse en el próximo flush
+    
+    const uint16_t* src = &fb[(size_t)r->y0 * ST77XX_WIDTH + r->x0];
+    if (w == ST77XX_WIDTH) {
+        stage_push((const uint8_t*)src, w * h * sizeof(uint16_t), ST77XX_SWAP_BYTES_DMA);
+    } else {
+        for (size_t row = 0; row < h; row++) {
+            stage_push((const uint8_t*)src, w * sizeof(uint16_t), ST77XX_SWAP_BYTES_DMA);
+            src += ST77XX_WIDTH;
+        }
+    }
+    stage_commit();
+}
+
+/**
+ * @brief Envía datos ya intercambiados sin copia cuando el DMA puede leerlos
+ *
+ * Los chunks se encolan directamente desde el buffer del llamador; al
+ * retornar el bus está vacío y el buffer puede modificarse. Si la memoria
+ * no es accesible por DMA se usan los buffers de rebote (solo memcpy).
+ */
+static void send_data_raw(const uint8_t* data, size_t size) {
+    if (!size) return;
+    
+    if (!esp_ptr_dma_capable(data) || ((uintptr_t)data & 3)) {
+        send_data_dma(data, size, false);
+        bus_drain();
+        return;
+    }
+    
+    transport_fence();
+    
+    while (size > 0) {
+        size_t chunk = (size > ST77XX_DMA_BUFFER_SIZE) ? ST77XX_DMA_BUFFER_SIZE : size;
+        st77xx_bus_job_t* job = &raw_jobs[raw_next];
+        while (job->pending) bus_wait_one();
+        bus_queue(job, data, chunk);
+        raw_next = (raw_next + 1) % ST77XX_BUS_QUEUE_SIZE;
         data += chunk;
         size -= chunk;
     }
+    
+    bus_drain();
+}
+
+/**
+ * @brief Espera a tener hueco en la cola del bus
+ */
+static void bus_reserve(void) {
+    // La cola de resultados tiene el mismo tamaño: no desbordarla. Con
+    // otro usuario en el bus, una transferencia en vuelo para alternar
+    while (bus_pending >= st77xx_bus_queue_limit(ST77XX_BUS_USER_MAIN)) bus_wait_one();
+}
+
+/**
+ * @brief Contabiliza un trabajo recién encolado (o lo libera si falló)
+ */
+static void bus_queued(st77xx_bus_job_t* job, esp_err_t ret, size_t size) {
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo al encolar en %s: %s", transport->name, esp_err_to_name(ret));
+        job->pending = false;
+        return;
+    }
+    if (bus_pending == 0) {
+        st77xx_bus_set_active(ST77XX_BUS_USER_MAIN, true);
+#if ST77XX_USE_STATS
+        bus_busy_since = esp_timer_get_time();
+#endif
+    }
+    st77xx_stats_add_bus(size);
+    bus_pending++;
+}
+
+/**
+ * @brief Encola una transferencia de datos de píxel
+ */
+static void bus_queue(st77xx_bus_job_t* job, const void* data, size_t size) {
+    bus_reserve();
+    job->pending = true;
+    bus_queued(job, transport->queue(job, data, size), size);
+}
+
+/**
+ * @brief Encola un comando o sus parámetros (el transporte copia los bytes)
+ */
+static void bus_queue_ctrl(const bus_ctrl_t* ctrl) {
+    st77xx_bus_job_t* job = &ctrl_jobs[ctrl_next];
+    while (job->pending) bus_wait_one();
+    bus_reserve();
+    job->pending = true;
+    bus_queued(job, transport->queue_ctrl(job, ctrl->dc, ctrl->data, ctrl->size), ctrl->size);
+    ctrl_next = (ctrl_next + 1) % ST77XX_BUS_QUEUE_SIZE;
+}
+
+/**
+ * @brief Espera a que termine la transacción encolada más antigua
+ */
+static void bus_wait_one(void) {
+    if (bus_pending == 0) return;
+    
+    st77xx_bus_job_t* done = transport->wait_one();
+    if (!done) return;
+    bus_pending--;
+    done->pending = false;
+    if (bus_pending == 0) {
+        st77xx_bus_set_active(ST77XX_BUS_USER_MAIN, false);
+#if ST77XX_USE_STATS
+        // Bus vacío: la ráfaga termina con la última transferencia, no con esta espera
+        st77xx_stats_add(ST77XX_STAGE_SPI, (uint32_t)(done->done_us - bus_busy_since));
+#endif
+    }
+}
+
+/**
+ * @brief Espera a que terminen todas las transacciones encoladas
+ */
+static void bus_drain(void) {
+    while (bus_pending > 0) bus_wait_one();
+}
+
+/**
+ * @brief Serializa el acceso al bus frente a la tarea de flush asíncrono
+ */
+static void transport_fence(void) {
+    if (flush_task && xTaskGetCurrentTaskHandle() != flush_task) {
+        st77xx_flush_wait();
+    }
+}
+
+/**
+ * @brief Envía un frame completo (ventana + RAMWR + datos)
+ */
+static void flush_frame(const uint16_t* frame_buffer, bool raw) {
+    te_wait_present();
+    if (!window_set) {
+        st77xx_set_window(0, 0, ST77XX_WIDTH - 1, ST77XX_HEIGHT - 1);
+        window_set = true;
+    } else {
+        send_ramwr();
+    }
+    
+    if (raw) {
+        send_data_raw((const uint8_t*)frame_buffer, ST77XX_FB_SIZE);
+    } else {
+        send_data_dma((const uint8_t*)frame_buffer, ST77XX_FB_SIZE, ST77XX_SWAP_BYTES_DMA);
+    }
+}
+
+static void flush_task_main(void* arg) {
+    (void)arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        flush_frame(flush_job_fb, flush_job_raw);
+        bus_drain();
+        flush_job_fb = NULL;
+        xSemaphoreGive(flush_idle);
+    }
+}
+
+/**
+ * @brief Entrega un frame a la tarea de flush (o lo envía en línea si no existe)
+ */
+static void flush_async_start(const uint16_t* frame_buffer, bool raw) {
+    if (!flush_task_start()) {
+        // Sin tarea de flush: degradar a envío síncrono
+        transport_fence();
+        flush_frame(frame_buffer, raw);
+        return;
+    }
+    
+    // Un único flush en curso: esperar al anterior
+    xSemaphoreTake(flush_idle, portMAX_DELAY);
+    flush_job_fb = frame_buffer;
+    flush_job_raw = raw;
+    xTaskNotifyGive(flush_task);
+}
+
+/**
+ * @brief Crea la tarea de flush asíncrono la primera vez que se necesita
+ */
+static bool flush_task_start(void) {
+    if (flush_task) return true;
+    
+    flush_idle = xSemaphoreCreateBinary();
+    if (!flush_idle) {
+        ESP_LOGE(TAG, "Fallo al crear semáforo de flush");
+        return false;
+    }
+    xSemaphoreGive(flush_idle);
+    
+    if (xTaskCreatePinnedToCore(flush_task_main, "st77xx_flush", ST77XX_FLUSH_TASK_STACK,
+                                NULL, ST77XX_FLUSH_TASK_PRIO, &flush_task,
+                                ST77XX_FLUSH_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Fallo al crear tarea de flush");
+        vSemaphoreDelete(flush_idle);
+        flush_idle = NULL;
+        flush_task = NULL;
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Flush asíncrono: %d buffers DMA de %u bytes, core %d",
+             dma_buffer_count, (unsigned)dma_buffer_size, ST77XX_FLUSH_TASK_CORE);
+    return true;
 }
 
 static void init_backlight_once(void) {
@@ -839,20 +2416,292 @@ static void init_backlight_once(void) {
     backlight_initialized = true;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Funciones privadas - Scroll
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Traduce la zona pedida a VSCRDEF según MADCTL y resetea VSCSAD
+ *
+ * En horizontal (MV) la columna x de la pantalla es la línea de gate
+ * x + ST77XX_X_OFFSET, o la simétrica si MY invierte el orden; las líneas
+ * fuera del panel visible quedan dentro de las zonas fijas.
+ */
+static bool scroll_apply(void) {
+    if (!(madctl_current & MADCTL_MV)) return false;
+    int32_t vsa = ST77XX_WIDTH - scroll_fixed_left - scroll_fixed_right;
+    if (vsa <= 0) return false;
+    
+    scroll_flip = (madctl_current & MADCTL_MY) != 0;
+    scroll_tfa = scroll_flip
+        ? ST77XX_GRAM_LINES - ST77XX_X_OFFSET - ST77XX_WIDTH + scroll_fixed_right
+        : ST77XX_X_OFFSET + scroll_fixed_left;
+    scroll_vsa = vsa;
+    scroll_pos = 0;
+    
+    uint16_t bfa = (uint16_t)(ST77XX_GRAM_LINES - scroll_tfa - scroll_vsa);
+    send_cmd(CMD_VSCRDEF);
+    send_word((uint16_t)scroll_tfa);
+    send_word((uint16_t)scroll_vsa);
+    send_word(bfa);
+    send_cmd(CMD_VSCSAD);
+    send_word((uint16_t)scroll_tfa);
+    return true;
+}
+
+/**
+ * @brief Columna de la GRAM que el panel muestra en la columna @p x
+ *
+ * La línea de gate d de la zona de scroll muestra la línea de la GRAM
+ * TFA + (VSCSAD - TFA + d - TFA) mod VSA.
+ */
+static int32_t scroll_gram_col(int32_t x) {
+    int32_t d = scroll_flip ? ST77XX_GRAM_LINES - 1 - ST77XX_X_OFFSET - x
+                            : x + ST77XX_X_OFFSET;
+    int32_t g = d;
+    if (d >= scroll_tfa && d < scroll_tfa + scroll_vsa) {
+        g = scroll_tfa + (scroll_pos + d - scroll_tfa) % scroll_vsa;
+    }
+    return scroll_flip ? ST77XX_GRAM_LINES - 1 - ST77XX_X_OFFSET - g
+                       : g - ST77XX_X_OFFSET;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Funciones privadas - TE
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+#if ST77XX_PIN_TE >= 0
+/**
+ * @brief Pulso TE (ISR): cuenta refrescos, mide el período y libera el present
+ */
+static void IRAM_ATTR te_isr(void* arg) {
+    (void)arg;
+    int64_t now = esp_timer_get_time();
+    int64_t dt = now - te_last_us;
+    te_last_us = now;
+    
+    // Media móvil de 1/8; los huecos de pulsos perdidos no cuentan
+    if (dt > 0 && dt < 100000) {
+        uint32_t p = te_period_us;
+        te_period_us = p ? p - (p >> 3) + ((uint32_t)dt >> 3) : (uint32_t)dt;
+    }
+    te_count++;
+    
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(te_sem, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+#endif
+
+/**
+ * @brief Activa la salida TE del panel e instala la interrupción del pin
+ */
+static void te_init(void) {
+#if ST77XX_PIN_TE >= 0
+    // M = 0: un pulso por refresco, al llegar el barrido a la línea de STE
+    send_cmd(CMD_TEON);
+    send_data((uint8_t[]){0x00}, 1);
+    send_cmd(CMD_STE);
+    send_data((uint8_t[]){ST77XX_TE_SCANLINE >> 8, ST77XX_TE_SCANLINE & 0xFF}, 2);
+    
+    if (!te_sem) te_sem = xSemaphoreCreateBinary();
+    if (!te_sem) {
+        ESP_LOGE(TAG, "Fallo al crear semáforo TE");
+        return;
+    }
+    
+    // La aplicación puede haber instalado ya el servicio de ISR de GPIO
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {
+        err = gpio_isr_handler_add(ST77XX_PIN_TE, te_isr, NULL);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo al instalar ISR de TE: %s", esp_err_to_name(err));
+        vSemaphoreDelete(te_sem);
+        te_sem = NULL;
+        return;
+    }
+    
+    te_presented = te_count;
+    te_sync = true;
+    ESP_LOGI(TAG, "TE: GPIO %d, línea %d", ST77XX_PIN_TE, ST77XX_TE_SCANLINE);
+#endif
+}
+
+static void te_deinit(void) {
+#if ST77XX_PIN_TE >= 0
+    if (!te_sem) return;
+    te_sync = false;
+    gpio_isr_handler_remove(ST77XX_PIN_TE);
+    vSemaphoreDelete(te_sem);
+    te_sem = NULL;
+    te_period_us = 0;
+#endif
+}
+
+/**
+ * @brief Espera al pulso TE con el que debe arrancar el siguiente present
+ *
+ * Siempre espera un pulso posterior a la llamada, para que la escritura
+ * salga justo detrás del barrido, y como mínimo al pulso te_interval
+ * contado desde el present anterior. Sin pulsos durante dos períodos
+ * (o 100 ms antes de medir el primero) se desactiva la sincronización.
+ */
+static void te_wait_present(void) {
+#if ST77XX_PIN_TE >= 0
+    if (!te_sync) return;
+    
+    // Lo encolado del frame anterior tiene que haber salido antes
+    bus_drain();
+    
+    uint32_t target = te_presented + te_interval;
+    uint32_t period = te_period_us;
+    TickType_t timeout = pdMS_TO_TICKS(period ? period / 500 + 1 : 100);
+    if (timeout < 2) timeout = 2;
+    
+    // Un pulso pendiente de antes de la llamada ya no marca el inicio del barrido
+    xSemaphoreTake(te_sem, 0);
+    do {
+        if (xSemaphoreTake(te_sem, timeout) != pdTRUE) {
+            ESP_LOGW(TAG, "Sin pulsos TE: sincronización desactivada");
+            te_sync = false;
+            return;
+        }
+    } while ((int32_t)(te_count - target) < 0);
+    te_presented = te_count;
+#endif
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * Funciones privadas - Texto/UTF-8
  * ═══════════════════════════════════════════════════════════════════════════ */
 
+/**
+ * @brief Construye la tabla de codepoints y la de tramos por byte de fila
+ *
+ * Ambas dependen solo del mapa de fuente, no del color ni de la escala.
+ * Se puede llamar varias veces: el resultado siempre es el mismo.
+ */
+static void text_tables_init(void) {
+    if (text_tables_ready) return;
+    
+    memset(glyph_lut, 0, sizeof(glyph_lut));
+    font_char_map_wide = font_char_map_count;
+    for (int i = font_char_map_count - 1; i >= 0; i--) {
+        if (font_char_map[i] < 256) {
+            glyph_lut[font_char_map[i]] = (uint8_t)(i + 1);
+        } else {
+            font_char_map_wide = i;
+        }
+    }
+    
+    for (int bits = 0; bits < 256; bits++) {
+        uint8_t* runs = glyph_runs[bits];
+        runs[0] = 0;
+        int col = 0;
+        while (col < ST77XX_FONT_WIDTH) {
+            if (!(bits & (0x80 >> col))) { col++; continue; }
+            int start = col;
+            while (col < ST77XX_FONT_WIDTH && (bits & (0x80 >> col))) col++;
+            runs[1 + runs[0]++] = (uint8_t)((start << 4) | (col - start));
+        }
+    }
+    text_tables_ready = true;
+}
+
 /**
  * @brief Busca el índice de un codepoint Unicode en el mapa de fuente
  */
 static int find_char_index(uint32_t code) {
-    for (int i = 0; i < font_char_map_count; i++) {
+    if (code < 256) return (int)glyph_lut[code] - 1;
+    for (int i = font_char_map_wide; i < font_char_map_count; i++) {
         if (font_char_map[i] == code) return i;
     }
     return -1;
 }
 
+/**
+ * @brief Copia @p n píxeles de color desde la línea precargada
+ */
+static inline void text_span(uint16_t* dst, const uint16_t* line, int32_t line_len, int32_t n) {
+    while (n > line_len) {
+        memcpy(dst, line, line_len * sizeof(uint16_t));
+        dst += line_len;
+        n -= line_len;
+    }
+    memcpy(dst, line, n * sizeof(uint16_t));
+}
+
+/**
+ * @brief Dibuja texto como tramos horizontales de color
+ *
+ * Cada fila de un glifo se descompone en tramos con glyph_runs y cada tramo
+ * escalado se escribe con memcpy desde una línea de color. El recorte se
+ * decide una vez por cadena: si el texto cabe entero en el destino no se
+ * comprueba nada por píxel.
+ */
+static void draw_text(const text_target_t* t, const char* text, int32_t x, int32_t y,
+                      uint16_t color, uint8_t scale, const uint8_t* font) {
+    text_tables_init();
+    
+    int32_t glyph_w = ST77XX_FONT_WIDTH * scale;
+    int32_t line_h = (ST77XX_FONT_HEIGHT + 2) * scale;
+    
+    // Extensión de la cadena para decidir el recorte
+    int32_t cols = 0, max_cols = 0, lines = 1;
+    for (const char* p = text; ; ) {
+        uint32_t cp = utf8_next_codepoint(&p);
+        if (cp == 0) break;
+        if (cp == '\n') { lines++; cols = 0; continue; }
+        if (++cols > max_cols) max_cols = cols;
+    }
+    if (max_cols == 0) return;
+    
+    int32_t right = x + max_cols * glyph_w;
+    int32_t bottom = y + (lines - 1) * line_h + ST77XX_FONT_HEIGHT * scale;
+    if (x >= ST77XX_WIDTH || y >= t->y0 + t->rows || right <= 0 || bottom <= t->y0) return;
+    bool clip = x < 0 || y < t->y0 || right > ST77XX_WIDTH || bottom > t->y0 + t->rows;
+    
+    uint16_t line[ST77XX_FONT_WIDTH * 8];
+    int32_t line_len = (int32_t)(sizeof(line) / sizeof(line[0]));
+    if (glyph_w < line_len) line_len = glyph_w;
+    for (int32_t i = 0; i < line_len; i++) line[i] = color;
+    
+    int32_t cx = x, cy = y;
+    for (const char* p = text; ; ) {
+        uint32_t cp = utf8_next_codepoint(&p);
+        if (cp == 0) break;
+        if (cp == '\n') { cy += line_h; cx = x; continue; }
+        
+        int idx = find_char_index(cp);
+        if (idx < 0 || idx >= ST77XX_FONT_CHARS) { cx += glyph_w; continue; }
+        const uint8_t* glyph = &font[idx * ST77XX_FONT_HEIGHT];
+        
+        for (int32_t row = 0; row < ST77XX_FONT_HEIGHT; row++) {
+            const uint8_t* runs = glyph_runs[glyph[row]];
+            if (runs[0] == 0) continue;
+            
+            int32_t py = cy + row * scale - t->y0;
+            for (int32_t sy = 0; sy < scale; sy++, py++) {
+                if (clip && (py < 0 || py >= t->rows)) continue;
+                uint16_t* dst = t->buf + py * ST77XX_WIDTH;
+                
+                for (int r = 1; r <= runs[0]; r++) {
+                    int32_t x0 = cx + (runs[r] >> 4) * scale;
+                    int32_t x1 = x0 + (runs[r] & 0x0F) * scale;
+                    if (clip) {
+                        if (x0 < 0) x0 = 0;
+                        if (x1 > ST77XX_WIDTH) x1 = ST77XX_WIDTH;
+                        if (x1 <= x0) continue;
+                    }
+                    text_span(dst + x0, line, line_len, x1 - x0);
+                }
+            }
+        }
+        cx += glyph_w;
+    }
+}
+
 static uint32_t utf8_next_codepoint(const char** p) {
     const unsigned char* s = (const unsigned char*)*p;
     if (!s || !*s) return 0;
@@ -874,24 +2723,4 @@ static uint32_t utf8_next_codepoint(const char** p) {
         *p += 1;
     }
     return cp;
-}
-
-static void draw_glyph(uint16_t* fb, int32_t x, int32_t y, int index,
-                       uint16_t color, uint8_t scale, const uint8_t* font) {
-    if (index < 0 || index >= ST77XX_FONT_CHARS || !font) return;
-    
-    const uint8_t* glyph = &font[index * ST77XX_FONT_HEIGHT];
-    
-    for (int32_t row = 0; row < ST77XX_FONT_HEIGHT; row++) {
-        uint8_t line = glyph[row];
-        for (int32_t col = 0; col < ST77XX_FONT_WIDTH; col++) {
-            if (line & (1 << (ST77XX_FONT_WIDTH - 1 - col))) {
-                if (scale == 1) {
-                    st77xx_draw_pixel(fb, x + col, y + row, color);
-                } else {
-                    st77xx_fill_rect(fb, x + col * scale, y + row * scale, scale, scale, color);
-                }
-            }
-        }
-    }
 }
\ No newline at end of file
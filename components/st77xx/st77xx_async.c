@@ -0,0 +1,188 @@
+/**
+ * @file st77xx_async.c
+ * @brief Backend async memcpy para copias y rellenos de framebuffer
+ */
+
+#include "st77xx_async.h"
+#include "st77xx_kernels.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#if ST77XX_USE_ASYNC_BLIT
+#include "esp_async_memcpy.h"
+#include "esp_cache.h"
+#include "esp_memory_utils.h"
+#include "esp_attr.h"
+
+static const char* TAG = "st77xx_async";
+
+/** @brief Aviso pendiente de una operación (va en su última transferencia) */
+typedef struct {
+    st77xx_async_cb_t cb;
+    void* ctx;
+} async_op_t;
+
+static async_memcpy_handle_t engine = NULL;
+static bool engine_failed = false;
+static SemaphoreHandle_t engine_progress = NULL;   // Se da en cada fin de transferencia
+static volatile uint32_t queued = 0;
+static volatile uint32_t completed = 0;
+static async_op_t ops[ST77XX_ASYNC_BACKLOG];
+static uint32_t op_next = 0;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Motor DMA
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static bool IRAM_ATTR transfer_done(async_memcpy_handle_t handle, async_memcpy_event_t* event,
+                                    void* args) {
+    (void)handle;
+    (void)event;
+    BaseType_t woken = pdFALSE;
+    completed++;
+
+    const async_op_t* op = (const async_op_t*)args;
+    if (op && op->cb && op->cb(op->ctx)) woken = pdTRUE;
+    xSemaphoreGiveFromISR(engine_progress, &woken);
+    return woken == pdTRUE;
+}
+
+esp_err_t st77xx_async_init(void) {
+    if (engine) return ESP_OK;
+    if (engine_failed) return ESP_ERR_NOT_SUPPORTED;
+
+    engine_progress = xSemaphoreCreateBinary();
+    async_memcpy_config_t cfg = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    cfg.backlog = ST77XX_ASYNC_BACKLOG;
+    esp_err_t ret = engine_progress ? esp_async_memcpy_install(&cfg, &engine) : ESP_ERR_NO_MEM;
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Sin async memcpy (%s): blits por CPU", esp_err_to_name(ret));
+        if (engine_progress) vSemaphoreDelete(engine_progress);
+        engine_progress = NULL;
+        engine = NULL;
+        engine_failed = true;
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    ESP_LOGI(TAG, "Async memcpy listo, %d transferencias en cola", ST77XX_ASYNC_BACKLOG);
+    return ESP_OK;
+}
+
+/**
+ * @brief Coherencia de caché de una región en PSRAM antes de que la toque el DMA
+ *
+ * Escribe a memoria las líneas sucias y las invalida: el origen se lee
+ * actualizado y el destino no se pisa después con datos viejos de caché.
+ */
+static void cache_prepare(const void* p, size_t bytes) {
+    if (!esp_ptr_external_ram(p)) return;
+    esp_cache_msync((void*)p, bytes, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_INVALIDATE |
+                                     ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+}
+
+/**
+ * @brief Encola una transferencia; false si el DMA no la acepta
+ */
+static bool transfer(void* dst, const void* src, size_t bytes, async_op_t* op) {
+    // Cola llena: esperar a que avance
+    while (queued - completed >= ST77XX_ASYNC_BACKLOG) {
+        xSemaphoreTake(engine_progress, 1);
+    }
+    cache_prepare(src, bytes);
+    cache_prepare(dst, bytes);
+
+    queued++;
+    if (esp_async_memcpy(engine, dst, (void*)src, bytes, transfer_done, op) != ESP_OK) {
+        queued--;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reserva el aviso de una operación
+ */
+static async_op_t* op_slot(st77xx_async_cb_t cb, void* ctx) {
+    if (!cb) return NULL;
+    async_op_t* op = &ops[op_next];
+    op_next = (op_next + 1) % ST77XX_ASYNC_BACKLOG;
+    op->cb = cb;
+    op->ctx = ctx;
+    return op;
+}
+
+#endif
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+esp_err_t st77xx_async_wait(uint32_t timeout_ms) {
+#if ST77XX_USE_ASYNC_BLIT
+    if (!engine) return ESP_OK;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+    while (completed != queued) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= limit) return ESP_ERR_TIMEOUT;
+        // Con varias tareas esperando, cada aviso despierta solo a una: las
+        // demás vuelven a mirar los contadores en el siguiente tick
+        xSemaphoreTake(engine_progress, 1);
+    }
+#else
+    (void)timeout_ms;
+#endif
+    return ESP_OK;
+}
+
+esp_err_t st77xx_async_blit(uint16_t* dst, int32_t dst_stride, const uint16_t* src,
+                            int32_t src_stride, int32_t w, int32_t h,
+                            st77xx_async_cb_t cb, void* ctx) {
+    if (!dst || !src || w <= 0 || h <= 0) return ESP_ERR_INVALID_ARG;
+
+#if ST77XX_USE_ASYNC_BLIT
+    if (st77xx_async_init() == ESP_OK) {
+        // Filas contiguas en ambos lados: una sola transferencia
+        bool flat = dst_stride == w && src_stride == w;
+        int32_t rows = flat ? 1 : h;
+        size_t bytes = (flat ? (size_t)w * h : (size_t)w) * sizeof(uint16_t);
+
+        for (int32_t row = 0; row < rows; row++, dst += dst_stride, src += src_stride) {
+            async_op_t* op = row == rows - 1 ? op_slot(cb, ctx) : NULL;
+            if (transfer(dst, src, bytes, op)) continue;
+
+            // Alineación no admitida: el resto por CPU, tras lo ya encolado
+            st77xx_async_wait(portMAX_DELAY);
+            st77xx_kernel_blit(dst, dst_stride, src, src_stride, w, flat ? h : rows - row);
+            if (cb) cb(ctx);
+            return ESP_OK;
+        }
+        return ESP_OK;
+    }
+#endif
+
+    st77xx_kernel_blit(dst, dst_stride, src, src_stride, w, h);
+    if (cb) cb(ctx);
+    return ESP_OK;
+}
+
+esp_err_t st77xx_async_copy(uint16_t* dst, const uint16_t* src, size_t n,
+                            st77xx_async_cb_t cb, void* ctx) {
+    if (!dst || !src || n == 0 || n > INT32_MAX) return ESP_ERR_INVALID_ARG;
+    return st77xx_async_blit(dst, (int32_t)n, src, (int32_t)n, (int32_t)n, 1, cb, ctx);
+}
+
+esp_err_t st77xx_async_fill(uint16_t* dst, int32_t stride, int32_t w, int32_t h,
+                            uint16_t color, st77xx_async_cb_t cb, void* ctx) {
+    if (!dst || w <= 0 || h <= 0) return ESP_ERR_INVALID_ARG;
+
+    // La fila modelo no puede escribirse mientras el DMA aún la lee
+    st77xx_async_wait(portMAX_DELAY);
+    st77xx_kernel_fill(dst, color, (size_t)w);
+    if (h == 1) {
+        if (cb) cb(ctx);
+        return ESP_OK;
+    }
+    return st77xx_async_blit(dst + stride, stride, dst, 0, w, h - 1, cb, ctx);
+}
@@ -0,0 +1,322 @@
+/**
+ * @file st77xx_font.c
+ * @brief Render de fuentes ST7F con mezcla alfa en RGB565
+ */
+
+#include "st77xx_font.h"
+#include <string.h>
+#include <limits.h>
+#include "esp_log.h"
+#include "st77xx.h"
+
+static const char* TAG = "st77xx_font";
+
+/** @brief Canales RGB565 separados en 32 bits: G en 21..26, R en 11..15, B en 0..4 */
+#define SPREAD_MASK 0x07E0F81Fu
+
+/**
+ * @brief Tabla de mezcla de un color: un nivel por valor de alfa del glifo
+ */
+typedef struct {
+    uint32_t fg[16];        // Color separado multiplicado por el alfa (0..32)
+    uint8_t inv[16];        // 32 - alfa, peso del fondo
+    uint8_t opaque;         // Nivel que se escribe sin mezclar
+} blend_table_t;
+
+/** @brief Destino: framebuffer completo o franja (filas y0..y0+rows) */
+typedef struct {
+    uint16_t* buf;          // Fila y0 del destino, ancho ST77XX_WIDTH
+    int32_t y0;
+    int32_t rows;
+} font_target_t;
+
+/** @brief Caja cubierta por los glifos dibujados */
+typedef struct {
+    int32_t x, y, w, h;
+} text_box_t;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Apertura
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static bool header_valid(const st7f_header_t* h, size_t size) {
+    if (memcmp(h->magic, ST7F_MAGIC, 4) != 0) return false;
+    if (h->version != ST7F_VERSION || h->header_size != sizeof(st7f_header_t)) return false;
+    if ((h->bpp != 2 && h->bpp != 4) || h->glyph_count == 0 || h->total_size > size) return false;
+
+    // Por resta: offset + count * tamaño puede desbordar uint32_t
+    return h->glyph_offset >= sizeof(st7f_header_t) && h->bitmap_offset <= h->total_size &&
+           h->glyph_offset <= h->bitmap_offset &&
+           h->glyph_count <= (h->bitmap_offset - h->glyph_offset) / sizeof(st7f_glyph_t);
+}
+
+/**
+ * @brief Valida los glifos y construye el índice ASCII
+ */
+static esp_err_t font_index(st77xx_font_t* font) {
+    const st7f_header_t* h = font->header;
+    font->glyphs = (const st7f_glyph_t*)(font->base + h->glyph_offset);
+    font->bitmaps = font->base + h->bitmap_offset;
+    uint32_t bitmap_size = h->total_size - h->bitmap_offset;
+
+    for (size_t i = 0; i < sizeof(font->ascii) / sizeof(font->ascii[0]); i++) {
+        font->ascii[i] = ST7F_NO_GLYPH;
+    }
+
+    for (int i = 0; i < h->glyph_count; i++) {
+        const st7f_glyph_t* g = &font->glyphs[i];
+        uint32_t bytes = (uint32_t)g->height * ((g->width * h->bpp + 7) / 8);
+        if (g->offset > bitmap_size || bytes > bitmap_size - g->offset || (i > 0 && g->codepoint <= font->glyphs[i - 1].codepoint)) {
+            ESP_LOGE(TAG, "Glifo %d inválido", i);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (g->codepoint >= ST7F_ASCII_FIRST && g->codepoint <= ST7F_ASCII_LAST) {
+            font->ascii[g->codepoint - ST7F_ASCII_FIRST] = (uint16_t)i;
+        }
+    }
+
+    ESP_LOGI(TAG, "ST7F: %u glifos, %u bpp, línea %u px, %u bytes",
+             h->glyph_count, h->bpp, h->line_height, (unsigned)h->total_size);
+    return ESP_OK;
+}
+
+esp_err_t st77xx_font_open_mem(const void* data, size_t size, st77xx_font_t* font) {
+    if (!data || !font || size < sizeof(st7f_header_t)) return ESP_ERR_INVALID_ARG;
+    memset(font, 0, sizeof(*font));
+
+    if (!header_valid((const st7f_header_t*)data, size)) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    font->base = (const uint8_t*)data;
+    font->header = (const st7f_header_t*)data;
+
+    esp_err_t ret = font_index(font);
+    if (ret != ESP_OK) memset(font, 0, sizeof(*font));
+    return ret;
+}
+
+esp_err_t st77xx_font_open(const char* label, st77xx_font_t* font) {
+    if (!label || !font) return ESP_ERR_INVALID_ARG;
+    memset(font, 0, sizeof(*font));
+
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        ESP_LOGW(TAG, "Sin partición '%s'", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Leer la cabecera primero para mapear solo lo que ocupa la fuente
+    st7f_header_t header;
+    esp_err_t ret = esp_partition_read(part, 0, &header, sizeof(header));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error leyendo cabecera: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (!header_valid(&header, part->size)) {
+        ESP_LOGW(TAG, "La partición '%s' no contiene una fuente ST7F válida", label);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    const void* base;
+    ret = esp_partition_mmap(part, 0, header.total_size, ESP_PARTITION_MMAP_DATA,
+                             &base, &font->mmap);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error en mmap (%u bytes): %s", (unsigned)header.total_size, esp_err_to_name(ret));
+        return ret;
+    }
+    font->base = (const uint8_t*)base;
+    font->header = (const st7f_header_t*)base;
+    font->mapped = true;
+
+    ret = font_index(font);
+    if (ret != ESP_OK) st77xx_font_close(font);
+    return ret;
+}
+
+void st77xx_font_close(st77xx_font_t* font) {
+    if (!font || !font->base) return;
+    if (font->mapped) esp_partition_munmap(font->mmap);
+    memset(font, 0, sizeof(*font));
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Glifos y métricas
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+const st7f_glyph_t* st77xx_font_glyph(const st77xx_font_t* font, uint32_t codepoint) {
+    if (!font || !font->header) return NULL;
+
+    if (codepoint >= ST7F_ASCII_FIRST && codepoint <= ST7F_ASCII_LAST) {
+        uint16_t i = font->ascii[codepoint - ST7F_ASCII_FIRST];
+        return i == ST7F_NO_GLYPH ? NULL : &font->glyphs[i];
+    }
+
+    // Resto: búsqueda binaria en la tabla ordenada
+    int lo = 0, hi = font->header->glyph_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint32_t cp = font->glyphs[mid].codepoint;
+        if (cp == codepoint) return &font->glyphs[mid];
+        if (cp < codepoint) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+static uint32_t utf8_next(const char** p) {
+    const unsigned char* s = (const unsigned char*)*p;
+    if (!*s) return 0;
+
+    int len = s[0] < 0x80 ? 1 : (s[0] & 0xE0) == 0xC0 ? 2 : (s[0] & 0xF0) == 0xE0 ? 3 :
+              (s[0] & 0xF8) == 0xF0 ? 4 : 0;
+    if (len == 0) {
+        *p += 1;
+        return 0xFFFD;
+    }
+
+    uint32_t cp = len == 1 ? s[0] : s[0] & (0x7F >> len);
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *p += i;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *p += len;
+    return cp;
+}
+
+int32_t st77xx_font_text_width(const st77xx_font_t* font, const char* text) {
+    if (!font || !font->header || !text) return 0;
+
+    int32_t width = 0, max_width = 0;
+    const char* p = text;
+    uint32_t cp;
+    while ((cp = utf8_next(&p)) != 0) {
+        if (cp == '\n') {
+            width = 0;
+            continue;
+        }
+        const st7f_glyph_t* g = st77xx_font_glyph(font, cp);
+        if (g) width += g->advance;
+        if (width > max_width) max_width = width;
+    }
+    return max_width;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Render
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static inline uint32_t spread565(uint16_t c) {
+    return ((uint32_t)c | ((uint32_t)c << 16)) & SPREAD_MASK;
+}
+
+/**
+ * @brief Precalcula el color multiplicado por cada nivel de alfa
+ *
+ * Con fondo b: resultado = (fg[a] + b * inv[a]) >> 5. Los canales separados
+ * tienen hueco para el producto por 32, así que no hay acarreos entre ellos.
+ */
+static void blend_table_init(blend_table_t* t, uint16_t color, uint8_t bpp) {
+    int levels = 1 << bpp;
+    uint32_t fg = spread565(color);
+    for (int i = 0; i < levels; i++) {
+        uint32_t a = (i * 32 + (levels - 1) / 2) / (levels - 1);
+        t->fg[i] = fg * a;
+        t->inv[i] = (uint8_t)(32 - a);
+    }
+    t->opaque = (uint8_t)(levels - 1);
+}
+
+static inline uint16_t blend_pixel(const blend_table_t* t, uint16_t bg, uint8_t level) {
+    uint32_t mix = ((t->fg[level] + spread565(bg) * t->inv[level]) >> 5) & SPREAD_MASK;
+    return (uint16_t)(mix | (mix >> 16));
+}
+
+static void draw_glyph(const font_target_t* tg, const st77xx_font_t* font, const st7f_glyph_t* g,
+                       const blend_table_t* bt, uint16_t color, int32_t gx, int32_t gy) {
+    uint8_t bpp = font->header->bpp;
+    int32_t stride = (g->width * bpp + 7) / 8;
+
+    // Recorte una vez por glifo
+    int32_t c0 = gx < 0 ? -gx : 0;
+    int32_t c1 = gx + g->width > ST77XX_WIDTH ? ST77XX_WIDTH - gx : g->width;
+    int32_t r0 = gy < tg->y0 ? tg->y0 - gy : 0;
+    int32_t r1 = gy + g->height > tg->y0 + tg->rows ? tg->y0 + tg->rows - gy : g->height;
+    if (c0 >= c1 || r0 >= r1) return;
+
+    const uint8_t* src = font->bitmaps + g->offset + r0 * stride;
+    uint16_t* dst = tg->buf + (gy + r0 - tg->y0) * ST77XX_WIDTH + gx;
+    int per_byte = 8 / bpp;
+    uint8_t mask = (uint8_t)((1 << bpp) - 1);
+
+    for (int32_t row = r0; row < r1; row++, src += stride, dst += ST77XX_WIDTH) {
+        for (int32_t col = c0; col < c1; col++) {
+            int shift = 8 - bpp * (col % per_byte + 1);
+            uint8_t level = (src[col / per_byte] >> shift) & mask;
+            if (level == 0) continue;
+            dst[col] = level == bt->opaque ? color : blend_pixel(bt, dst[col], level);
+        }
+    }
+}
+
+/**
+ * @brief Dibuja el texto y devuelve en @p box la caja que cubren los glifos
+ */
+static void draw_text(const font_target_t* tg, const st77xx_font_t* font, const char* text,
+                      int32_t x, int32_t y, uint16_t color, text_box_t* box) {
+    int32_t bx0 = INT32_MAX, by0 = INT32_MAX, bx1 = INT32_MIN, by1 = INT32_MIN;
+    blend_table_t bt;
+    blend_table_init(&bt, color, font->header->bpp);
+
+    int32_t cx = x, cy = y;
+    const char* p = text;
+    uint32_t cp;
+    while ((cp = utf8_next(&p)) != 0) {
+        if (cp == '\n') {
+            cx = x;
+            cy += font->header->line_height;
+            continue;
+        }
+        const st7f_glyph_t* g = st77xx_font_glyph(font, cp);
+        if (!g) continue;
+        if (g->width && g->height) {
+            int32_t gx = cx + g->x_offset, gy = cy + g->y_offset;
+            draw_glyph(tg, font, g, &bt, color, gx, gy);
+            if (gx < bx0) bx0 = gx;
+            if (gy < by0) by0 = gy;
+            if (gx + g->width > bx1) bx1 = gx + g->width;
+            if (gy + g->height > by1) by1 = gy + g->height;
+        }
+        cx += g->advance;
+    }
+
+    if (box) {
+        *box = bx1 > bx0 ? (text_box_t){ bx0, by0, bx1 - bx0, by1 - by0 }
+                         : (text_box_t){ 0, 0, 0, 0 };
+    }
+}
+
+void st77xx_font_draw_text(const st77xx_font_t* font, uint16_t* fb, const char* text,
+                           int32_t x, int32_t y, uint16_t color) {
+    if (!font || !font->header || !fb || !text) return;
+
+    font_target_t tg = { .buf = fb, .y0 = 0, .rows = ST77XX_HEIGHT };
+    text_box_t box;
+    draw_text(&tg, font, text, x, y, color, &box);
+
+    if (box.w > 0 && fb == st77xx_get_draw_buffer()) {
+        st77xx_mark_dirty(box.x, box.y, box.w, box.h);
+    }
+}
+
+void st77xx_font_stripe_draw_text(const st77xx_font_t* font, uint16_t* stripe, int32_t y0,
+                                  int32_t rows, const char* text, int32_t x, int32_t y,
+                                  uint16_t color) {
+    if (!font || !font->header || !stripe || !text || rows <= 0) return;
+
+    font_target_t tg = { .buf = stripe, .y0 = y0, .rows = rows };
+    draw_text(&tg, font, text, x, y, color, NULL);
+}
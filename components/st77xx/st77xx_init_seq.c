@@ -0,0 +1,98 @@
+/**
+ * @file st77xx_init_seq.c
+ * @brief Tabla de inicialización ST77xx y esperas mínimas del datasheet
+ */
+
+#include "st77xx_init_seq.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_rom_sys.h"
+
+#define CMD_SWRESET     0x01
+#define CMD_SLPOUT      0x11
+#define CMD_NORON       0x13
+#define CMD_INVOFF      0x20
+#define CMD_INVON       0x21
+#define CMD_DISPON      0x29
+#define CMD_MADCTL      0x36
+#define CMD_COLMOD      0x3A
+#define CMD_PORCTRL     0xB2
+#define CMD_GCTRL       0xB7
+#define CMD_VCOMS       0xBB
+
+/** @brief Esperas mínimas del datasheet (ST7789V / ST7796S), en µs */
+#define T_RESET_PULSE_US         10         // Pulso bajo de RST
+#define T_RESET_READY_US         5000       // Tras RST o SWRESET con el panel en sleep-in
+#define T_RESET_READY_AWAKE_US   120000     // Ídem si el panel estaba en sleep-out
+#define T_SLPOUT_CMD_US          5000       // SLPOUT -> siguiente comando
+#define T_SLPOUT_DISPON_US       120000     // SLPOUT -> DISPON (alimentación estable)
+
+/** @brief Parámetros como máximo por comando de la tabla */
+#define INIT_PARAM_MAX  5
+
+/** @brief Entrada de la tabla de configuración */
+typedef struct {
+    uint8_t cmd;
+    uint8_t size;
+    uint8_t data[INIT_PARAM_MAX];
+} init_cmd_t;
+
+const st77xx_init_model_t st77xx_init_models[2] = {
+    // MX corrige el espejo horizontal; el ST7796S además va en BGR
+    [ST77XX_PANEL_ST7789]  = { 0x75, 0x2B, { 0x40, 0x20, 0x80, 0xE0 } },
+    [ST77XX_PANEL_ST7796S] = { 0x35, 0x1A, { 0x48, 0x28, 0x88, 0xE8 } },
+};
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void st77xx_init_wait_until(int64_t deadline_us) {
+    int64_t left = deadline_us - esp_timer_get_time();
+    TickType_t ticks = left > 0 ? (TickType_t)(left / (1000 * portTICK_PERIOD_MS)) : 0;
+    if (ticks > 0) vTaskDelay(ticks);
+
+    left = deadline_us - esp_timer_get_time();
+    if (left > 0) esp_rom_delay_us((uint32_t)left);
+}
+
+int64_t st77xx_init_seq_begin(const st77xx_init_target_t* target) {
+    int64_t ready_us = (esp_reset_reason() == ESP_RST_POWERON)
+        ? T_RESET_READY_US : T_RESET_READY_AWAKE_US;
+
+    if (target->pin_rst >= 0) {
+        gpio_set_level(target->pin_rst, 0);
+        esp_rom_delay_us(T_RESET_PULSE_US);
+        gpio_set_level(target->pin_rst, 1);
+    } else {
+        target->tx(target->ctx, CMD_SWRESET, NULL, 0);
+    }
+    st77xx_init_wait_until(esp_timer_get_time() + ready_us);
+
+    target->tx(target->ctx, CMD_SLPOUT, NULL, 0);
+    int64_t t_slpout = esp_timer_get_time();
+    st77xx_init_wait_until(t_slpout + T_SLPOUT_CMD_US);
+
+    const st77xx_init_model_t* m = &st77xx_init_models[target->model];
+    const init_cmd_t table[] = {
+        { CMD_COLMOD,  1, { 0x55 } },                           // RGB565
+        { CMD_MADCTL,  1, { m->madctl[target->orientation & 3] } },
+        { CMD_PORCTRL, 5, { 0x0C, 0x0C, 0x00, 0x33, 0x33 } },
+        { CMD_GCTRL,   1, { m->gctrl } },
+        { CMD_VCOMS,   1, { m->vcoms } },
+        { target->invert ? CMD_INVON : CMD_INVOFF, 0, { 0 } },
+        { CMD_NORON,   0, { 0 } },
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        target->tx(target->ctx, table[i].cmd, table[i].data, table[i].size);
+    }
+    return t_slpout;
+}
+
+void st77xx_init_seq_display_on(const st77xx_init_target_t* target, int64_t t_slpout) {
+    st77xx_init_wait_until(t_slpout + T_SLPOUT_DISPON_US);
+    target->tx(target->ctx, CMD_DISPON, NULL, 0);
+}
@@ -0,0 +1,326 @@
+/**
+ * @file st77xx_kernels.c
+ * @brief Kernels de píxel RGB565 (PIE en ESP32-S3, portables en el resto)
+ */
+
+#include "st77xx_kernels.h"
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "st77xx_kernels";
+
+/** @brief Bytes por acceso vectorial PIE */
+#define PIE_BLOCK 16
+/** @brief Píxeles por iteración del swap PIE (dos registros q) */
+#define PIE_SWAP_PIXELS (2 * PIE_BLOCK / sizeof(uint16_t))
+
+static inline bool aligned(const void* p, uintptr_t a) {
+    return ((uintptr_t)p & (a - 1)) == 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * PIE (ESP32-S3)
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+#if ST77XX_USE_PIE
+
+/**
+ * @brief Rellena @p blocks bloques de 8 píxeles (dst alineado a 16)
+ *
+ * ee.vldbc.16 replica el color en los 8 carriles de q0; cada ee.vst.128.ip
+ * escribe 16 bytes y avanza el puntero.
+ */
+static void pie_fill(uint16_t* dst, uint16_t color, size_t blocks) {
+    if (blocks == 0) return;
+    uint16_t c = color;
+    __asm__ volatile (
+        "ee.vldbc.16     q0, %[c]\n"
+        "1:\n"
+        "ee.vst.128.ip   q0, %[d], 16\n"
+        "addi            %[n], %[n], -1\n"
+        "bnez            %[n], 1b\n"
+        : [d] "+r"(dst), [n] "+r"(blocks)
+        : [c] "r"(&c)
+        : "memory");
+}
+
+/**
+ * @brief Copia @p blocks bloques de 8 píxeles (src y dst alineados a 16)
+ *
+ * Carga y almacenamiento alternan entre q0 y q1 para que la carga del
+ * bloque siguiente no espere al almacenamiento del actual.
+ */
+static void pie_copy(uint16_t* dst, const uint16_t* src, size_t blocks) {
+    if (blocks == 0) return;
+    if (blocks & 1) {
+        __asm__ volatile (
+            "ee.vld.128.ip   q0, %[s], 16\n"
+            "ee.vst.128.ip   q0, %[d], 16\n"
+            : [d] "+r"(dst), [s] "+r"(src)
+            :
+            : "memory");
+        blocks--;
+    }
+    blocks /= 2;
+    if (blocks == 0) return;
+    __asm__ volatile (
+        "1:\n"
+        "ee.vld.128.ip   q0, %[s], 16\n"
+        "ee.vld.128.ip   q1, %[s], 16\n"
+        "ee.vst.128.ip   q0, %[d], 16\n"
+        "ee.vst.128.ip   q1, %[d], 16\n"
+        "addi            %[n], %[n], -1\n"
+        "bnez            %[n], 1b\n"
+        : [d] "+r"(dst), [s] "+r"(src), [n] "+r"(blocks)
+        :
+        : "memory");
+}
+
+/**
+ * @brief Swap de bytes de @p blocks bloques de 16 píxeles (alineados a 16)
+ *
+ * ee.vunzip.8 separa los bytes pares e impares de q0:q1; ee.vzip.8 con los
+ * registros intercambiados los vuelve a intercalar empezando por el impar,
+ * que es el par de bytes de cada píxel invertido.
+ */
+static void pie_swap(uint16_t* dst, const uint16_t* src, size_t blocks) {
+    if (blocks == 0) return;
+    __asm__ volatile (
+        "1:\n"
+        "ee.vld.128.ip   q0, %[s], 16\n"
+        "ee.vld.128.ip   q1, %[s], 16\n"
+        "ee.vunzip.8     q0, q1\n"
+        "ee.vzip.8       q1, q0\n"
+        "ee.vst.128.ip   q1, %[d], 16\n"
+        "ee.vst.128.ip   q0, %[d], 16\n"
+        "addi            %[n], %[n], -1\n"
+        "bnez            %[n], 1b\n"
+        : [d] "+r"(dst), [s] "+r"(src), [n] "+r"(blocks)
+        :
+        : "memory");
+}
+
+#endif
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Relleno y copia
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void st77xx_kernel_fill(uint16_t* dst, uint16_t color, size_t n) {
+    if (!dst || n == 0) return;
+
+#if ST77XX_USE_PIE
+    // Cabeza hasta alinear a 16 bytes, cuerpo vectorial, cola escalar
+    while (n > 0 && !aligned(dst, PIE_BLOCK)) { *dst++ = color; n--; }
+    size_t blocks = n / (PIE_BLOCK / sizeof(uint16_t));
+    pie_fill(dst, color, blocks);
+    dst += blocks * (PIE_BLOCK / sizeof(uint16_t));
+    n -= blocks * (PIE_BLOCK / sizeof(uint16_t));
+#else
+    if (n > 0 && !aligned(dst, 4)) { *dst++ = color; n--; }
+    uint32_t color32 = ((uint32_t)color << 16) | color;
+    uint32_t* ptr32 = (uint32_t*)dst;
+    size_t words = n / 2;
+
+    // Loop unrolling: 8 words por iteración
+    while (words >= 8) {
+        *ptr32++ = color32; *ptr32++ = color32;
+        *ptr32++ = color32; *ptr32++ = color32;
+        *ptr32++ = color32; *ptr32++ = color32;
+        *ptr32++ = color32; *ptr32++ = color32;
+        words -= 8;
+    }
+    while (words--) *ptr32++ = color32;
+    dst = (uint16_t*)ptr32;
+    n %= 2;
+#endif
+
+    while (n--) *dst++ = color;
+}
+
+void st77xx_kernel_fill_rect(uint16_t* dst, int32_t stride, int32_t w, int32_t h, uint16_t color) {
+    if (!dst || w <= 0 || h <= 0) return;
+
+    // Filas contiguas: un único relleno
+    if (stride == w) {
+        st77xx_kernel_fill(dst, color, (size_t)w * h);
+        return;
+    }
+    for (int32_t row = 0; row < h; row++, dst += stride) {
+        st77xx_kernel_fill(dst, color, (size_t)w);
+    }
+}
+
+void st77xx_kernel_copy(uint16_t* dst, const uint16_t* src, size_t n) {
+    if (!dst || !src || n == 0) return;
+
+#if ST77XX_USE_PIE
+    // Solo se vectoriza si origen y destino comparten alineación
+    if (((uintptr_t)dst & (PIE_BLOCK - 1)) == ((uintptr_t)src & (PIE_BLOCK - 1)) &&
+        n >= 2 * (PIE_BLOCK / sizeof(uint16_t))) {
+        while (!aligned(dst, PIE_BLOCK)) { *dst++ = *src++; n--; }
+        size_t blocks = n / (PIE_BLOCK / sizeof(uint16_t));
+        pie_copy(dst, src, blocks);
+        dst += blocks * (PIE_BLOCK / sizeof(uint16_t));
+        src += blocks * (PIE_BLOCK / sizeof(uint16_t));
+        n -= blocks * (PIE_BLOCK / sizeof(uint16_t));
+    }
+#endif
+
+    memcpy(dst, src, n * sizeof(uint16_t));
+}
+
+void st77xx_kernel_blit(uint16_t* dst, int32_t dst_stride, const uint16_t* src,
+                        int32_t src_stride, int32_t w, int32_t h) {
+    if (!dst || !src || w <= 0 || h <= 0) return;
+
+    if (dst_stride == w && src_stride == w) {
+        st77xx_kernel_copy(dst, src, (size_t)w * h);
+        return;
+    }
+    for (int32_t row = 0; row < h; row++, dst += dst_stride, src += src_stride) {
+        st77xx_kernel_copy(dst, src, (size_t)w);
+    }
+}
+
+void st77xx_kernel_blit_key(uint16_t* dst, int32_t dst_stride, const uint16_t* src,
+                            int32_t src_stride, int32_t w, int32_t h, uint16_t key) {
+    if (!dst || !src || w <= 0 || h <= 0) return;
+
+    for (int32_t row = 0; row < h; row++, dst += dst_stride, src += src_stride) {
+        int32_t col = 0;
+        while (col < w) {
+            // Tramos opacos con una sola copia
+            while (col < w && src[col] == key) col++;
+            int32_t start = col;
+            while (col < w && src[col] != key) col++;
+            if (col > start) st77xx_kernel_copy(dst + start, src + start, (size_t)(col - start));
+        }
+    }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Swap de bytes
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void st77xx_kernel_swap(uint16_t* dst, const uint16_t* src, size_t n) {
+    if (!dst || !src || n == 0) return;
+
+#if ST77XX_USE_PIE
+    // Vectorial con la misma alineación; cada bloque se lee entero antes de escribirlo
+    if (((uintptr_t)dst & (PIE_BLOCK - 1)) == ((uintptr_t)src & (PIE_BLOCK - 1)) &&
+        n >= 4 * (PIE_BLOCK / sizeof(uint16_t))) {
+        while (!aligned(dst, PIE_BLOCK)) { *dst++ = __builtin_bswap16(*src++); n--; }
+        size_t blocks = n / PIE_SWAP_PIXELS;
+        pie_swap(dst, src, blocks);
+        dst += blocks * PIE_SWAP_PIXELS;
+        src += blocks * PIE_SWAP_PIXELS;
+        n -= blocks * PIE_SWAP_PIXELS;
+    }
+#endif
+
+    // Dos píxeles por palabra cuando ambos punteros están alineados igual
+    if (((uintptr_t)dst & 3) == ((uintptr_t)src & 3)) {
+        if (!aligned(dst, 4)) {
+            *dst++ = __builtin_bswap16(*src++);
+            n--;
+        }
+        uint32_t* d32 = (uint32_t*)dst;
+        const uint32_t* s32 = (const uint32_t*)src;
+        size_t words = n / 2;
+        while (words >= 4) {
+            uint32_t a = s32[0], b = s32[1], c = s32[2], e = s32[3];
+            d32[0] = ((a & 0x00FF00FFu) << 8) | ((a >> 8) & 0x00FF00FFu);
+            d32[1] = ((b & 0x00FF00FFu) << 8) | ((b >> 8) & 0x00FF00FFu);
+            d32[2] = ((c & 0x00FF00FFu) << 8) | ((c >> 8) & 0x00FF00FFu);
+            d32[3] = ((e & 0x00FF00FFu) << 8) | ((e >> 8) & 0x00FF00FFu);
+            d32 += 4;
+            s32 += 4;
+            words -= 4;
+        }
+        while (words--) {
+            uint32_t a = *s32++;
+            *d32++ = ((a & 0x00FF00FFu) << 8) | ((a >> 8) & 0x00FF00FFu);
+        }
+        dst = (uint16_t*)d32;
+        src = (const uint16_t*)s32;
+        n %= 2;
+    }
+
+    while (n--) *dst++ = __builtin_bswap16(*src++);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Benchmark
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief MB/s de @p bytes procesados en @p us microsegundos
+ */
+static inline uint32_t bench_mbps(size_t bytes, int64_t us) {
+    return us > 0 ? (uint32_t)((uint64_t)bytes / (uint64_t)us) : 0;
+}
+
+/**
+ * @brief Mide un kernel sobre @p pixels píxeles, @p rounds veces
+ */
+#define BENCH_RUN(label, expr) do {                                         \
+        int64_t t0 = esp_timer_get_time();                                  \
+        for (int r = 0; r < rounds; r++) { expr; }                          \
+        int64_t us = esp_timer_get_time() - t0;                             \
+        ESP_LOGI(TAG, "%-22s %5lu MB/s", label,                             \
+                 (unsigned long)bench_mbps(bytes * rounds, us));            \
+    } while (0)
+
+void st77xx_kernel_benchmark(size_t pixels, int rounds) {
+    if (pixels == 0) pixels = ST77XX_DMA_BUFFER_SIZE / sizeof(uint16_t);
+    if (rounds <= 0) rounds = 32;
+    size_t bytes = pixels * sizeof(uint16_t);
+
+    uint16_t* dma = heap_caps_aligned_alloc(PIE_BLOCK, bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    uint16_t* src = heap_caps_aligned_alloc(PIE_BLOCK, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#if ST77XX_USE_PSRAM
+    uint16_t* ext = heap_caps_aligned_alloc(PIE_BLOCK, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    uint16_t* ext = NULL;
+#endif
+    if (!dma || !src) {
+        ESP_LOGE(TAG, "Benchmark: sin memoria para %u bytes", (unsigned)bytes);
+        goto done;
+    }
+    for (size_t i = 0; i < pixels; i++) src[i] = (uint16_t)(i * 2654435761u >> 16);
+
+    ESP_LOGI(TAG, "Kernels %s (%s), %u bytes x %d:", ST77XX_CHIP_NAME,
+             ST77XX_USE_PIE ? "PIE" : "portable", (unsigned)bytes, rounds);
+
+    // Verificación del swap contra la versión byte a byte
+    st77xx_kernel_swap(dma, src, pixels);
+    for (size_t i = 0; i < pixels; i++) {
+        if (dma[i] != (uint16_t)((src[i] >> 8) | (src[i] << 8))) {
+            ESP_LOGE(TAG, "Swap incorrecto en el píxel %u", (unsigned)i);
+            goto done;
+        }
+    }
+
+    BENCH_RUN("fill", st77xx_kernel_fill(dma, 0x1234, pixels));
+    BENCH_RUN("copy int->dma", st77xx_kernel_copy(dma, src, pixels));
+    BENCH_RUN("swap int->dma", st77xx_kernel_swap(dma, src, pixels));
+    BENCH_RUN("swap in place", st77xx_kernel_swap(dma, dma, pixels));
+    BENCH_RUN("swap bytewise", {
+        const uint8_t* s = (const uint8_t*)src;
+        uint8_t* d = (uint8_t*)dma;
+        for (size_t i = 0; i + 1 < bytes; i += 2) { d[i] = s[i + 1]; d[i + 1] = s[i]; }
+    });
+    if (ext) {
+        memcpy(ext, src, bytes);
+        BENCH_RUN("copy psram->dma", st77xx_kernel_copy(dma, ext, pixels));
+        BENCH_RUN("swap psram->dma", st77xx_kernel_swap(dma, ext, pixels));
+    }
+
+done:
+    if (dma) heap_caps_free(dma);
+    if (src) heap_caps_free(src);
+    if (ext) heap_caps_free(ext);
+}
@@ -0,0 +1,369 @@
+/**
+ * @file st77xx_panel.c
+ * @brief Paneles adicionales en el bus SPI y tarea que reparte el bus entre ellos
+ */
+
+#include "st77xx_panel.h"
+#include <string.h>
+#include "st77xx_kernels.h"
+#include "st77xx_transport.h"
+#include "st77xx_init_seq.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char* TAG = "st77xx_panel";
+
+#define CMD_CASET       0x2A
+#define CMD_RASET       0x2B
+#define CMD_RAMWR       0x2C
+#define CMD_MADCTL      0x36
+
+/** @brief Buffers de rebote por panel: se prepara uno mientras sale el otro */
+#define PANEL_BOUNCE_COUNT 2
+
+struct st77xx_panel {
+    st77xx_panel_config_t cfg;
+    spi_device_handle_t dev;
+    uint8_t* bounce[PANEL_BOUNCE_COUNT];
+    spi_transaction_t trans[PANEL_BOUNCE_COUNT];
+    int bounce_next;
+    int pending;
+    SemaphoreHandle_t idle;         // Tomado mientras hay un trabajo en curso
+
+    // Trabajo en curso: lo escribe quien llama, lo consume la tarea del bus
+    volatile bool job_active;
+    bool job_started;
+    const uint16_t* job_src;        // NULL = relleno con job_color
+    uint16_t job_color;             // Ya en orden de bytes del panel
+    st77xx_rect_t job_rect;
+    int32_t job_row;
+};
+
+static struct st77xx_panel* panels[ST77XX_MAX_PANELS] = {0};
+static SemaphoreHandle_t panels_lock = NULL;
+static TaskHandle_t bus_task = NULL;
+static int bus_turn = 0;            // Siguiente panel en el reparto
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Bus
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void panel_wait_one(struct st77xx_panel* p) {
+    if (p->pending == 0) return;
+    spi_transaction_t* done = NULL;
+    if (spi_device_get_trans_result(p->dev, &done, portMAX_DELAY) == ESP_OK) p->pending--;
+}
+
+static void panel_drain(struct st77xx_panel* p) {
+    while (p->pending > 0) panel_wait_one(p);
+}
+
+/**
+ * @brief Comando con parámetros en modo polling
+ *
+ * DC es propio de cada panel: cambiarlo no afecta a transferencias de otro
+ * dispositivo que estén en vuelo, solo hay que vaciar las del panel.
+ */
+static void panel_cmd(struct st77xx_panel* p, uint8_t cmd, const uint8_t* data, size_t size) {
+    panel_drain(p);
+
+    spi_transaction_t t = {0};
+    gpio_set_level(p->cfg.pin_dc, 0);
+    t.length = 8;
+    t.tx_buffer = &cmd;
+    spi_device_polling_transmit(p->dev, &t);
+
+    if (size) {
+        gpio_set_level(p->cfg.pin_dc, 1);
+        memset(&t, 0, sizeof(t));
+        t.length = size * 8;
+        t.tx_buffer = data;
+        spi_device_polling_transmit(p->dev, &t);
+    }
+}
+
+static void panel_init_tx(void* ctx, uint8_t cmd, const uint8_t* data, size_t size) {
+    panel_cmd((struct st77xx_panel*)ctx, cmd, data, size);
+}
+
+static void panel_window(struct st77xx_panel* p, const st77xx_rect_t* r) {
+    uint16_t x0 = r->x0 + p->cfg.x_offset, x1 = r->x1 + p->cfg.x_offset;
+    uint16_t y0 = r->y0 + p->cfg.y_offset, y1 = r->y1 + p->cfg.y_offset;
+    panel_cmd(p, CMD_CASET, (uint8_t[]){ x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF }, 4);
+    panel_cmd(p, CMD_RASET, (uint8_t[]){ y0 >> 8, y0 & 0xFF, y1 >> 8, y1 & 0xFF }, 4);
+    panel_cmd(p, CMD_RAMWR, NULL, 0);
+    gpio_set_level(p->cfg.pin_dc, 1);
+}
+
+/**
+ * @brief Envía una porción del trabajo del panel
+ * @return true si el trabajo ha terminado
+ */
+static bool panel_step(struct st77xx_panel* p) {
+    const st77xx_rect_t* r = &p->job_rect;
+    if (!p->job_started) {
+        panel_window(p, r);
+        p->job_row = r->y0;
+        p->job_started = true;
+    }
+
+    size_t w = (size_t)(r->x1 - r->x0 + 1);
+    int32_t rows = (int32_t)(ST77XX_PANEL_SLICE_BYTES / (w * sizeof(uint16_t)));
+    if (rows > r->y1 - p->job_row + 1) rows = r->y1 - p->job_row + 1;
+
+    // Con el driver principal activo: una transferencia en vuelo
+    while (p->pending >= st77xx_bus_queue_limit(ST77XX_BUS_USER_PANELS) ||
+           p->pending >= PANEL_BOUNCE_COUNT) {
+        panel_wait_one(p);
+    }
+
+    uint16_t* buf = (uint16_t*)p->bounce[p->bounce_next];
+    if (p->job_src) {
+        const uint16_t* src = p->job_src + (size_t)p->job_row * p->cfg.width + r->x0;
+        for (int32_t i = 0; i < rows; i++) {
+            st77xx_kernel_swap(buf + (size_t)i * w, src, w);
+            src += p->cfg.width;
+        }
+    } else {
+        st77xx_kernel_fill(buf, p->job_color, w * rows);
+    }
+
+    spi_transaction_t* t = &p->trans[p->bounce_next];
+    memset(t, 0, sizeof(*t));
+    t->length = w * rows * sizeof(uint16_t) * 8;
+    t->tx_buffer = buf;
+    if (spi_device_queue_trans(p->dev, t, portMAX_DELAY) == ESP_OK) {
+        p->pending++;
+        p->bounce_next = (p->bounce_next + 1) % PANEL_BOUNCE_COUNT;
+    } else {
+        ESP_LOGE(TAG, "Fallo al encolar en el panel CS %d", p->cfg.pin_cs);
+    }
+
+    p->job_row += rows;
+    return p->job_row > r->y1;
+}
+
+/**
+ * @brief Tarea del bus: una porción de cada panel con trabajo, por turnos
+ */
+static void bus_task_main(void* arg) {
+    (void)arg;
+    while (1) {
+        bool active = false;
+        xSemaphoreTake(panels_lock, portMAX_DELAY);
+        for (int n = 0; n < ST77XX_MAX_PANELS; n++) {
+            int i = (bus_turn + n) % ST77XX_MAX_PANELS;
+            struct st77xx_panel* p = panels[i];
+            if (!p || !p->job_active) continue;
+
+            if (panel_step(p)) {
+                panel_drain(p);
+                p->job_active = false;
+                xSemaphoreGive(p->idle);
+            }
+            active = true;
+        }
+        bus_turn = (bus_turn + 1) % ST77XX_MAX_PANELS;
+        xSemaphoreGive(panels_lock);
+
+        // Se reafirma en cada vuelta: un envío puede llegar tras la comprobación
+        st77xx_bus_set_active(ST77XX_BUS_USER_PANELS, active);
+        if (!active) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+static bool bus_task_start(void) {
+    if (bus_task) return true;
+    panels_lock = xSemaphoreCreateMutex();
+    if (!panels_lock) return false;
+    if (xTaskCreatePinnedToCore(bus_task_main, "st77xx_bus", ST77XX_BUS_TASK_STACK, NULL,
+                                ST77XX_BUS_TASK_PRIO, &bus_task, ST77XX_FLUSH_TASK_CORE) != pdPASS) {
+        vSemaphoreDelete(panels_lock);
+        panels_lock = NULL;
+        bus_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Entrega un trabajo a la tarea del bus (espera al anterior del panel)
+ */
+static void panel_submit(struct st77xx_panel* p, const uint16_t* src, uint16_t color,
+                         int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > p->cfg.width) w = p->cfg.width - x;
+    if (y + h > p->cfg.height) h = p->cfg.height - y;
+    if (w <= 0 || h <= 0) return;
+
+    xSemaphoreTake(p->idle, portMAX_DELAY);
+    p->job_src = src;
+    p->job_color = (uint16_t)((color >> 8) | (color << 8));
+    p->job_rect = (st77xx_rect_t){ (uint16_t)x, (uint16_t)y,
+                                   (uint16_t)(x + w - 1), (uint16_t)(y + h - 1) };
+    p->job_started = false;
+    p->job_active = true;
+
+    st77xx_bus_set_active(ST77XX_BUS_USER_PANELS, true);
+    xTaskNotifyGive(bus_task);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void panel_free(struct st77xx_panel* p) {
+    if (p->dev) spi_bus_remove_device(p->dev);
+    for (int i = 0; i < PANEL_BOUNCE_COUNT; i++) {
+        if (p->bounce[i]) heap_caps_free(p->bounce[i]);
+    }
+    if (p->idle) vSemaphoreDelete(p->idle);
+    heap_caps_free(p);
+}
+
+esp_err_t st77xx_panel_create(const st77xx_panel_config_t* config, st77xx_handle_t* out) {
+    if (!config || !out || config->width == 0 || config->height == 0 ||
+        (unsigned)config->model > ST77XX_PANEL_ST7796S ||
+        config->width * sizeof(uint16_t) > ST77XX_PANEL_SLICE_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ST77XX_BUS_I80 || !st77xx_get_info().initialized) return ESP_ERR_INVALID_STATE;
+    if (!bus_task_start()) return ESP_ERR_NO_MEM;
+
+    struct st77xx_panel* p = heap_caps_calloc(1, sizeof(*p), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!p) return ESP_ERR_NO_MEM;
+    p->cfg = *config;
+    if (p->cfg.spi_speed_hz == 0) p->cfg.spi_speed_hz = ST77XX_SPI_SPEED_HZ;
+
+    p->idle = xSemaphoreCreateBinary();
+    for (int i = 0; i < PANEL_BOUNCE_COUNT; i++) {
+        p->bounce[i] = heap_caps_malloc(ST77XX_PANEL_SLICE_BYTES, MALLOC_CAP_DMA);
+    }
+    if (!p->idle || !p->bounce[0] || !p->bounce[1]) {
+        panel_free(p);
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(p->idle);
+
+    uint64_t outputs = 1ULL << p->cfg.pin_dc;
+    if (p->cfg.pin_rst >= 0) outputs |= 1ULL << p->cfg.pin_rst;
+    if (p->cfg.pin_bl >= 0) outputs |= 1ULL << p->cfg.pin_bl;
+    gpio_config_t io_conf = {
+        .pin_bit_mask = outputs,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    gpio_config(&io_conf);
+
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = (int)p->cfg.spi_speed_hz,
+        .mode = 0,
+        .spics_io_num = p->cfg.pin_cs,
+        .queue_size = PANEL_BOUNCE_COUNT,
+        .flags = SPI_DEVICE_NO_DUMMY
+    };
+    esp_err_t ret = spi_bus_add_device(ST77XX_SPI_HOST, &devcfg, &p->dev);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo al añadir panel CS %d: %s", p->cfg.pin_cs, esp_err_to_name(ret));
+        p->dev = NULL;
+        panel_free(p);
+        return ret;
+    }
+
+    // La misma secuencia y esperas que st77xx_init()
+    const st77xx_init_target_t target = {
+        .tx = panel_init_tx,
+        .ctx = p,
+        .model = p->cfg.model,
+        .orientation = p->cfg.orientation,
+        .invert = p->cfg.invert,
+        .pin_rst = p->cfg.pin_rst,
+    };
+    st77xx_init_seq_display_on(&target, st77xx_init_seq_begin(&target));
+    if (p->cfg.pin_bl >= 0) gpio_set_level(p->cfg.pin_bl, 1);
+
+    xSemaphoreTake(panels_lock, portMAX_DELAY);
+    int slot = -1;
+    for (int i = 0; i < ST77XX_MAX_PANELS && slot < 0; i++) {
+        if (!panels[i]) slot = i;
+    }
+    if (slot >= 0) panels[slot] = p;
+    xSemaphoreGive(panels_lock);
+    if (slot < 0) {
+        panel_free(p);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Panel %s %ux%u en CS %d, %lu MHz",
+             p->cfg.model == ST77XX_PANEL_ST7789 ? "ST7789" : "ST7796S",
+             p->cfg.width, p->cfg.height, p->cfg.pin_cs,
+             (unsigned long)(p->cfg.spi_speed_hz / 1000000));
+    *out = p;
+    return ESP_OK;
+}
+
+void st77xx_panel_delete(st77xx_handle_t panel) {
+    if (!panel) return;
+    st77xx_panel_wait(panel);
+
+    xSemaphoreTake(panels_lock, portMAX_DELAY);
+    for (int i = 0; i < ST77XX_MAX_PANELS; i++) {
+        if (panels[i] == panel) panels[i] = NULL;
+    }
+    xSemaphoreGive(panels_lock);
+    panel_free(panel);
+}
+
+void st77xx_panel_flush(st77xx_handle_t panel, const uint16_t* fb) {
+    if (!panel || !fb) return;
+    panel_submit(panel, fb, 0, 0, 0, panel->cfg.width, panel->cfg.height);
+}
+
+void st77xx_panel_flush_rect(st77xx_handle_t panel, const uint16_t* fb,
+                             int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (!panel || !fb) return;
+    panel_submit(panel, fb, 0, x, y, w, h);
+}
+
+void st77xx_panel_fill_rect(st77xx_handle_t panel, int32_t x, int32_t y,
+                            int32_t w, int32_t h, uint16_t color) {
+    if (!panel) return;
+    panel_submit(panel, NULL, color, x, y, w, h);
+}
+
+void st77xx_panel_wait(st77xx_handle_t panel) {
+    if (!panel) return;
+    xSemaphoreTake(panel->idle, portMAX_DELAY);
+    xSemaphoreGive(panel->idle);
+}
+
+void st77xx_panel_set_orientation(st77xx_handle_t panel, st77xx_orientation_t orientation) {
+    if (!panel) return;
+    // Con el semáforo tomado la tarea del bus no toca el panel
+    xSemaphoreTake(panel->idle, portMAX_DELAY);
+    if ((panel->cfg.orientation ^ orientation) & 1) {
+        // Entre vertical y horizontal (MV) se intercambian filas y columnas
+        uint16_t t = panel->cfg.width;
+        panel->cfg.width = panel->cfg.height;
+        panel->cfg.height = t;
+        t = panel->cfg.x_offset;
+        panel->cfg.x_offset = panel->cfg.y_offset;
+        panel->cfg.y_offset = t;
+    }
+    panel->cfg.orientation = orientation;
+    panel_cmd(panel, CMD_MADCTL, &st77xx_init_models[panel->cfg.model].madctl[orientation & 3], 1);
+    xSemaphoreGive(panel->idle);
+}
+
+void st77xx_panel_backlight(st77xx_handle_t panel, bool on) {
+    if (!panel || panel->cfg.pin_bl < 0) return;
+    gpio_set_level(panel->cfg.pin_bl, on ? 1 : 0);
+}
@@ -0,0 +1,261 @@
+/**
+ * @file st77xx_scale.c
+ * @brief Blit escalado con posiciones Q16, rutas enteras y filtro bilineal
+ */
+
+#include "st77xx_scale.h"
+#include <string.h>
+#include "st77xx.h"
+#include "st77xx_kernels.h"
+#include "st77xx_stats.h"
+
+/** @brief Canales RGB565 separados en 32 bits: G en 21..26, R en 11..15, B en 0..4 */
+#define SPREAD_MASK 0x07E0F81Fu
+
+/** @brief Medio píxel en Q16 */
+#define Q16_HALF 0x8000
+
+static inline uint32_t spread(uint16_t c) {
+    return ((uint32_t)c | ((uint32_t)c << 16)) & SPREAD_MASK;
+}
+
+static inline uint16_t unspread(uint32_t c) {
+    return (uint16_t)(c | (c >> 16));
+}
+
+/** @brief Interpola dos colores separados con peso @p w (0..32) para @p b */
+static inline uint32_t lerp(uint32_t a, uint32_t b, uint32_t w) {
+    return ((a * (32 - w) + b * w) >> 5) & SPREAD_MASK;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Geometría
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Posición de origen (Q16) del centro de un píxel de destino
+ *
+ * Se calcula exacta, (d + 1/2) * src / img, en vez de acumular un paso
+ * redondeado: cada columna se evalúa una vez por geometría y cada fila una
+ * vez por fila, así que la división no está en el bucle de píxeles.
+ *
+ * @param d Píxel de destino relativo a la imagen escalada
+ * @param bilinear true para muestrear entre centros de origen
+ */
+static inline int64_t source_q16(int32_t d, int32_t src, int32_t img, bool bilinear) {
+    int64_t f = (((int64_t)(2 * d + 1) * src) << 16) / (2 * (int64_t)img);
+    if (bilinear) {
+        f -= Q16_HALF;
+        if (f < 0) f = 0;
+    }
+    return f;
+}
+
+/**
+ * @brief Índice de origen y peso 0..32 del siguiente, limitado al borde
+ */
+static inline int32_t source_index(int64_t f, int32_t size, uint8_t* frac) {
+    int32_t i = (int32_t)(f >> 16);
+    if (i >= size - 1) {
+        *frac = 0;
+        return size - 1;
+    }
+    *frac = (uint8_t)(((f & 0xFFFF) + 0x400) >> 11);
+    return i;
+}
+
+bool st77xx_scaler_init(st77xx_scaler_t* s, const uint16_t* src, int32_t src_w, int32_t src_h,
+                        int32_t src_stride, int32_t x, int32_t y, int32_t w, int32_t h,
+                        st77xx_fit_t fit, st77xx_filter_t filter, uint16_t background) {
+    if (!s || !src || src_w <= 0 || src_h <= 0 || src_stride < src_w || w <= 0 || h <= 0) {
+        return false;
+    }
+
+    // Área clipeada a pantalla; la imagen se centra en el área sin clipear
+    int32_t ax0 = x < 0 ? 0 : x;
+    int32_t ay0 = y < 0 ? 0 : y;
+    int32_t ax1 = x + w > ST77XX_WIDTH ? ST77XX_WIDTH : x + w;
+    int32_t ay1 = y + h > ST77XX_HEIGHT ? ST77XX_HEIGHT : y + h;
+    if (ax0 >= ax1 || ay0 >= ay1) return false;
+
+    int64_t iw = w, ih = h;
+    bool wider = (int64_t)src_w * h > (int64_t)src_h * w;
+    if (fit == ST77XX_FIT_COVER ? wider : (fit == ST77XX_FIT_CONTAIN && !wider)) {
+        iw = ((int64_t)src_w * h + src_h / 2) / src_h;
+    } else if (fit != ST77XX_FIT_STRETCH) {
+        ih = ((int64_t)src_h * w + src_w / 2) / src_w;
+    }
+    if (iw < 1) iw = 1;
+    if (ih < 1) ih = 1;
+    if (iw > UINT16_MAX || ih > UINT16_MAX || src_w > UINT16_MAX || src_h > UINT16_MAX) return false;
+
+    s->src = src;
+    s->src_w = src_w;
+    s->src_h = src_h;
+    s->src_stride = src_stride;
+    s->area_x = ax0;
+    s->area_y = ay0;
+    s->area_w = ax1 - ax0;
+    s->area_h = ay1 - ay0;
+    s->img_w = (int32_t)iw;
+    s->img_h = (int32_t)ih;
+    s->img_x = x + (w - s->img_w) / 2;
+    s->img_y = y + (h - s->img_h) / 2;
+    s->vis_x0 = s->img_x > ax0 ? s->img_x : ax0;
+    s->vis_y0 = s->img_y > ay0 ? s->img_y : ay0;
+    s->vis_x1 = s->img_x + s->img_w < ax1 ? s->img_x + s->img_w : ax1;
+    s->vis_y1 = s->img_y + s->img_h < ay1 ? s->img_y + s->img_h : ay1;
+    s->background = background;
+
+    s->ratio = 0;
+    for (int k = 1; k <= 4; k *= 2) {
+        if (iw == (int64_t)src_w * k && ih == (int64_t)src_h * k) s->ratio = k;
+    }
+    // A escala 1x el bilineal cae justo en los centros: es una copia
+    s->filter = s->ratio == 1 ? ST77XX_FILTER_NEAREST : filter;
+
+    bool bilinear = s->filter == ST77XX_FILTER_BILINEAR;
+    for (int32_t px = s->vis_x0; px < s->vis_x1; px++) {
+        int32_t i = px - s->vis_x0;
+        int64_t f = source_q16(px - s->img_x, src_w, s->img_w, bilinear);
+        s->col[i] = (uint16_t)source_index(f, src_w, &s->col_frac[i]);
+        if (!bilinear) s->col_frac[i] = 0;
+    }
+    return true;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Filas
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Duplica cada píxel de origen @p k veces (k = 2 o 4)
+ * @param phase Copias del primer píxel ya hechas a la izquierda del span
+ */
+static void span_dup(uint16_t* d, const uint16_t* sp, int32_t n, int32_t phase, int k) {
+    for (; n > 0 && phase; n--) {
+        *d++ = *sp;
+        if (++phase == k) { phase = 0; sp++; }
+    }
+
+    if (((uintptr_t)d & 3) == 0) {
+        uint32_t* w = (uint32_t*)d;
+        if (k == 2) {
+            for (; n >= 2; n -= 2) {
+                uint32_t p = *sp++;
+                *w++ = p | (p << 16);
+            }
+        } else {
+            for (; n >= 4; n -= 4) {
+                uint32_t p = *sp++;
+                p |= p << 16;
+                w[0] = p;
+                w[1] = p;
+                w += 2;
+            }
+        }
+        d = (uint16_t*)w;
+    }
+
+    for (; n > 0; sp++) {
+        for (int j = 0; j < k && n > 0; j++, n--) *d++ = *sp;
+    }
+}
+
+/**
+ * @brief Span bilineal entre las filas de origen @p top y @p bottom
+ */
+static void span_bilinear(const st77xx_scaler_t* s, uint16_t* d, const uint16_t* top,
+                          const uint16_t* bottom, uint32_t fy, int32_t n) {
+    for (int32_t i = 0; i < n; i++) {
+        int32_t c = s->col[i];
+        uint32_t fx = s->col_frac[i];
+        int32_t next = c + (fx ? 1 : 0);
+        uint32_t t = lerp(spread(top[c]), spread(top[next]), fx);
+        if (fy) {
+            uint32_t b = lerp(spread(bottom[c]), spread(bottom[next]), fx);
+            t = lerp(t, b, fy);
+        }
+        d[i] = unspread(t);
+    }
+}
+
+/**
+ * @brief Genera las filas [y0, y0 + rows) dentro del área del escalador
+ * @param buf Fila y0 del destino, ancho ST77XX_WIDTH
+ */
+static void scale_rows(const st77xx_scaler_t* s, uint16_t* buf, int32_t y0, int32_t rows) {
+    int32_t first = y0 > s->area_y ? y0 : s->area_y;
+    int32_t last = y0 + rows < s->area_y + s->area_h ? y0 + rows : s->area_y + s->area_h;
+    int32_t area_x1 = s->area_x + s->area_w;
+    int32_t n = s->vis_x1 - s->vis_x0;
+    bool bilinear = s->filter == ST77XX_FILTER_BILINEAR;
+
+    // Filas consecutivas con el mismo origen se copian de la anterior
+    const uint16_t* prev = NULL;
+    int64_t prev_key = -1;
+
+    for (int32_t row = first; row < last; row++) {
+        uint16_t* line = buf + (size_t)(row - y0) * ST77XX_WIDTH;
+
+        if (n <= 0 || row < s->vis_y0 || row >= s->vis_y1) {
+            st77xx_kernel_fill(line + s->area_x, s->background, (size_t)s->area_w);
+            prev = NULL;
+            continue;
+        }
+        if (s->vis_x0 > s->area_x) {
+            st77xx_kernel_fill(line + s->area_x, s->background, (size_t)(s->vis_x0 - s->area_x));
+        }
+        if (s->vis_x1 < area_x1) {
+            st77xx_kernel_fill(line + s->vis_x1, s->background, (size_t)(area_x1 - s->vis_x1));
+        }
+
+        uint8_t fy;
+        int64_t f = source_q16(row - s->img_y, s->src_h, s->img_h, bilinear);
+        int32_t sy = source_index(f, s->src_h, &fy);
+        if (!bilinear) fy = 0;
+
+        uint16_t* d = line + s->vis_x0;
+        int64_t key = (int64_t)sy * 33 + fy;
+        if (prev && key == prev_key) {
+            st77xx_kernel_copy(d, prev + s->vis_x0, (size_t)n);
+            prev = line;
+            continue;
+        }
+
+        const uint16_t* srow = s->src + (size_t)sy * s->src_stride;
+        if (bilinear) {
+            span_bilinear(s, d, srow, srow + s->src_stride, fy, n);
+        } else if (s->ratio == 1) {
+            st77xx_kernel_copy(d, srow + s->col[0], (size_t)n);
+        } else if (s->ratio) {
+            span_dup(d, srow + s->col[0], n, (s->vis_x0 - s->img_x) & (s->ratio - 1), s->ratio);
+        } else {
+            for (int32_t i = 0; i < n; i++) d[i] = srow[s->col[i]];
+        }
+        prev = line;
+        prev_key = key;
+    }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void st77xx_blit_scaled(uint16_t* fb, const st77xx_scaler_t* s) {
+    if (!fb || !s) return;
+    int64_t t0 = st77xx_stats_begin();
+    scale_rows(s, fb, 0, ST77XX_HEIGHT);
+    st77xx_stats_end(ST77XX_STAGE_SCALE, t0);
+    if (fb == st77xx_get_draw_buffer()) {
+        st77xx_mark_dirty(s->area_x, s->area_y, s->area_w, s->area_h);
+    }
+}
+
+void st77xx_stripe_blit_scaled(uint16_t* stripe, int32_t y0, int32_t rows,
+                               const st77xx_scaler_t* s) {
+    if (!stripe || !s || rows <= 0) return;
+    int64_t t0 = st77xx_stats_begin();
+    scale_rows(s, stripe, y0, rows);
+    st77xx_stats_end(ST77XX_STAGE_SCALE, t0);
+}
@@ -0,0 +1,299 @@
+/**
+ * @file st77xx_spi_tune.c
+ * @brief Calibración del reloj SPI con lectura RAMRD y persistencia en NVS
+ *
+ * El formato de RAMRD depende del controlador (ciclo dummy, píxeles de 18
+ * bits), así que no se decodifica: cada patrón se escribe una vez con el
+ * reloj de lectura como referencia y después con el reloj candidato, y se
+ * compara lo que devuelve el panel en ambos casos, siempre leído a
+ * ST77XX_SPI_READ_HZ. Un reloj es fiable si todos los patrones coinciden.
+ */
+
+#include "st77xx_transport.h"
+
+#if ST77XX_SPI_AUTOTUNE
+
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+static const char* TAG = "st77xx_tune";
+
+#define CMD_CASET       0x2A
+#define CMD_RASET       0x2B
+#define CMD_RAMWR       0x2C
+#define CMD_RAMRD       0x2E
+
+/** @brief Fila de prueba: primeros TUNE_PIXELS píxeles de la fila 0 */
+#define TUNE_PIXELS     128
+#define TUNE_TX_BYTES   (TUNE_PIXELS * 2)
+#define TUNE_RX_BYTES   (TUNE_PIXELS * 3 + 2)   // RGB666 + dummy + margen
+#define TUNE_PATTERNS   3
+#define TUNE_ROUNDS     2                       // Pasadas por reloj candidato
+#define TUNE_MIN_HZ     (10 * 1000 * 1000)
+
+#define TUNE_NVS_NAMESPACE "st77xx"
+#define TUNE_NVS_KEY_HZ    "spi_hz"
+#define TUNE_NVS_KEY_SIG   "spi_sig"
+
+static const st77xx_transport_t* const transport = &ST77XX_TRANSPORT;
+
+static uint8_t* tune_tx = NULL;
+static uint8_t* tune_rx = NULL;
+static uint8_t* tune_ref[TUNE_PATTERNS] = {0};
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Patrones y lectura
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Genera el patrón @p k: alternancia máxima, bloques y pseudoaleatorio
+ */
+static void tune_pattern(int k, uint8_t* buf) {
+    uint32_t seed = 0x2545F491u;
+    for (int i = 0; i < TUNE_TX_BYTES; i++) {
+        switch (k) {
+            case 0:  buf[i] = (i & 1) ? 0x55 : 0xAA; break;
+            case 1:  buf[i] = (i & 2) ? 0x00 : 0xFF; break;
+            default:
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                buf[i] = (uint8_t)seed;
+                break;
+        }
+    }
+}
+
+static void tune_window(void) {
+    uint16_t x0 = ST77XX_X_OFFSET, x1 = ST77XX_X_OFFSET + TUNE_PIXELS - 1;
+    uint16_t y = ST77XX_Y_OFFSET;
+    transport->tx_cmd(CMD_CASET);
+    transport->tx_param((const uint8_t[]){ x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF }, 4);
+    transport->tx_cmd(CMD_RASET);
+    transport->tx_param((const uint8_t[]){ y >> 8, y & 0xFF, y >> 8, y & 0xFF }, 4);
+}
+
+/**
+ * @brief Escribe tune_tx con el reloj @p hz y lo lee en tune_rx
+ */
+static bool tune_roundtrip(uint32_t hz) {
+    if (transport->set_clock(hz) != ESP_OK) return false;
+    tune_window();
+    transport->tx_cmd(CMD_RAMWR);
+    transport->tx_param(tune_tx, TUNE_TX_BYTES);
+
+    if (transport->set_clock(ST77XX_SPI_READ_HZ) != ESP_OK) return false;
+    tune_window();
+    memset(tune_rx, 0, TUNE_RX_BYTES);
+    return transport->rx_param(CMD_RAMRD, tune_rx, TUNE_RX_BYTES) == ESP_OK;
+}
+
+/**
+ * @brief Compara con la referencia sin el primer byte (ciclo dummy en alta impedancia)
+ */
+static inline bool tune_matches(const uint8_t* ref) {
+    return memcmp(tune_rx + 1, ref + 1, TUNE_RX_BYTES - 1) == 0;
+}
+
+/**
+ * @brief Lee las referencias y comprueba que MISO devuelve la GRAM
+ *
+ * Sin panel respondiendo la línea queda fija o flotante: las lecturas
+ * serían constantes, iguales entre patrones o distintas entre repeticiones.
+ */
+static bool tune_reference(void) {
+    for (int k = 0; k < TUNE_PATTERNS; k++) {
+        tune_pattern(k, tune_tx);
+        if (!tune_roundtrip(ST77XX_SPI_READ_HZ)) return false;
+        memcpy(tune_ref[k], tune_rx, TUNE_RX_BYTES);
+        if (!tune_roundtrip(ST77XX_SPI_READ_HZ) || !tune_matches(tune_ref[k])) return false;
+    }
+
+    bool flat = true;
+    for (int i = 2; i < TUNE_RX_BYTES && flat; i++) {
+        flat = tune_ref[0][i] == tune_ref[0][1];
+    }
+    return !flat && memcmp(tune_ref[0] + 1, tune_ref[1] + 1, TUNE_RX_BYTES - 1) != 0;
+}
+
+/**
+ * @brief Todos los patrones sobreviven a TUNE_ROUNDS escrituras a @p hz
+ */
+static bool tune_probe(uint32_t hz) {
+    for (int round = 0; round < TUNE_ROUNDS; round++) {
+        for (int k = 0; k < TUNE_PATTERNS; k++) {
+            tune_pattern(k, tune_tx);
+            if (!tune_roundtrip(hz) || !tune_matches(tune_ref[k])) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Siguiente reloj candidato por encima de @p above, 0 si no quedan
+ *
+ * Divisores enteros de 80 MHz más el reloj de Kconfig, que ya se sabe que
+ * funciona, entre TUNE_MIN_HZ y ST77XX_SPI_TUNE_MAX_HZ.
+ */
+static uint32_t tune_next(uint32_t above) {
+    uint32_t next = 0;
+    for (int div = 0; div <= 8; div++) {
+        uint32_t hz = div ? (80 * 1000 * 1000) / div : ST77XX_SPI_SPEED_HZ;
+        if (hz <= above || hz < TUNE_MIN_HZ || hz > ST77XX_SPI_TUNE_MAX_HZ) continue;
+        if (next == 0 || hz < next) next = hz;
+    }
+    return next;
+}
+
+/**
+ * @brief Sube por los candidatos hasta el primer fallo
+ * @return Reloj más rápido fiable, 0 si falla ya el primero
+ */
+static uint32_t tune_search(void) {
+    uint32_t best = 0;
+    for (uint32_t hz = tune_next(0); hz; hz = tune_next(hz)) {
+        if (!tune_probe(hz)) {
+            ESP_LOGI(TAG, "%lu kHz: fallo", (unsigned long)(hz / 1000));
+            break;
+        }
+        ESP_LOGD(TAG, "%lu kHz: OK", (unsigned long)(hz / 1000));
+        best = hz;
+    }
+    return best;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * NVS
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Firma de la configuración: otro modelo, pines o tope invalidan el valor
+ */
+static uint32_t tune_signature(void) {
+    const uint32_t fields[] = {
+        ST77XX_WIDTH, ST77XX_HEIGHT, ST77XX_PIN_SCLK, ST77XX_PIN_MOSI,
+        ST77XX_PIN_MISO, ST77XX_PIN_CS, ST77XX_SPI_TUNE_MAX_HZ
+    };
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        h = (h ^ fields[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool tune_nvs_open(nvs_open_mode_t mode, nvs_handle_t* handle) {
+    esp_err_t ret = nvs_flash_init();
+    if (ret != ESP_OK) {
+        // No se borra la partición: puede contener datos de la aplicación
+        ESP_LOGW(TAG, "NVS no disponible: %s", esp_err_to_name(ret));
+        return false;
+    }
+    return nvs_open(TUNE_NVS_NAMESPACE, mode, handle) == ESP_OK;
+}
+
+static bool tune_load(uint32_t* hz) {
+    nvs_handle_t handle;
+    if (!tune_nvs_open(NVS_READONLY, &handle)) return false;
+    uint32_t sig = 0;
+    bool ok = nvs_get_u32(handle, TUNE_NVS_KEY_SIG, &sig) == ESP_OK &&
+              sig == tune_signature() &&
+              nvs_get_u32(handle, TUNE_NVS_KEY_HZ, hz) == ESP_OK;
+    nvs_close(handle);
+    return ok;
+}
+
+static void tune_save(uint32_t hz) {
+    nvs_handle_t handle;
+    if (!tune_nvs_open(NVS_READWRITE, &handle)) return;
+    nvs_set_u32(handle, TUNE_NVS_KEY_HZ, hz);
+    nvs_set_u32(handle, TUNE_NVS_KEY_SIG, tune_signature());
+    if (nvs_commit(handle) != ESP_OK) ESP_LOGW(TAG, "No se pudo guardar el reloj en NVS");
+    nvs_close(handle);
+}
+
+void st77xx_spi_tune_forget(void) {
+    nvs_handle_t handle;
+    if (!tune_nvs_open(NVS_READWRITE, &handle)) return;
+    nvs_erase_key(handle, TUNE_NVS_KEY_HZ);
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Calibración
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void tune_free(void) {
+    heap_caps_free(tune_tx);
+    heap_caps_free(tune_rx);
+    tune_tx = NULL;
+    tune_rx = NULL;
+    for (int k = 0; k < TUNE_PATTERNS; k++) {
+        heap_caps_free(tune_ref[k]);
+        tune_ref[k] = NULL;
+    }
+}
+
+uint32_t st77xx_spi_tune_run(bool force) {
+    if (!transport->set_clock || !transport->rx_param) return 0;
+
+    uint32_t initial = transport->get_clock();
+    tune_tx = heap_caps_malloc(TUNE_TX_BYTES, MALLOC_CAP_DMA);
+    tune_rx = heap_caps_malloc(TUNE_RX_BYTES, MALLOC_CAP_DMA);
+    bool alloc_ok = tune_tx && tune_rx;
+    for (int k = 0; k < TUNE_PATTERNS; k++) {
+        tune_ref[k] = heap_caps_malloc(TUNE_RX_BYTES, MALLOC_CAP_DMA);
+        alloc_ok = alloc_ok && tune_ref[k];
+    }
+    if (!alloc_ok) {
+        ESP_LOGE(TAG, "Sin memoria DMA para calibrar");
+        tune_free();
+        return 0;
+    }
+
+    uint32_t hz = 0;
+    if (!tune_reference()) {
+        ESP_LOGW(TAG, "RAMRD no responde por MISO: se mantiene %lu MHz",
+                 (unsigned long)(initial / 1000000));
+    } else {
+        uint32_t stored = 0;
+        if (!force && tune_load(&stored) && tune_probe(stored)) {
+            hz = stored;
+            ESP_LOGI(TAG, "Reloj guardado verificado: %lu kHz", (unsigned long)(hz / 1000));
+        } else {
+            hz = tune_search();
+            if (hz) {
+                tune_save(hz);
+                ESP_LOGI(TAG, "Reloj calibrado: %lu kHz (%lu KB/s)",
+                         (unsigned long)(hz / 1000), (unsigned long)(hz / 8 / 1024));
+            } else {
+                // No se guarda nada: el próximo arranque vuelve a calibrar
+                ESP_LOGW(TAG, "Ningún reloj candidato es fiable: se mantiene %lu kHz",
+                         (unsigned long)(initial / 1000));
+            }
+        }
+    }
+
+    // Fila de prueba en negro, ya con el reloj definitivo
+    bool applied = hz && transport->set_clock(hz) == ESP_OK;
+    if (!applied) {
+        hz = 0;
+        applied = transport->set_clock(initial) == ESP_OK;
+    }
+    if (applied) {
+        memset(tune_tx, 0, TUNE_TX_BYTES);
+        tune_window();
+        transport->tx_cmd(CMD_RAMWR);
+        transport->tx_param(tune_tx, TUNE_TX_BYTES);
+    } else {
+        ESP_LOGE(TAG, "No se pudo volver a %lu kHz", (unsigned long)(initial / 1000));
+    }
+
+    tune_free();
+    return hz;
+}
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * @file st77xx_stats.c
+ * @brief Histogramas de tiempo por etapa y contadores del bus
+ */
+
+#include "st77xx_stats.h"
+
+#if ST77XX_USE_STATS
+
+#include <string.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char* TAG = "st77xx_stats";
+
+/** @brief Buckets: 0..3 exactos y 4 por octava hasta 2^25 us (~33 s) */
+#define HIST_BUCKETS 100
+
+/** @brief Nombres en el log, en el orden de st77xx_stage_t */
+static const char* const stage_names[ST77XX_STAGE_COUNT] = {
+    "file", "decode", "scale", "swap", "spi", "window", "delay", "frame"
+};
+
+/** @brief Una etapa: acumulado del frame en curso y resumen de la ventana */
+typedef struct {
+    uint32_t pending_us;
+    bool pending;
+    uint32_t frames;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint16_t hist[HIST_BUCKETS];
+} stage_acc_t;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static stage_acc_t stages[ST77XX_STAGE_COUNT];
+static uint64_t bus_bytes = 0;
+static uint32_t bus_transactions = 0;
+static uint64_t bus_bytes_total = 0;
+static uint32_t pace_count[ST77XX_PACE_DROPPED + 1];
+static uint64_t pace_content_us = 0;
+static int64_t window_start_us = 0;
+static int64_t last_frame_us = 0;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Histograma
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static inline int bucket_of(uint32_t us) {
+    if (us < 4) return (int)us;
+    int msb = 31 - __builtin_clz(us);
+    int i = 4 * (msb - 1) + (int)((us >> (msb - 2)) & 3);
+    return i < HIST_BUCKETS ? i : HIST_BUCKETS - 1;
+}
+
+/** @brief Primer valor del bucket @p i */
+static inline uint32_t bucket_floor(int i) {
+    if (i < 4) return (uint32_t)i;
+    return (uint32_t)(4 + (i & 3)) << (i / 4 - 1);
+}
+
+/**
+ * @brief Cuenta una muestra (dentro de stats_lock)
+ *
+ * Si un bucket se satura se dividen a la mitad todos los de la etapa: la
+ * forma del histograma se conserva y las muestras antiguas pesan menos.
+ */
+static void stage_record(stage_acc_t* st, uint32_t us) {
+    if (st->frames == 0 || us < st->min_us) st->min_us = us;
+    if (us > st->max_us) st->max_us = us;
+    st->frames++;
+    st->sum_us += us;
+
+    uint16_t* b = &st->hist[bucket_of(us)];
+    if (*b == UINT16_MAX) {
+        for (int i = 0; i < HIST_BUCKETS; i++) st->hist[i] >>= 1;
+    }
+    (*b)++;
+}
+
+static uint32_t stage_p99(const stage_acc_t* st) {
+    uint32_t total = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) total += st->hist[i];
+    if (total == 0) return 0;
+
+    // Primer bucket con al menos el 99% de las muestras a su izquierda
+    uint32_t target = total - total / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += st->hist[i];
+        if (seen >= target) {
+            uint32_t upper = i + 1 < HIST_BUCKETS ? bucket_floor(i + 1) - 1 : st->max_us;
+            return upper < st->max_us ? upper : st->max_us;
+        }
+    }
+    return st->max_us;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Medida
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+int64_t st77xx_stats_begin(void) {
+    return esp_timer_get_time();
+}
+
+void st77xx_stats_add(st77xx_stage_t stage, uint32_t us) {
+    if ((unsigned)stage >= ST77XX_STAGE_COUNT) return;
+    portENTER_CRITICAL(&stats_lock);
+    stages[stage].pending_us += us;
+    stages[stage].pending = true;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void st77xx_stats_end(st77xx_stage_t stage, int64_t t0) {
+    int64_t dt = esp_timer_get_time() - t0;
+    st77xx_stats_add(stage, dt > 0 ? (uint32_t)dt : 0);
+}
+
+void st77xx_stats_add_bus(size_t bytes) {
+    portENTER_CRITICAL(&stats_lock);
+    bus_bytes += bytes;
+    bus_bytes_total += bytes;
+    bus_transactions++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void st77xx_stats_add_pace(st77xx_pace_t result, uint32_t delay_us) {
+    if ((unsigned)result > ST77XX_PACE_DROPPED) return;
+    portENTER_CRITICAL(&stats_lock);
+    pace_count[result]++;
+    pace_content_us += delay_us;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void st77xx_stats_frame_end(void) {
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&stats_lock);
+    if (last_frame_us) {
+        stages[ST77XX_STAGE_FRAME].pending_us = (uint32_t)(now - last_frame_us);
+        stages[ST77XX_STAGE_FRAME].pending = true;
+    }
+    last_frame_us = now;
+
+    for (int i = 0; i < ST77XX_STAGE_COUNT; i++) {
+        stage_acc_t* st = &stages[i];
+        if (!st->pending) continue;
+        stage_record(st, st->pending_us);
+        st->pending_us = 0;
+        st->pending = false;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Consulta
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void st77xx_get_stats(st77xx_stats_t* out) {
+    if (!out) return;
+
+    portENTER_CRITICAL(&stats_lock);
+    out->bus_bytes = bus_bytes;
+    out->bus_transactions = bus_transactions;
+    out->bus_bytes_total = bus_bytes_total;
+    out->frames_on_time = pace_count[ST77XX_PACE_ON_TIME];
+    out->frames_late = pace_count[ST77XX_PACE_LATE];
+    out->frames_dropped = pace_count[ST77XX_PACE_DROPPED];
+    out->content_us = pace_content_us;
+    int64_t start = window_start_us;
+    portEXIT_CRITICAL(&stats_lock);
+    out->window_us = esp_timer_get_time() - start;
+
+    // Una etapa cada vez bajo el lock; el percentil se calcula fuera
+    for (int i = 0; i < ST77XX_STAGE_COUNT; i++) {
+        stage_acc_t st;
+        portENTER_CRITICAL(&stats_lock);
+        st = stages[i];
+        portEXIT_CRITICAL(&stats_lock);
+
+        st77xx_stage_stats_t* o = &out->stage[i];
+        o->frames = st.frames;
+        o->min_us = st.min_us;
+        o->max_us = st.max_us;
+        o->avg_us = st.frames ? (uint32_t)(st.sum_us / st.frames) : 0;
+        o->p99_us = stage_p99(&st);
+    }
+}
+
+void st77xx_stats_reset(void) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&stats_lock);
+    for (int i = 0; i < ST77XX_STAGE_COUNT; i++) {
+        // Lo acumulado del frame en curso se conserva
+        stage_acc_t* st = &stages[i];
+        st->frames = 0;
+        st->min_us = 0;
+        st->max_us = 0;
+        st->sum_us = 0;
+        memset(st->hist, 0, sizeof(st->hist));
+    }
+    bus_bytes = 0;
+    bus_transactions = 0;
+    memset(pace_count, 0, sizeof(pace_count));
+    pace_content_us = 0;
+    window_start_us = now;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void st77xx_stats_log(void) {
+    st77xx_stats_t s;
+    st77xx_get_stats(&s);
+
+    for (int i = 0; i < ST77XX_STAGE_COUNT; i++) {
+        const st77xx_stage_stats_t* st = &s.stage[i];
+        if (st->frames == 0) continue;
+        ESP_LOGI(TAG, "%-6s n:%lu min:%lu avg:%lu p99:%lu max:%lu us", stage_names[i],
+                 (unsigned long)st->frames, (unsigned long)st->min_us, (unsigned long)st->avg_us,
+                 (unsigned long)st->p99_us, (unsigned long)st->max_us);
+    }
+
+    uint32_t kbps = s.window_us > 0 ? (uint32_t)(s.bus_bytes * 1000 / (uint64_t)s.window_us) : 0;
+    ESP_LOGI(TAG, "Bus: %llu bytes en %lu transacciones, %lu KB/s (total %llu KB)",
+             (unsigned long long)s.bus_bytes, (unsigned long)s.bus_transactions,
+             (unsigned long)kbps, (unsigned long long)(s.bus_bytes_total / 1024));
+
+    // Logrados: frames en pantalla por tiempo real; objetivo: frames por tiempo de contenido
+    uint32_t shown = s.frames_on_time + s.frames_late;
+    uint32_t paced = shown + s.frames_dropped;
+    if (paced == 0 || s.content_us == 0 || s.window_us <= 0) return;
+    ESP_LOGI(TAG, "Ritmo: %.2f fps de %.2f objetivo | deadlines perdidos %lu/%lu, descartados %lu",
+             shown * 1e6 / (double)s.window_us, paced * 1e6 / (double)s.content_us,
+             (unsigned long)s.frames_late, (unsigned long)shown, (unsigned long)s.frames_dropped);
+}
+
+#endif
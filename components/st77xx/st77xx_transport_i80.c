@@ -0,0 +1,182 @@
+/**
+ * @file st77xx_transport_i80.c
+ * @brief Transporte Intel 8080 paralelo (8 o 16 bits) sobre esp_lcd
+ *
+ * El periférico LCD (LCD_CAM en ESP32-S3, I2S en ESP32) genera WR y DC y
+ * envía por DMA. Los datos llegan en el mismo orden de bytes que por SPI:
+ * en 8 bits salen tal cual y en 16 bits el periférico intercambia los dos
+ * bytes de cada palabra, así que el swap y los frames raw no cambian.
+ */
+
+#include "st77xx_transport.h"
+
+#if ST77XX_BUS_I80
+
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_io_i80.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "st77xx_stats.h"
+
+static const char* TAG = "st77xx_i80";
+
+/** @brief Parámetros por transacción de tx_param (el byte va en D0-D7) */
+#define I80_PARAM_CHUNK 16
+
+static esp_lcd_i80_bus_handle_t i80_bus = NULL;
+static esp_lcd_panel_io_handle_t i80_io = NULL;
+static SemaphoreHandle_t i80_done = NULL;
+
+// Trabajos en vuelo en orden de envío: esp_lcd no devuelve cuál terminó
+static st77xx_bus_job_t* i80_fifo[ST77XX_BUS_QUEUE_SIZE];
+static int i80_fifo_head = 0;           // Siguiente hueco al encolar
+static int i80_fifo_tail = 0;           // Siguiente a devolver en wait_one
+#if ST77XX_USE_STATS
+static int i80_fifo_isr = 0;            // Siguiente en terminar
+#endif
+
+/**
+ * @brief Fin de una transferencia de color (ISR)
+ */
+static bool IRAM_ATTR i80_color_done(esp_lcd_panel_io_handle_t io,
+                                     esp_lcd_panel_io_event_data_t* edata, void* ctx) {
+    (void)io;
+    (void)edata;
+    (void)ctx;
+#if ST77XX_USE_STATS
+    i80_fifo[i80_fifo_isr]->done_us = esp_timer_get_time();
+    i80_fifo_isr = (i80_fifo_isr + 1) % ST77XX_BUS_QUEUE_SIZE;
+#endif
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(i80_done, &woken);
+    return woken == pdTRUE;
+}
+
+static void i80_tx_deinit(void) {
+    if (i80_io) {
+        esp_lcd_panel_io_del(i80_io);
+        i80_io = NULL;
+    }
+    if (i80_bus) {
+        esp_lcd_del_i80_bus(i80_bus);
+        i80_bus = NULL;
+    }
+    if (i80_done) {
+        vSemaphoreDelete(i80_done);
+        i80_done = NULL;
+    }
+}
+
+static esp_err_t i80_tx_init(void) {
+    i80_done = xSemaphoreCreateCounting(ST77XX_BUS_QUEUE_SIZE, 0);
+    if (!i80_done) return ESP_ERR_NO_MEM;
+
+    esp_lcd_i80_bus_config_t bus_config = {
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .dc_gpio_num = ST77XX_PIN_DC,
+        .wr_gpio_num = ST77XX_PIN_WR,
+        .data_gpio_nums = ST77XX_I80_DATA_PINS,
+        .bus_width = ST77XX_I80_BUS_WIDTH,
+        .max_transfer_bytes = ST77XX_DMA_BUFFER_SIZE
+    };
+    esp_err_t ret = esp_lcd_new_i80_bus(&bus_config, &i80_bus);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo bus i80: %s", esp_err_to_name(ret));
+        i80_bus = NULL;
+        i80_tx_deinit();
+        return ret;
+    }
+
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = ST77XX_PIN_CS,
+        .pclk_hz = ST77XX_I80_PCLK_HZ,
+        .trans_queue_depth = ST77XX_BUS_QUEUE_SIZE,
+        .on_color_trans_done = i80_color_done,
+        .user_ctx = NULL,
+        .lcd_cmd_bits = ST77XX_I80_BUS_WIDTH,
+        .lcd_param_bits = ST77XX_I80_BUS_WIDTH,
+        .dc_levels = {
+            .dc_idle_level = 0,
+            .dc_cmd_level = 0,
+            .dc_dummy_level = 0,
+            .dc_data_level = 1
+        },
+        .flags = {
+            .swap_color_bytes = (ST77XX_I80_BUS_WIDTH == 16)
+        }
+    };
+    ret = esp_lcd_new_panel_io_i80(i80_bus, &io_config, &i80_io);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo panel IO i80: %s", esp_err_to_name(ret));
+        i80_io = NULL;
+        i80_tx_deinit();
+        return ret;
+    }
+
+    i80_fifo_head = 0;
+    i80_fifo_tail = 0;
+#if ST77XX_USE_STATS
+    i80_fifo_isr = 0;
+#endif
+    ESP_LOGI(TAG, "Bus i80 de %d bits, WR %lu MHz", ST77XX_I80_BUS_WIDTH,
+             (unsigned long)(ST77XX_I80_PCLK_HZ / 1000000));
+    return ESP_OK;
+}
+
+static uint32_t i80_tx_get_clock(void) {
+    return ST77XX_I80_PCLK_HZ;
+}
+
+static void i80_tx_cmd(uint8_t cmd) {
+    esp_lcd_panel_io_tx_param(i80_io, cmd, NULL, 0);
+}
+
+static void i80_tx_param(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t n = size > I80_PARAM_CHUNK ? I80_PARAM_CHUNK : size;
+#if ST77XX_I80_BUS_WIDTH == 16
+        // Un ciclo de WR por parámetro: cada byte ocupa una palabra
+        uint16_t words[I80_PARAM_CHUNK];
+        for (size_t i = 0; i < n; i++) words[i] = data[i];
+        esp_lcd_panel_io_tx_param(i80_io, -1, words, n * sizeof(uint16_t));
+#else
+        esp_lcd_panel_io_tx_param(i80_io, -1, data, n);
+#endif
+        data += n;
+        size -= n;
+    }
+}
+
+static esp_err_t i80_tx_queue(st77xx_bus_job_t* job, const void* data, size_t size) {
+    // Antes de enviar: la ISR puede llegar antes de que tx_color retorne
+    i80_fifo[i80_fifo_head] = job;
+    esp_err_t ret = esp_lcd_panel_io_tx_color(i80_io, -1, data, size);
+    if (ret == ESP_OK) i80_fifo_head = (i80_fifo_head + 1) % ST77XX_BUS_QUEUE_SIZE;
+    return ret;
+}
+
+static st77xx_bus_job_t* i80_tx_wait_one(void) {
+    if (xSemaphoreTake(i80_done, portMAX_DELAY) != pdTRUE) return NULL;
+    st77xx_bus_job_t* job = i80_fifo[i80_fifo_tail];
+    i80_fifo_tail = (i80_fifo_tail + 1) % ST77XX_BUS_QUEUE_SIZE;
+    return job;
+}
+
+const st77xx_transport_t st77xx_transport_i80 = {
+    .name = "i80",
+    .get_clock = i80_tx_get_clock,
+    .init = i80_tx_init,
+    .deinit = i80_tx_deinit,
+    .tx_cmd = i80_tx_cmd,
+    .tx_param = i80_tx_param,
+    .queue = i80_tx_queue,
+    .queue_ctrl = NULL,             // esp_lcd envía los parámetros de forma síncrona
+    .wait_one = i80_tx_wait_one,
+    .set_clock = NULL,
+    .rx_param = NULL                // RD atado a 3V3: sin lectura
+};
+
+#endif
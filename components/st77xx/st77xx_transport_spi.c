@@ -0,0 +1,271 @@
+/**
+ * @file st77xx_transport_spi.c
+ * @brief Transporte SPI de 4 hilos (ST77XX_SPI_HOST, DC por GPIO) y arbitraje del bus
+ */
+
+#include "st77xx_transport.h"
+#include <string.h>
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "st77xx_stats.h"
+
+static const char* TAG = "st77xx_spi";
+
+#define CMD_MODE  0
+#define DATA_MODE 1
+
+/**
+ * @brief Transacción con el nivel de DC que aplica pre_cb
+ *
+ * Cada transacción lleva su propio DC, así que comando, parámetros y
+ * píxeles pueden ir seguidos en la cola sin vaciar el bus entre ellos.
+ */
+typedef struct {
+    spi_transaction_t t;
+    st77xx_bus_job_t* job;
+    int dc;
+} spi_slot_t;
+
+static spi_device_handle_t spi_handle = NULL;
+static uint32_t spi_clock_hz = ST77XX_SPI_SPEED_HZ;
+static spi_slot_t spi_slots[ST77XX_BUS_QUEUE_SIZE];
+static int spi_slot_next = 0;
+static volatile uint32_t bus_users = 0;
+static portMUX_TYPE bus_users_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Inicio de transacción SPI (ISR): DC según la transacción
+ */
+static void IRAM_ATTR spi_pre_cb(spi_transaction_t* trans) {
+    const spi_slot_t* slot = trans->user;
+    gpio_set_level(ST77XX_PIN_DC, slot->dc);
+}
+
+#if ST77XX_USE_STATS
+/**
+ * @brief Fin de transacción SPI (ISR): marca de tiempo para medir el bus
+ */
+static void IRAM_ATTR spi_post_cb(spi_transaction_t* trans) {
+    const spi_slot_t* slot = trans->user;
+    if (slot->job) slot->job->done_us = esp_timer_get_time();
+}
+#endif
+
+/**
+ * @brief Prepara el siguiente descriptor del anillo
+ *
+ * Con como máximo ST77XX_BUS_QUEUE_SIZE trabajos en vuelo y resultados en
+ * orden, el descriptor siguiente siempre está libre.
+ */
+static spi_slot_t* spi_slot_take(st77xx_bus_job_t* job, int dc) {
+    spi_slot_t* slot = &spi_slots[spi_slot_next];
+    memset(&slot->t, 0, sizeof(slot->t));
+    slot->t.user = slot;
+    slot->job = job;
+    slot->dc = dc;
+    return slot;
+}
+
+static esp_err_t spi_slot_queue(spi_slot_t* slot) {
+    esp_err_t ret = spi_device_queue_trans(spi_handle, &slot->t, portMAX_DELAY);
+    if (ret == ESP_OK) spi_slot_next = (spi_slot_next + 1) % ST77XX_BUS_QUEUE_SIZE;
+    return ret;
+}
+
+static esp_err_t spi_add_device(uint32_t hz) {
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = (int)hz,
+        .mode = 0,
+        .spics_io_num = ST77XX_PIN_CS,
+        .queue_size = ST77XX_BUS_QUEUE_SIZE,
+        .pre_cb = spi_pre_cb,
+#if ST77XX_USE_STATS
+        .post_cb = spi_post_cb,
+#endif
+        .flags = SPI_DEVICE_NO_DUMMY
+    };
+    
+    esp_err_t ret = spi_bus_add_device(ST77XX_SPI_HOST, &devcfg, &spi_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo SPI device: %s", esp_err_to_name(ret));
+        spi_handle = NULL;
+        return ret;
+    }
+    spi_clock_hz = hz;
+    spi_slot_next = 0;
+    return ESP_OK;
+}
+
+static esp_err_t spi_tx_init(void) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << ST77XX_PIN_DC,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    gpio_config(&io_conf);
+
+    spi_bus_config_t buscfg = {
+        .mosi_io_num = ST77XX_PIN_MOSI,
+        .miso_io_num = ST77XX_PIN_MISO,
+        .sclk_io_num = ST77XX_PIN_SCLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = ST77XX_DMA_BUFFER_SIZE,
+        .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS
+    };
+
+    esp_err_t ret = spi_bus_initialize(ST77XX_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fallo SPI bus: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = spi_add_device(ST77XX_SPI_SPEED_HZ);
+    if (ret != ESP_OK) {
+        spi_bus_free(ST77XX_SPI_HOST);
+        return ret;
+    }
+    return ESP_OK;
+}
+
+static void spi_tx_deinit(void) {
+    if (!spi_handle) return;
+    spi_bus_remove_device(spi_handle);
+    spi_bus_free(ST77XX_SPI_HOST);
+    spi_handle = NULL;
+}
+
+static uint32_t spi_tx_get_clock(void) {
+    return spi_clock_hz;
+}
+
+/**
+ * @brief Vuelve a añadir el dispositivo con otro reloj (el bus sigue igual)
+ *
+ * Si el reloj nuevo no se acepta se restaura el anterior: el handle nunca
+ * queda a NULL con el driver en marcha.
+ */
+static esp_err_t spi_tx_set_clock(uint32_t hz) {
+    if (hz == spi_clock_hz && spi_handle) return ESP_OK;
+    uint32_t previous = spi_clock_hz;
+    if (spi_handle) spi_bus_remove_device(spi_handle);
+    spi_handle = NULL;
+    
+    esp_err_t ret = spi_add_device(hz);
+    if (ret != ESP_OK && spi_add_device(previous) != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo restaurar el reloj de %lu kHz", (unsigned long)(previous / 1000));
+    }
+    return ret;
+}
+
+static void spi_tx_cmd(uint8_t cmd) {
+    spi_slot_t slot = { .job = NULL, .dc = CMD_MODE };
+    slot.t.length = 8;
+    slot.t.tx_buffer = &cmd;
+    slot.t.user = &slot;
+    spi_device_polling_transmit(spi_handle, &slot.t);
+}
+
+static void spi_tx_param(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t chunk = (size > ST77XX_DMA_BUFFER_SIZE) ? ST77XX_DMA_BUFFER_SIZE : size;
+        spi_slot_t slot = { .job = NULL, .dc = DATA_MODE };
+        slot.t.length = chunk * 8;
+        slot.t.tx_buffer = data;
+        slot.t.user = &slot;
+        spi_device_polling_transmit(spi_handle, &slot.t);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+static esp_err_t spi_tx_queue(st77xx_bus_job_t* job, const void* data, size_t size) {
+    spi_slot_t* slot = spi_slot_take(job, DATA_MODE);
+    slot->t.length = size * 8;
+    slot->t.tx_buffer = data;
+    return spi_slot_queue(slot);
+}
+
+/**
+ * @brief Encola un comando o sus parámetros copiados en la propia transacción
+ */
+static esp_err_t spi_tx_queue_ctrl(st77xx_bus_job_t* job, bool dc, const uint8_t* data, size_t size) {
+    if (size == 0 || size > ST77XX_BUS_CTRL_MAX) return ESP_ERR_INVALID_SIZE;
+    spi_slot_t* slot = spi_slot_take(job, dc ? DATA_MODE : CMD_MODE);
+    slot->t.length = size * 8;
+    slot->t.flags = SPI_TRANS_USE_TXDATA;
+    memcpy(slot->t.tx_data, data, size);
+    return spi_slot_queue(slot);
+}
+
+/**
+ * @brief Lectura: el panel aborta si CS sube entre el comando y los datos
+ */
+static esp_err_t spi_tx_rx_param(uint8_t cmd, uint8_t* data, size_t size) {
+    esp_err_t ret = spi_device_acquire_bus(spi_handle, portMAX_DELAY);
+    if (ret != ESP_OK) return ret;
+    
+    spi_slot_t c = { .job = NULL, .dc = CMD_MODE };
+    c.t.flags = SPI_TRANS_CS_KEEP_ACTIVE;
+    c.t.length = 8;
+    c.t.tx_buffer = &cmd;
+    c.t.user = &c;
+    ret = spi_device_polling_transmit(spi_handle, &c.t);
+    
+    if (ret == ESP_OK) {
+        spi_slot_t r = { .job = NULL, .dc = DATA_MODE };
+        r.t.length = size * 8;
+        r.t.rxlength = size * 8;
+        r.t.rx_buffer = data;
+        r.t.user = &r;
+        ret = spi_device_polling_transmit(spi_handle, &r.t);
+    }
+    spi_device_release_bus(spi_handle);
+    return ret;
+}
+
+static st77xx_bus_job_t* spi_tx_wait_one(void) {
+    spi_transaction_t* done = NULL;
+    if (spi_device_get_trans_result(spi_handle, &done, portMAX_DELAY) != ESP_OK || !done) {
+        return NULL;
+    }
+    return ((const spi_slot_t*)done->user)->job;
+}
+
+const st77xx_transport_t st77xx_transport_spi = {
+    .name = "SPI",
+    .get_clock = spi_tx_get_clock,
+    .init = spi_tx_init,
+    .deinit = spi_tx_deinit,
+    .tx_cmd = spi_tx_cmd,
+    .tx_param = spi_tx_param,
+    .queue = spi_tx_queue,
+    .queue_ctrl = spi_tx_queue_ctrl,
+    .wait_one = spi_tx_wait_one,
+    .set_clock = spi_tx_set_clock,
+    .rx_param = spi_tx_rx_param
+};
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Arbitraje
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void st77xx_bus_set_active(uint32_t user, bool active) {
+    portENTER_CRITICAL(&bus_users_lock);
+    if (active) {
+        bus_users |= user;
+    } else {
+        bus_users &= ~user;
+    }
+    portEXIT_CRITICAL(&bus_users_lock);
+}
+
+int st77xx_bus_queue_limit(uint32_t user) {
+    return (bus_users & ~user) ? 1 : ST77XX_BUS_QUEUE_SIZE;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file anim_player.c
+ * @brief Acceso mapeado al contenedor de animación ST7A
+ */
+
+#include "anim_player.h"
+#include <string.h>
+#include "esp_log.h"
+#include "st77xx.h"
+
+static const char* TAG = "anim";
+
+static bool header_valid(const st7a_header_t* h, uint32_t partition_size)
+{
+    if (memcmp(h->magic, ST7A_MAGIC, 4) != 0) return false;
+    if (h->version != ST7A_VERSION || h->header_size != sizeof(st7a_header_t)) return false;
+    if (h->frame_count == 0 || h->total_size > partition_size) return false;
+
+    // Por resta: offset + count * 12 puede desbordar uint32_t
+    return h->index_offset >= sizeof(st7a_header_t) && h->index_offset <= h->total_size &&
+           h->frame_count <= (h->total_size - h->index_offset) / sizeof(st7a_frame_t);
+}
+
+esp_err_t anim_open(const char* label, anim_t* anim)
+{
+    if (!label || !anim) return ESP_ERR_INVALID_ARG;
+    memset(anim, 0, sizeof(*anim));
+
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        ESP_LOGW(TAG, "Sin partición '%s'", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Leer la cabecera primero para mapear solo lo que ocupa el contenedor
+    st7a_header_t header;
+    esp_err_t ret = esp_partition_read(part, 0, &header, sizeof(header));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error leyendo cabecera: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (!header_valid(&header, part->size)) {
+        ESP_LOGW(TAG, "La partición '%s' no contiene un ST7A válido", label);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    const void* base;
+    ret = esp_partition_mmap(part, 0, header.total_size, ESP_PARTITION_MMAP_DATA,
+                             &base, &anim->mmap);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error en mmap (%u bytes): %s", (unsigned)header.total_size, esp_err_to_name(ret));
+        return ret;
+    }
+
+    anim->base = (const uint8_t*)base;
+    anim->header = (const st7a_header_t*)anim->base;
+    anim->index = (const st7a_frame_t*)(anim->base + header.index_offset);
+
+    // Entradas fuera del contenedor invalidan todo el archivo
+    for (int i = 0; i < header.frame_count; i++) {
+        const st7a_frame_t* f = &anim->index[i];
+        if (f->size == 0 || f->offset > header.total_size || f->size > header.total_size - f->offset) {
+            ESP_LOGE(TAG, "Frame %d fuera del contenedor", i);
+            anim_close(anim);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    ESP_LOGI(TAG, "ST7A: %u frames %ux%u formato %u, %u bytes mapeados",
+             header.frame_count, header.width, header.height, header.format,
+             (unsigned)header.total_size);
+    return ESP_OK;
+}
+
+void anim_close(anim_t* anim)
+{
+    if (!anim || !anim->base) return;
+    esp_partition_munmap(anim->mmap);
+    memset(anim, 0, sizeof(*anim));
+}
+
+int anim_frame_count(const anim_t* anim)
+{
+    return (anim && anim->header) ? anim->header->frame_count : 0;
+}
+
+bool anim_get_frame(const anim_t* anim, int index, anim_frame_t* frame)
+{
+    if (!anim || !anim->header || !frame) return false;
+    if (index < 0 || index >= anim->header->frame_count) return false;
+
+    const st7a_frame_t* f = &anim->index[index];
+    frame->data = anim->base + f->offset;
+    frame->size = f->size;
+    frame->delay_ms = f->delay_ms;
+    frame->flags = f->flags;
+    return true;
+}
+
+int anim_next_index(const anim_t* anim, int index)
+{
+    int count = anim_frame_count(anim);
+    if (count == 0) return 0;
+
+    bool has_loop = count > 1 && (anim->index[count - 1].flags & ST7A_FRAME_LOOP);
+    if (!has_loop) {
+        return (index + 1) % count;
+    }
+    if (index == count - 1) {
+        // Tras el delta de vuelta la pantalla ya muestra el frame 0
+        return count > 2 ? 1 : count - 1;
+    }
+    return index + 1;
+}
+
+int32_t anim_play_span_frame(const anim_frame_t* frame, int32_t width, int32_t height)
+{
+    if (!frame || frame->size < sizeof(st7a_span_frame_t)) return -1;
+
+    const uint8_t* p = frame->data;
+    const uint8_t* end = frame->data + frame->size;
+    const st7a_span_frame_t* hdr = (const st7a_span_frame_t*)p;
+    p += sizeof(*hdr);
+
+    if (frame->flags & ST7A_FRAME_KEY) {
+        st77xx_fill_rect_direct(0, 0, width, height, 0x0000);
+    }
+
+    int32_t pixels = 0;
+    for (int i = 0; i < hdr->rect_count; i++) {
+        if (p + sizeof(st7a_span_rect_t) > end) return -1;
+        const st7a_span_rect_t* r = (const st7a_span_rect_t*)p;
+        p += sizeof(*r);
+
+        if (r->w == 0 || r->h == 0 || r->x + r->w > width || r->y + r->h > height) return -1;
+        int32_t area = (int32_t)r->w * r->h;
+
+        if (r->op == ST7A_SPAN_FILL) {
+            if (p + sizeof(uint16_t) > end) return -1;
+            st77xx_fill_rect_direct(r->x, r->y, r->w, r->h, *(const uint16_t*)p);
+            p += sizeof(uint16_t);
+        } else {
+            size_t bytes = (size_t)area * sizeof(uint16_t);
+            if (p + bytes > end) return -1;
+            st77xx_write_rect_raw(r->x, r->y, r->w, r->h, (const uint16_t*)p);
+            p += bytes;
+        }
+        pixels += area;
+    }
+    return pixels;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file anim_player.h
+ * @brief Contenedor de animación ST7A mapeado desde una partición raw
+ *
+ * El contenedor lo genera tools/st7a_pack.py a partir de spiffs_image y se
+ * flashea en la partición "anim". Se accede con esp_partition_mmap(): los
+ * frames se leen a través de la caché de flash, sin VFS ni copias.
+ *
+ * Formato (little-endian):
+ *   st7a_header_t
+ *   st7a_frame_t[frame_count]      (en header.index_offset)
+ *   datos de cada frame            (alineados a 4 bytes)
+ *
+ * En ST7A_FORMAT_SPAN565 cada frame es una lista de rectángulos que cambian
+ * respecto al anterior (los keyframes, respecto a una pantalla negra):
+ *   st7a_span_frame_t
+ *   por rectángulo: st7a_span_rect_t + datos
+ *     ST7A_SPAN_LITERAL: w*h píxeles RGB565 big-endian
+ *     ST7A_SPAN_FILL:    1 color RGB565 nativo (uint16_t)
+ * La reproducción es un recorrido lineal: cada rectángulo se envía como una
+ * ventana, directamente desde la flash mapeada y sin framebuffer.
+ */
+
+#ifndef ANIM_PLAYER_H
+#define ANIM_PLAYER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#define ST7A_MAGIC   "ST7A"
+#define ST7A_VERSION 1
+
+/** @brief Alineación de los datos de cada frame dentro del contenedor */
+#define ST7A_ALIGN 4
+
+/**
+ * @brief Formato de píxel de los frames
+ */
+typedef enum {
+    ST7A_FORMAT_JPEG = 0,       ///< JPG baseline
+    ST7A_FORMAT_RGB565_BE = 1,  ///< RGB565 en orden del panel (para st77xx_flush_raw)
+    ST7A_FORMAT_SPAN565 = 2,    ///< Rectángulos cambiados entre frames (delta)
+} st7a_format_t;
+
+/** @brief El frame se puede mostrar sin el anterior */
+#define ST7A_FRAME_KEY   0x01
+/** @brief El frame solo contiene cambios respecto al anterior */
+#define ST7A_FRAME_DELTA 0x02
+/** @brief Delta del último frame al primero; sustituye al keyframe al repetir */
+#define ST7A_FRAME_LOOP  0x04
+
+#define ST7A_SPAN_LITERAL 0
+#define ST7A_SPAN_FILL    1
+
+/**
+ * @brief Cabecera del contenedor (24 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    char magic[4];          ///< "ST7A"
+    uint16_t version;       ///< ST7A_VERSION
+    uint16_t header_size;   ///< sizeof(st7a_header_t)
+    uint16_t width;         ///< Ancho de los frames
+    uint16_t height;        ///< Alto de los frames
+    uint8_t format;         ///< st7a_format_t
+    uint8_t flags;          ///< Reservado (0)
+    uint16_t frame_count;   ///< Entradas del índice
+    uint32_t index_offset;  ///< Offset del índice desde el inicio
+    uint32_t total_size;    ///< Tamaño total del contenedor
+} st7a_header_t;
+
+/**
+ * @brief Entrada del índice de frames (12 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t offset;        ///< Offset de los datos desde el inicio
+    uint32_t size;          ///< Bytes de datos
+    uint16_t delay_ms;      ///< Tiempo en pantalla
+    uint8_t flags;          ///< ST7A_FRAME_*
+    uint8_t reserved;
+} st7a_frame_t;
+
+/**
+ * @brief Cabecera de un frame SPAN565
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t rect_count;
+    uint16_t reserved;
+} st7a_span_frame_t;
+
+/**
+ * @brief Rectángulo de un frame SPAN565 (10 bytes + datos)
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t op;            ///< ST7A_SPAN_*
+} st7a_span_rect_t;
+
+/**
+ * @brief Animación abierta (mapeada en memoria)
+ */
+typedef struct {
+    const uint8_t* base;                ///< Inicio del contenedor mapeado
+    const st7a_header_t* header;
+    const st7a_frame_t* index;
+    esp_partition_mmap_handle_t mmap;
+} anim_t;
+
+/**
+ * @brief Frame listo para decodificar o enviar
+ */
+typedef struct {
+    const uint8_t* data;    ///< Datos en flash mapeada (no copiar)
+    size_t size;
+    uint16_t delay_ms;
+    uint8_t flags;
+} anim_frame_t;
+
+/**
+ * @brief Mapea y valida el contenedor de la partición @p label
+ * @param label Etiqueta de la partición (p.ej. "anim")
+ * @param[out] anim Animación abierta
+ * @return ESP_OK, ESP_ERR_NOT_FOUND sin partición, ESP_ERR_INVALID_VERSION
+ *         si el contenido no es un ST7A válido u otro error de mmap
+ */
+esp_err_t anim_open(const char* label, anim_t* anim);
+
+/**
+ * @brief Libera el mapeo
+ */
+void anim_close(anim_t* anim);
+
+/**
+ * @brief Número de frames
+ */
+int anim_frame_count(const anim_t* anim);
+
+/**
+ * @brief Obtiene el frame @p index
+ * @return false si el índice no es válido
+ */
+bool anim_get_frame(const anim_t* anim, int index, anim_frame_t* frame);
+
+/**
+ * @brief Índice del frame que sigue a @p index en la reproducción en bucle
+ *
+ * Si el contenedor termina con un frame ST7A_FRAME_LOOP, éste se reproduce
+ * tras el penúltimo y la siguiente vuelta continúa en el frame 1, sin
+ * volver a enviar el keyframe.
+ */
+int anim_next_index(const anim_t* anim, int index);
+
+/**
+ * @brief Envía al panel un frame SPAN565
+ *
+ * Los keyframes borran la pantalla antes de aplicar los rectángulos.
+ *
+ * @param frame Frame obtenido con anim_get_frame()
+ * @param width, height Dimensiones de la animación (para validar)
+ * @return Píxeles enviados, o -1 si el frame está corrupto
+ */
+int32_t anim_play_span_frame(const anim_frame_t* frame, int32_t width, int32_t height);
+
+#endif // ANIM_PLAYER_H
@@ -0,0 +1,223 @@
+/**
+ * @file frame_pipeline.c
+ * @brief Decodificación en un core y envío al panel en el otro
+ */
+
+#include "frame_pipeline.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "st77xx.h"
+#include "st77xx_async.h"
+
+static const char* TAG = "frame_pipe";
+
+#define FRAME_BYTES ((size_t)ST77XX_WIDTH * ST77XX_HEIGHT * sizeof(uint16_t))
+
+#if ST77XX_USE_PSRAM
+#define FRAME_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define FRAME_CAPS (MALLOC_CAP_8BIT)
+#endif
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Estado
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static frame_pipeline_config_t config;
+static uint16_t* pool[FRAME_PIPELINE_DEPTH];
+static QueueHandle_t free_queue = NULL;   // Buffers listos para decodificar
+static QueueHandle_t ready_queue = NULL;  // Frames listos para mostrar
+static frame_pipeline_stats_t stats;
+static bool running = false;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Tareas
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static void decode_task(void* arg)
+{
+    (void)arg;
+    int index = 0;
+
+    while (1) {
+        uint16_t* frame;
+        if (xQueueReceive(free_queue, &frame, 0) != pdTRUE) {
+            // Todos los buffers en cola o en pantalla: el display va por detrás
+            stats.decode_stalls++;
+            xQueueReceive(free_queue, &frame, portMAX_DELAY);
+        }
+
+        frame_pipeline_frame_t ready = {
+            .buffer = frame,
+            .pixels = frame,
+        };
+        uint32_t delay_ms = config.delay ? config.delay(index, config.ctx) : config.frame_delay_ms;
+        frame_sched_plan(delay_ms, true, &ready.slot);
+        if (ready.slot.skip) {
+            // Su intervalo ya pasó: ni se decodifica ni se envía
+            stats.frames_skipped++;
+            xQueueSend(free_queue, &frame, portMAX_DELAY);
+            index = (index + 1) % config.frame_count;
+            continue;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        bool ok = config.decode(index, &ready, config.ctx) && ready.pixels;
+        stats.decode_us += esp_timer_get_time() - t0;
+
+        if (ok) {
+            stats.frames_decoded++;
+            xQueueSend(ready_queue, &ready, portMAX_DELAY);
+        } else {
+            stats.decode_errors++;
+            xQueueSend(free_queue, &frame, portMAX_DELAY);
+        }
+
+        index = (index + 1) % config.frame_count;
+    }
+}
+
+static void display_task(void* arg)
+{
+    (void)arg;
+
+    while (1) {
+        frame_pipeline_frame_t ready;
+        if (xQueueReceive(ready_queue, &ready, 0) != pdTRUE) {
+            // Cola vacía: la decodificación no da abasto
+            stats.display_stalls++;
+            xQueueReceive(ready_queue, &ready, portMAX_DELAY);
+        }
+
+        // Ocupación tras retirar este frame: cuántos esperaban detrás
+        uint32_t waiting = uxQueueMessagesWaiting(ready_queue);
+        stats.queue_sum += waiting;
+        if (waiting > stats.queue_max) stats.queue_max = waiting;
+
+        // Espera a su pts; si su intervalo ya pasó puede no enviarse
+        bool show = frame_sched_present(&ready.slot);
+        if (show) {
+            // Copias por DMA que decode dejó en vuelo hacia el frame
+            st77xx_async_wait(portMAX_DELAY);
+            int64_t t0 = esp_timer_get_time();
+            st77xx_flush_raw(ready.pixels);
+            stats.flush_us += esp_timer_get_time() - t0;
+        }
+
+        // El panel conserva la imagen en su GRAM: el buffer ya se puede reutilizar
+        if (ready.pixels != ready.buffer && config.release) {
+            config.release(ready.pixels, config.ctx);
+        }
+        xQueueSend(free_queue, &ready.buffer, portMAX_DELAY);
+        if (!show) {
+            stats.frames_dropped++;
+            continue;
+        }
+        stats.frames_shown++;
+        frame_sched_presented(&ready.slot);
+
+        if (stats.frames_shown % config.frame_count == 0) {
+            frame_pipeline_log_stats();
+        }
+    }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+esp_err_t frame_pipeline_start(const frame_pipeline_config_t* cfg)
+{
+    if (!cfg || !cfg->decode || cfg->frame_count <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    config = *cfg;
+
+    free_queue = xQueueCreate(FRAME_PIPELINE_DEPTH, sizeof(uint16_t*));
+    ready_queue = xQueueCreate(FRAME_PIPELINE_DEPTH, sizeof(frame_pipeline_frame_t));
+    if (!free_queue || !ready_queue) {
+        ESP_LOGE(TAG, "No se pudieron crear las colas");
+        goto fail;
+    }
+
+    for (int i = 0; i < FRAME_PIPELINE_DEPTH; i++) {
+        pool[i] = heap_caps_malloc(FRAME_BYTES, FRAME_CAPS);
+        if (!pool[i]) {
+            ESP_LOGE(TAG, "Sin memoria para framebuffer %d (%u bytes)", i, (unsigned)FRAME_BYTES);
+            goto fail;
+        }
+        memset(pool[i], 0, FRAME_BYTES);
+        xQueueSend(free_queue, &pool[i], 0);
+    }
+
+    frame_pipeline_reset_stats();
+    frame_sched_start();
+    running = true;
+
+    // El display espera en ready_queue: si falta la otra tarea se borra sin más
+    TaskHandle_t display = NULL;
+    if (xTaskCreatePinnedToCore(display_task, "frame_disp", FRAME_PIPELINE_DISPLAY_STACK, NULL,
+                                FRAME_PIPELINE_DISPLAY_PRIO, &display,
+                                FRAME_PIPELINE_DISPLAY_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Fallo al crear la tarea de display");
+        goto fail;
+    }
+    if (xTaskCreatePinnedToCore(decode_task, "frame_dec", FRAME_PIPELINE_DECODE_STACK, NULL,
+                                FRAME_PIPELINE_DECODE_PRIO, NULL,
+                                FRAME_PIPELINE_DECODE_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Fallo al crear la tarea de decodificación");
+        vTaskDelete(display);
+        goto fail;
+    }
+
+    ESP_LOGI(TAG, "Pipeline: %d buffers de %u bytes, decode core %d, display core %d",
+             FRAME_PIPELINE_DEPTH, (unsigned)FRAME_BYTES,
+             FRAME_PIPELINE_DECODE_CORE, FRAME_PIPELINE_DISPLAY_CORE);
+    return ESP_OK;
+
+fail:
+    running = false;
+    for (int i = 0; i < FRAME_PIPELINE_DEPTH; i++) {
+        if (pool[i]) {
+            heap_caps_free(pool[i]);
+            pool[i] = NULL;
+        }
+    }
+    if (free_queue) { vQueueDelete(free_queue); free_queue = NULL; }
+    if (ready_queue) { vQueueDelete(ready_queue); ready_queue = NULL; }
+    return ESP_ERR_NO_MEM;
+}
+
+void frame_pipeline_get_stats(frame_pipeline_stats_t* out)
+{
+    if (out) *out = stats;
+}
+
+void frame_pipeline_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void frame_pipeline_log_stats(void)
+{
+    frame_pipeline_stats_t s = stats;
+    if (s.frames_shown == 0) return;
+
+    uint32_t decoded = s.frames_decoded ? s.frames_decoded : 1;
+    ESP_LOGI(TAG, "Frames %lu (err %lu, tarde %lu) | decode %lu us, flush %lu us | "
+                  "stalls dec/disp %lu/%lu | cola media %.2f max %lu",
+             (unsigned long)s.frames_shown, (unsigned long)s.decode_errors,
+             (unsigned long)(s.frames_skipped + s.frames_dropped),
+             (unsigned long)(s.decode_us / decoded),
+             (unsigned long)(s.flush_us / s.frames_shown),
+             (unsigned long)s.decode_stalls, (unsigned long)s.display_stalls,
+             (double)s.queue_sum / s.frames_shown, (unsigned long)s.queue_max);
+}
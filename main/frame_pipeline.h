@@ -0,0 +1,131 @@
+/**
+ * @file frame_pipeline.h
+ * @brief Pipeline productor/consumidor de frames entre los dos cores
+ *
+ * Una tarea de decodificación llena framebuffers de un pool fijo y los pasa
+ * por una cola acotada a una tarea de display que los envía al panel. Cuando
+ * la cola está llena la decodificación espera a que se libere un buffer
+ * (backpressure), así que la memoria nunca crece más allá del pool.
+ *
+ * El ritmo lo marca frame_sched: la decodificación va tan por delante como
+ * permite el pool y el display envía cada frame en su pts.
+ */
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "frame_sched.h"
+
+#ifndef CONFIG_FRAME_PIPELINE_DEPTH
+#define CONFIG_FRAME_PIPELINE_DEPTH 3
+#endif
+
+/** @brief Framebuffers en el pool (decodificando + en cola + en pantalla) */
+#define FRAME_PIPELINE_DEPTH CONFIG_FRAME_PIPELINE_DEPTH
+
+#define FRAME_PIPELINE_DECODE_STACK 6144
+#define FRAME_PIPELINE_DECODE_PRIO  5
+#define FRAME_PIPELINE_DISPLAY_STACK 3072
+#define FRAME_PIPELINE_DISPLAY_PRIO 6
+
+#if CONFIG_FREERTOS_UNICORE
+#define FRAME_PIPELINE_DECODE_CORE  0
+#define FRAME_PIPELINE_DISPLAY_CORE 0
+#else
+#define FRAME_PIPELINE_DECODE_CORE  0
+#define FRAME_PIPELINE_DISPLAY_CORE 1
+#endif
+
+/**
+ * @brief Frame en preparación
+ */
+typedef struct {
+    uint16_t* buffer;           ///< Framebuffer del pool (orden de bytes del panel)
+    const uint16_t* pixels;     ///< Lo que se envía; por defecto buffer
+    frame_sched_slot_t slot;    ///< Intervalo del frame; slot.scale es la reducción pedida
+} frame_pipeline_frame_t;
+
+/**
+ * @brief Prepara el frame @p index
+ *
+ * Lo normal es decodificar en frame->buffer (ST77XX_WIDTH x ST77XX_HEIGHT,
+ * se envía con st77xx_flush_raw()). Si el frame ya existe en otro sitio
+ * (caché, flash mapeada) basta con apuntar frame->pixels a él; el pipeline
+ * llama a release cuando termina de enviarlo. Con frame->slot.scale > 0 la
+ * reproducción va con retraso y conviene decodificar con esa reducción
+ * extra (sin guardar el resultado en cachés). Puede volver con copias de
+ * st77xx_async aún en curso hacia el frame: el display las espera antes
+ * de enviarlo.
+ *
+ * @return false si el frame no se pudo preparar (se descarta)
+ */
+typedef bool (*frame_pipeline_decode_cb_t)(int index, frame_pipeline_frame_t* frame, void* ctx);
+
+/**
+ * @brief Devuelve unos píxeles externos (frame->pixels != frame->buffer)
+ */
+typedef void (*frame_pipeline_release_cb_t)(const uint16_t* pixels, void* ctx);
+
+/**
+ * @brief Tiempo en pantalla del frame @p index, sin decodificarlo
+ */
+typedef uint32_t (*frame_pipeline_delay_cb_t)(int index, void* ctx);
+
+/**
+ * @brief Configuración del pipeline
+ */
+typedef struct {
+    frame_pipeline_decode_cb_t decode;  ///< Decodificador de frames
+    frame_pipeline_release_cb_t release;///< Opcional: libera píxeles externos
+    frame_pipeline_delay_cb_t delay;    ///< Opcional: delay de cada frame
+    void* ctx;                          ///< Contexto para decode/release/delay
+    int frame_count;                    ///< Frames de la animación (se repite)
+    uint32_t frame_delay_ms;            ///< Delay de los frames sin callback delay
+} frame_pipeline_config_t;
+
+/**
+ * @brief Estadísticas acumuladas del pipeline
+ */
+typedef struct {
+    uint32_t frames_decoded;    ///< Frames decodificados con éxito
+    uint32_t frames_shown;      ///< Frames enviados al panel
+    uint32_t decode_errors;     ///< Frames descartados por error de decodificación
+    uint32_t frames_skipped;    ///< Frames sin decodificar por ir con retraso (solo decode)
+    uint32_t frames_dropped;    ///< Frames decodificados sin enviar por ir con retraso (solo display)
+    uint32_t decode_stalls;     ///< Veces que la decodificación esperó un buffer libre
+    uint32_t display_stalls;    ///< Veces que el display esperó un frame listo
+    uint32_t queue_max;         ///< Máxima ocupación observada de la cola
+    uint32_t queue_sum;         ///< Suma de ocupaciones (media = sum / frames_shown)
+    uint64_t decode_us;         ///< Tiempo total decodificando
+    uint64_t flush_us;          ///< Tiempo total enviando al panel
+} frame_pipeline_stats_t;
+
+/**
+ * @brief Reserva el pool y arranca las tareas de decodificación y display
+ * @param cfg Configuración (se copia)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE si ya está
+ *         en marcha o ESP_ERR_NO_MEM
+ */
+esp_err_t frame_pipeline_start(const frame_pipeline_config_t* cfg);
+
+/**
+ * @brief Copia las estadísticas actuales
+ * @param out Destino
+ */
+void frame_pipeline_get_stats(frame_pipeline_stats_t* out);
+
+/**
+ * @brief Pone a cero las estadísticas
+ */
+void frame_pipeline_reset_stats(void);
+
+/**
+ * @brief Imprime un resumen de las estadísticas en el log
+ */
+void frame_pipeline_log_stats(void);
+
+#endif // FRAME_PIPELINE_H
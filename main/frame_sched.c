@@ -0,0 +1,221 @@
+/**
+ * @file frame_sched.c
+ * @brief Línea de tiempo por deadlines con esp_timer y política con retraso
+ */
+
+#include "frame_sched.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "st77xx.h"
+#include "st77xx_stats.h"
+
+static const char* TAG = "frame_sched";
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Estado
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static portMUX_TYPE sched_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t start_us = 0;        // Instante del pts 0; 0 = sin anclar
+static int64_t next_pts_us = 0;     // pts del siguiente frame planificado
+static uint8_t scale = 0;           // Reducción extra vigente (LOWER_SCALE)
+static uint32_t scale_settle = 0;   // Frames desde el último cambio de escala
+static uint32_t ahead_run = 0;      // Frames seguidos planificados antes de su pts
+static esp_timer_handle_t wake_timer = NULL;
+static SemaphoreHandle_t wake_sem = NULL;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Línea de tiempo
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static int64_t timeline_start(void)
+{
+    portENTER_CRITICAL(&sched_lock);
+    int64_t start = start_us;
+    portEXIT_CRITICAL(&sched_lock);
+    return start;
+}
+
+/**
+ * @brief Ancla la línea en el primer frame y la adelanta si va demasiado tarde
+ *
+ * Con un retraso mayor que FRAME_SCHED_MAX_LAG_US (bloqueo de flash, otra
+ * tarea...) recuperar el ritmo supondría una ráfaga de descartes: el frame
+ * pasa a tocar ahora y los siguientes siguen desde él.
+ *
+ * @return Instante absoluto del pts 0
+ */
+static int64_t timeline_sync(const frame_sched_slot_t* slot, int64_t now)
+{
+    int64_t end = slot->pts_us + (int64_t)slot->delay_ms * 1000;
+    int64_t lag = 0;
+
+    portENTER_CRITICAL(&sched_lock);
+    if (start_us == 0) {
+        start_us = now - slot->pts_us;
+    } else if (now - start_us - end > FRAME_SCHED_MAX_LAG_US) {
+        lag = now - start_us - slot->pts_us;
+        start_us += lag;
+    }
+    int64_t start = start_us;
+    portEXIT_CRITICAL(&sched_lock);
+
+    if (lag) {
+        ESP_LOGW(TAG, "Retraso de %lld ms: la reproducción se resincroniza", (long long)(lag / 1000));
+    }
+    return start;
+}
+
+static void wake_cb(void* arg)
+{
+    (void)arg;
+    xSemaphoreGive(wake_sem);
+}
+
+/**
+ * @brief Duerme hasta el instante absoluto @p t_us
+ *
+ * Con un esp_timer de un disparo la espera no se redondea al tick de
+ * FreeRTOS (10 ms a 100 Hz); sin él se usa vTaskDelay().
+ */
+static void wait_until(int64_t t_us)
+{
+    int64_t remain = t_us - esp_timer_get_time();
+    if (remain <= 0) return;
+
+    if (wake_timer) {
+        xSemaphoreTake(wake_sem, 0);   // Aviso de una espera anterior ya vencida
+        if (esp_timer_start_once(wake_timer, (uint64_t)remain) == ESP_OK) {
+            xSemaphoreTake(wake_sem, pdMS_TO_TICKS(remain / 1000) + 2);
+            esp_timer_stop(wake_timer);
+            return;
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS((remain + 999) / 1000));
+}
+
+#if FRAME_SCHED_LATE_LOWER_SCALE
+/**
+ * @brief Escala para un frame que falta @p lead us para su pts
+ *
+ * Reduce un paso si el intervalo ya terminó y lo recupera tras
+ * FRAME_SCHED_RECOVER_FRAMES frames planificados con adelanto. Entre dos
+ * cambios pasan al menos FRAME_SCHED_SETTLE_FRAMES: los frames ya en cola
+ * se decodificaron con la escala anterior.
+ */
+static uint8_t scale_update(int64_t lead, uint32_t delay_ms)
+{
+    if (scale_settle < FRAME_SCHED_SETTLE_FRAMES) scale_settle++;
+
+    if (lead >= 0) {
+        ahead_run++;
+    } else {
+        ahead_run = 0;
+    }
+
+    if (lead <= -(int64_t)delay_ms * 1000 && scale < 3 && scale_settle >= FRAME_SCHED_SETTLE_FRAMES) {
+        scale++;
+        scale_settle = 0;
+        ESP_LOGI(TAG, "Con retraso: decodificación a 1/%d", 1 << scale);
+    } else if (scale > 0 && ahead_run >= FRAME_SCHED_RECOVER_FRAMES) {
+        scale--;
+        scale_settle = 0;
+        ahead_run = 0;
+        ESP_LOGI(TAG, "Ritmo recuperado: decodificación a 1/%d", 1 << scale);
+    }
+    return scale;
+}
+#endif
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * API
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+void frame_sched_start(void)
+{
+    if (!wake_timer) {
+        wake_sem = xSemaphoreCreateBinary();
+        const esp_timer_create_args_t args = {
+            .callback = wake_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "frame_sched",
+        };
+        if (!wake_sem || esp_timer_create(&args, &wake_timer) != ESP_OK) {
+            ESP_LOGW(TAG, "Sin esp_timer: las esperas se redondean al tick");
+            wake_timer = NULL;
+        }
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    start_us = 0;
+    next_pts_us = 0;
+    portEXIT_CRITICAL(&sched_lock);
+    scale = 0;
+    scale_settle = FRAME_SCHED_SETTLE_FRAMES;
+    ahead_run = 0;
+
+    // Sin TE no hace nada; con TE la espera al pts ya marca la cadencia
+    st77xx_set_present_interval(1);
+
+    ESP_LOGI(TAG, "Frames con retraso: %s",
+             FRAME_SCHED_LATE_SKIP_DECODE ? "no se decodifican" :
+             FRAME_SCHED_LATE_LOWER_SCALE ? "se decodifican a menor escala" : "se descartan");
+}
+
+void frame_sched_plan(uint32_t delay_ms, bool droppable, frame_sched_slot_t* slot)
+{
+    slot->pts_us = next_pts_us;
+    slot->delay_ms = delay_ms;
+    slot->scale = 0;
+    slot->droppable = droppable;
+    slot->skip = false;
+    next_pts_us += (int64_t)delay_ms * 1000;
+
+    // Hasta que se presente el primer frame no hay retraso que medir
+    int64_t start = timeline_start();
+    if (start == 0) return;
+
+    int64_t now = esp_timer_get_time();
+#if FRAME_SCHED_LATE_SKIP_DECODE
+    start = timeline_sync(slot, now);
+    if (droppable && now >= start + slot->pts_us + (int64_t)delay_ms * 1000) {
+        slot->skip = true;
+        st77xx_stats_add_pace(ST77XX_PACE_DROPPED, delay_ms * 1000);
+    }
+#elif FRAME_SCHED_LATE_LOWER_SCALE
+    slot->scale = scale_update(start + slot->pts_us - now, delay_ms);
+#else
+    (void)now;
+#endif
+}
+
+bool frame_sched_present(const frame_sched_slot_t* slot)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t due = timeline_sync(slot, now) + slot->pts_us;
+
+#if FRAME_SCHED_LATE_DROP
+    if (slot->droppable && now >= due + (int64_t)slot->delay_ms * 1000) {
+        st77xx_stats_add_pace(ST77XX_PACE_DROPPED, slot->delay_ms * 1000);
+        return false;
+    }
+#endif
+
+    if (due > now) {
+        int64_t t0 = st77xx_stats_begin();
+        wait_until(due);
+        st77xx_stats_end(ST77XX_STAGE_DELAY, t0);
+    }
+    return true;
+}
+
+void frame_sched_presented(const frame_sched_slot_t* slot)
+{
+    int64_t end = timeline_start() + slot->pts_us + (int64_t)slot->delay_ms * 1000;
+    bool late = esp_timer_get_time() > end;
+    st77xx_stats_add_pace(late ? ST77XX_PACE_LATE : ST77XX_PACE_ON_TIME, slot->delay_ms * 1000);
+    st77xx_stats_frame_end();
+}
@@ -0,0 +1,93 @@
+/**
+ * @file frame_sched.h
+ * @brief Reproducción al ritmo del contenido con deadlines absolutos
+ *
+ * Cada frame ocupa un intervalo [pts, pts + delay) de una línea de tiempo
+ * que avanza con los delays del contenido, no con lo que tarda en
+ * decodificarse y enviarse. La línea se ancla con esp_timer al presentar
+ * el primer frame; desde ahí cada frame espera a su pts y, si llega con su
+ * intervalo ya terminado (deadline perdido), se aplica la política de
+ * CONFIG_FRAME_SCHED_LATE_POLICY.
+ *
+ * Quien decodifica llama a frame_sched_plan() y quien envía al panel a
+ * frame_sched_present() y frame_sched_presented(); pueden ser tareas
+ * distintas. Una sola reproducción a la vez.
+ */
+
+#ifndef FRAME_SCHED_H
+#define FRAME_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/** @brief Política con retraso (una sola a 1); DROP si no hay sdkconfig */
+#if defined(CONFIG_FRAME_SCHED_LATE_SKIP_DECODE) && CONFIG_FRAME_SCHED_LATE_SKIP_DECODE
+    #define FRAME_SCHED_LATE_SKIP_DECODE 1
+#else
+    #define FRAME_SCHED_LATE_SKIP_DECODE 0
+#endif
+#if defined(CONFIG_FRAME_SCHED_LATE_LOWER_SCALE) && CONFIG_FRAME_SCHED_LATE_LOWER_SCALE
+    #define FRAME_SCHED_LATE_LOWER_SCALE 1
+#else
+    #define FRAME_SCHED_LATE_LOWER_SCALE 0
+#endif
+#define FRAME_SCHED_LATE_DROP (!FRAME_SCHED_LATE_SKIP_DECODE && !FRAME_SCHED_LATE_LOWER_SCALE)
+
+#ifndef CONFIG_FRAME_SCHED_MAX_LAG_MS
+#define CONFIG_FRAME_SCHED_MAX_LAG_MS 500
+#endif
+
+/** @brief Retraso a partir del cual la línea de tiempo se adelanta en vez de recuperar */
+#define FRAME_SCHED_MAX_LAG_US ((int64_t)CONFIG_FRAME_SCHED_MAX_LAG_MS * 1000)
+
+/** @brief Frames entre dos cambios de escala (lo que tarda en notarse el anterior) */
+#define FRAME_SCHED_SETTLE_FRAMES  4
+
+/** @brief Frames seguidos con adelanto para volver a la escala anterior */
+#define FRAME_SCHED_RECOVER_FRAMES 16
+
+/**
+ * @brief Intervalo de un frame en la línea de tiempo
+ */
+typedef struct {
+    int64_t pts_us;         ///< Inicio del intervalo desde el primer frame
+    uint32_t delay_ms;      ///< Duración del intervalo
+    uint8_t scale;          ///< Reducción extra para decodificarlo (política LOWER_SCALE)
+    bool droppable;         ///< Se puede saltar sin romper los siguientes
+    bool skip;              ///< No decodificar ni enviar: ya va tarde (SKIP_DECODE)
+} frame_sched_slot_t;
+
+/**
+ * @brief Empieza una línea de tiempo nueva
+ *
+ * Con el pin TE activo deja el intervalo de presentación en un refresco:
+ * cada flush sale con el primer pulso tras su pts.
+ */
+void frame_sched_start(void);
+
+/**
+ * @brief Asigna al siguiente frame su intervalo y decide si decodificarlo
+ *
+ * Llamar justo antes de decodificar, en el orden de reproducción.
+ *
+ * @param delay_ms Tiempo en pantalla según el contenido
+ * @param droppable false para frames de los que dependen los siguientes (deltas)
+ * @param[out] slot Intervalo; si slot->skip el frame ya cuenta como descartado
+ */
+void frame_sched_plan(uint32_t delay_ms, bool droppable, frame_sched_slot_t* slot);
+
+/**
+ * @brief Espera al pts del frame antes de enviarlo
+ * @return false si se descarta por ir tarde (política DROP): no enviarlo ni
+ *         llamar a frame_sched_presented()
+ */
+bool frame_sched_present(const frame_sched_slot_t* slot);
+
+/**
+ * @brief Cuenta el frame ya enviado como a tiempo o tarde y cierra el frame
+ *        en las estadísticas
+ */
+void frame_sched_presented(const frame_sched_slot_t* slot);
+
+#endif // FRAME_SCHED_H
@@ -0,0 +1,387 @@
+/**
+ * @file jpeg_stream.c
+ * @brief Decodificación JPEG por bloques MCU hacia franjas o framebuffers
+ */
+
+#include "jpeg_stream.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_rom_caps.h"
+#include "st77xx.h"
+#include "st77xx_stats.h"
+
+#if ESP_ROM_HAS_JPEG_DECODE
+#include "rom/tjpgd.h"
+#endif
+
+static const char* TAG = "jpeg_stream";
+
+#if ESP_ROM_HAS_JPEG_DECODE
+
+/**
+ * @brief Estado de una decodificación en curso
+ */
+typedef struct {
+    // Fuente: archivo o memoria
+    FILE* file;
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+
+    // Colocación de la imagen (ya escalada) en pantalla
+    int32_t off_x;
+    int32_t off_y;
+    int32_t img_w;
+    int32_t img_h;
+
+    // Destino directo (jpeg_stream_decode_to)
+    const jpeg_target_t* target;
+
+    // Franja en curso
+    int stripe;
+    int stripe_count;
+    int32_t stripe_y0;
+    int32_t stripe_rows;
+    uint16_t* buf;
+} jpeg_stream_t;
+
+static uint8_t work[JPEG_STREAM_WORK_SIZE];
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Entrada
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static UINT jpeg_input(JDEC* jd, BYTE* buf, UINT len)
+{
+    jpeg_stream_t* js = (jpeg_stream_t*)jd->device;
+
+    if (js->file) {
+        if (!buf) {
+            return fseek(js->file, len, SEEK_CUR) == 0 ? len : 0;
+        }
+        return fread(buf, 1, len, js->file);
+    }
+
+    size_t left = js->size - js->pos;
+    if (len > left) len = left;
+    if (buf) memcpy(buf, js->data + js->pos, len);
+    js->pos += len;
+    return len;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Streaming por franjas
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+/**
+ * @brief Obtiene la franja actual y borra lo que la imagen no va a cubrir
+ */
+static bool stripe_open(jpeg_stream_t* js)
+{
+    js->buf = st77xx_stripe_acquire();
+    if (!js->buf) return false;
+
+    js->stripe_y0 = (int32_t)js->stripe * st77xx_stripe_get_height();
+    js->stripe_rows = st77xx_stripe_get_rows(js->stripe);
+
+    int32_t img_y0 = js->off_y;
+    int32_t img_y1 = js->off_y + js->img_h;
+    bool rows_covered = img_y0 <= js->stripe_y0 && img_y1 >= js->stripe_y0 + js->stripe_rows;
+    bool cols_covered = js->off_x <= 0 && js->off_x + js->img_w >= ST77XX_WIDTH;
+
+    if (!rows_covered || !cols_covered) {
+        memset(js->buf, 0, (size_t)ST77XX_WIDTH * js->stripe_rows * sizeof(uint16_t));
+    }
+    return true;
+}
+
+/**
+ * @brief Envía la franja actual y abre la siguiente (si queda alguna)
+ */
+static bool stripe_advance(jpeg_stream_t* js)
+{
+    st77xx_stripe_submit();
+    js->buf = NULL;
+    js->stripe++;
+    if (js->stripe >= js->stripe_count) return false;
+    return stripe_open(js);
+}
+
+static UINT jpeg_output(JDEC* jd, void* bitmap, JRECT* rect)
+{
+    jpeg_stream_t* js = (jpeg_stream_t*)jd->device;
+    int32_t top = js->off_y + rect->top;
+
+    // Un bloque por debajo de la franja implica que ésta ya está completa
+    while (js->buf && top >= js->stripe_y0 + js->stripe_rows) {
+        stripe_advance(js);
+    }
+    if (!js->buf) return 1;
+
+    const BYTE* rgb = (const BYTE*)bitmap;
+    int32_t block_w = rect->right - rect->left + 1;
+    int32_t x0 = js->off_x + rect->left;
+
+    for (int32_t y = rect->top; y <= rect->bottom; y++) {
+        int32_t row = js->off_y + y - js->stripe_y0;
+        if (row < 0 || row >= js->stripe_rows) {
+            rgb += block_w * 3;
+            continue;
+        }
+
+        uint16_t* dst = &js->buf[row * ST77XX_WIDTH];
+        for (int32_t i = 0; i < block_w; i++, rgb += 3) {
+            int32_t x = x0 + i;
+            if (x < 0 || x >= ST77XX_WIDTH) continue;
+            dst[x] = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Prepara el decodificador, elige escala y envía el frame completo
+ */
+static esp_err_t stream_decode(jpeg_stream_t* js)
+{
+    js->stripe_count = st77xx_stripe_get_count();
+    if (js->stripe_count == 0) {
+        ESP_LOGE(TAG, "Stripe mode no inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    JDEC jd;
+    JRESULT res = jd_prepare(&jd, jpeg_input, work, sizeof(work), js);
+    if (res == JDR_FMT3) {
+        // Progresivo o muestreo que TJpgDec no soporta: que decida el llamador
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "jd_prepare: %d", res);
+        return ESP_FAIL;
+    }
+
+    // Menor reducción con la que la imagen cabe en pantalla
+    BYTE scale = 0;
+    while (scale < 3 && (((int32_t)jd.width >> scale) > ST77XX_WIDTH ||
+                         ((int32_t)jd.height >> scale) > ST77XX_HEIGHT)) {
+        scale++;
+    }
+
+    // Las filas de MCU no deben cruzar el borde entre franjas
+    int32_t mcu_h = (jd.msy * 8) >> scale;
+    if (mcu_h < 1) mcu_h = 1;
+    if (st77xx_stripe_get_height() % mcu_h != 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    js->img_w = (int32_t)jd.width >> scale;
+    js->img_h = (int32_t)jd.height >> scale;
+    js->off_x = (ST77XX_WIDTH - js->img_w) / 2;
+    js->off_y = (ST77XX_HEIGHT - js->img_h) / 2;
+    if (js->off_y > 0) js->off_y -= js->off_y % mcu_h;
+    if (js->off_y < 0) js->off_y = 0;
+
+    st77xx_stripe_begin_frame();
+    js->stripe = 0;
+    if (!stripe_open(js)) return ESP_ERR_INVALID_STATE;
+
+    // Incluye la lectura incremental y el envío de las franjas ya completas
+    int64_t t0 = st77xx_stats_begin();
+    res = jd_decomp(&jd, jpeg_output, scale);
+    st77xx_stats_end(ST77XX_STAGE_DECODE, t0);
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "jd_decomp: %d", res);
+    }
+
+    // Completar el frame aunque la decodificación haya fallado a medias
+    while (js->buf) {
+        stripe_advance(js);
+    }
+
+    ESP_LOGD(TAG, "JPG %ux%u escala 1/%d en %d franjas", jd.width, jd.height, 1 << scale, js->stripe_count);
+    return res == JDR_OK ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t jpeg_stream_display_file(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "No se pudo abrir: %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    jpeg_stream_t js = { .file = f };
+    esp_err_t ret = stream_decode(&js);
+    fclose(f);
+    return ret;
+}
+
+esp_err_t jpeg_stream_display(const uint8_t* data, size_t size)
+{
+    if (!data || !size) return ESP_ERR_INVALID_ARG;
+
+    jpeg_stream_t js = { .data = data, .size = size };
+    return stream_decode(&js);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Decodificación directa a framebuffer
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static UINT target_output(JDEC* jd, void* bitmap, JRECT* rect)
+{
+    jpeg_stream_t* js = (jpeg_stream_t*)jd->device;
+    const jpeg_target_t* t = js->target;
+
+    int32_t block_w = rect->right - rect->left + 1;
+    int32_t bx0 = t->x + rect->left;
+    int32_t by0 = t->y + rect->top;
+    int32_t x0 = bx0 > t->clip.x0 ? bx0 : t->clip.x0;
+    int32_t x1 = bx0 + block_w - 1 < t->clip.x1 ? bx0 + block_w - 1 : t->clip.x1;
+    int32_t y0 = by0 > t->clip.y0 ? by0 : t->clip.y0;
+    int32_t y1 = t->y + rect->bottom < t->clip.y1 ? t->y + rect->bottom : t->clip.y1;
+    if (x0 > x1 || y0 > y1) return 1;
+
+    for (int32_t y = y0; y <= y1; y++) {
+        const BYTE* rgb = (const BYTE*)bitmap + ((y - by0) * block_w + (x0 - bx0)) * 3;
+        uint16_t* dst = &t->buf[y * t->stride + x0];
+
+        if (t->swap) {
+            for (int32_t x = x0; x <= x1; x++, rgb += 3) {
+                uint16_t c = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+                *dst++ = (c >> 8) | (c << 8);
+            }
+        } else {
+            for (int32_t x = x0; x <= x1; x++, rgb += 3) {
+                *dst++ = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+            }
+        }
+    }
+    return 1;
+}
+
+static esp_err_t target_prepare(jpeg_stream_t* js, JDEC* jd)
+{
+    JRESULT res = jd_prepare(jd, jpeg_input, work, sizeof(work), js);
+    if (res == JDR_FMT3) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "jd_prepare: %d", res);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t target_decomp(JDEC* jd, uint8_t scale)
+{
+    int64_t t0 = st77xx_stats_begin();
+    JRESULT res = jd_decomp(jd, target_output, scale);
+    st77xx_stats_end(ST77XX_STAGE_DECODE, t0);
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "jd_decomp: %d", res);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t jpeg_stream_decode_to(const uint8_t* data, size_t size, const jpeg_target_t* target)
+{
+    if (!data || !size || !target || !target->buf || target->scale > 3) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_stream_t js = { .data = data, .size = size, .target = target };
+    JDEC jd;
+    esp_err_t ret = target_prepare(&js, &jd);
+    if (ret != ESP_OK) return ret;
+    return target_decomp(&jd, target->scale);
+}
+
+esp_err_t jpeg_stream_decode_centered(const uint8_t* data, size_t size, uint16_t* frame,
+                                      int32_t width, int32_t height, bool swap)
+{
+    if (!data || !size || !frame || width <= 0 || height <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_target_t target = {
+        .buf = frame,
+        .stride = width,
+        .clip = { 0, 0, width - 1, height - 1 },
+        .swap = swap,
+    };
+    jpeg_stream_t js = { .data = data, .size = size, .target = &target };
+    JDEC jd;
+    esp_err_t ret = target_prepare(&js, &jd);
+    if (ret != ESP_OK) return ret;
+
+    while (target.scale < 3 && (((int32_t)jd.width >> target.scale) > width ||
+                                ((int32_t)jd.height >> target.scale) > height)) {
+        target.scale++;
+    }
+    int32_t img_w = (int32_t)jd.width >> target.scale;
+    int32_t img_h = (int32_t)jd.height >> target.scale;
+    target.x = (width - img_w) / 2;
+    target.y = (height - img_h) / 2;
+
+    // Solo las bandas fuera de la imagen; el resto lo sobrescribe el decodificador
+    if (target.y > 0) {
+        memset(frame, 0, (size_t)target.y * width * sizeof(uint16_t));
+        int32_t below = height - (target.y + img_h);
+        memset(&frame[(target.y + img_h) * width], 0, (size_t)below * width * sizeof(uint16_t));
+    }
+    if (target.x > 0) {
+        // A 1/8 la imagen aún puede ser más alta que el frame: filas recortadas
+        int32_t right = width - (target.x + img_w);
+        int32_t y0 = target.y > 0 ? target.y : 0;
+        int32_t y1 = target.y + img_h < height ? target.y + img_h : height;
+        for (int32_t y = y0; y < y1; y++) {
+            memset(&frame[y * width], 0, (size_t)target.x * sizeof(uint16_t));
+            memset(&frame[y * width + target.x + img_w], 0, (size_t)right * sizeof(uint16_t));
+        }
+    }
+
+    return target_decomp(&jd, target.scale);
+}
+
+#else
+
+esp_err_t jpeg_stream_display_file(const char* path)
+{
+    (void)path;
+    ESP_LOGD(TAG, "Sin TJpgDec en ROM");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t jpeg_stream_display(const uint8_t* data, size_t size)
+{
+    (void)data;
+    (void)size;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t jpeg_stream_decode_to(const uint8_t* data, size_t size, const jpeg_target_t* target)
+{
+    (void)data;
+    (void)size;
+    (void)target;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t jpeg_stream_decode_centered(const uint8_t* data, size_t size, uint16_t* frame,
+                                      int32_t width, int32_t height, bool swap)
+{
+    (void)data;
+    (void)size;
+    (void)frame;
+    (void)width;
+    (void)height;
+    (void)swap;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file jpeg_stream.h
+ * @brief Decodificación JPEG en streaming directamente sobre las franjas del driver
+ *
+ * Usa el decodificador TJpgDec de la ROM: cada bloque MCU decodificado se
+ * escribe en la franja en curso y cada franja se envía en cuanto está
+ * completa. El pico de RAM es el anillo de franjas más el área de trabajo
+ * del decodificador; no hay buffer de imagen completa ni de archivo.
+ */
+
+#ifndef JPEG_STREAM_H
+#define JPEG_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "st77xx.h"
+
+/** @brief Tamaño del área de trabajo de TJpgDec */
+#define JPEG_STREAM_WORK_SIZE 3100
+
+/**
+ * @brief Decodifica un JPG desde archivo y lo muestra franja a franja
+ *
+ * La imagen se reduce en potencias de dos solo si no cabe en pantalla y se
+ * centra con bordes negros. Requiere st77xx_init_stripe_mode().
+ *
+ * @param path Ruta al archivo JPG
+ * @return ESP_OK si se mostró, ESP_ERR_NOT_SUPPORTED si este chip o la
+ *         geometría de franjas no permiten el streaming, otro error si falla
+ */
+esp_err_t jpeg_stream_display_file(const char* path);
+
+/**
+ * @brief Igual que jpeg_stream_display_file() pero con el JPG en memoria
+ * @param data Datos JPG
+ * @param size Tamaño en bytes
+ * @return ESP_OK si se mostró, ESP_ERR_NOT_SUPPORTED o error
+ */
+esp_err_t jpeg_stream_display(const uint8_t* data, size_t size);
+
+/**
+ * @brief Destino de una decodificación directa sobre un framebuffer
+ */
+typedef struct {
+    uint16_t* buf;          ///< Framebuffer de destino
+    int32_t stride;         ///< Píxeles por fila de buf
+    int32_t x;              ///< Columna de la esquina superior izquierda (puede ser < 0)
+    int32_t y;              ///< Fila de la esquina superior izquierda (puede ser < 0)
+    st77xx_rect_t clip;     ///< Región de buf que se puede escribir (inclusiva)
+    uint8_t scale;          ///< Reducción 1/2^scale (0..3)
+    bool swap;              ///< true: orden de bytes del panel (st77xx_flush_raw)
+} jpeg_target_t;
+
+/**
+ * @brief Decodifica un JPG en memoria directamente sobre @p target
+ *
+ * Cada bloque MCU se escribe en su posición final; lo que cae fuera de
+ * target->clip se descarta. No toca los píxeles que la imagen no cubre.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED sin TJpgDec en ROM o formato no
+ *         soportado, ESP_ERR_INVALID_ARG u otro error
+ */
+esp_err_t jpeg_stream_decode_to(const uint8_t* data, size_t size, const jpeg_target_t* target);
+
+/**
+ * @brief Decodifica un JPG centrado en un framebuffer de @p width x @p height
+ *
+ * Reduce en potencias de dos solo si la imagen no cabe y pone a negro
+ * únicamente las bandas que la imagen no cubre.
+ *
+ * @param data Datos JPG
+ * @param size Tamaño en bytes
+ * @param frame Framebuffer de destino (stride = width)
+ * @param width Ancho del framebuffer
+ * @param height Alto del framebuffer
+ * @param swap true para escribir en el orden de bytes del panel
+ * @return Igual que jpeg_stream_decode_to()
+ */
+esp_err_t jpeg_stream_decode_centered(const uint8_t* data, size_t size, uint16_t* frame,
+                                      int32_t width, int32_t height, bool swap);
+
+#endif // JPEG_STREAM_H
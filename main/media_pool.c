@@ -0,0 +1,241 @@
+/**
+ * @file media_pool.c
+ * @brief Pool de buffers persistentes para el reproductor JPG
+ */
+
+#include "media_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "st77xx.h"
+#include "st77xx_stats.h"
+#include "mem_monitor.h"
+
+static const char* TAG = "media_pool";
+
+#if ST77XX_USE_PSRAM
+#define MEDIA_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define MEDIA_CAPS (MALLOC_CAP_8BIT)
+#endif
+
+#define FRAME_BYTES ((size_t)ST77XX_WIDTH * ST77XX_HEIGHT * sizeof(uint16_t))
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Estado
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static uint8_t* file_buf = NULL;
+static uint8_t* decode_buf = NULL;
+static uint16_t* frame_buf = NULL;
+static uint8_t work_buf[MEDIA_POOL_WORK_SIZE];
+static media_pool_stats_t stats;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Dimensionado
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+static bool is_jpg(const char* name)
+{
+    const char* ext = strrchr(name, '.');
+    return ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0);
+}
+
+static size_t read_file(const char* path, uint8_t* buf, size_t cap)
+{
+    int64_t t0 = st77xx_stats_begin();
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+
+    fseek(f, 0, SEEK_END);
+    size_t size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size > cap) {
+        fclose(f);
+        return 0;
+    }
+    size_t got = fread(buf, 1, size, f);
+    fclose(f);
+    st77xx_stats_end(ST77XX_STAGE_FILE_READ, t0);
+    return got == size ? size : 0;
+}
+
+/**
+ * @brief Hook de mem_monitor: uso del pool frente a lo reservado
+ */
+static void media_pool_report(void* ctx)
+{
+    (void)ctx;
+    ESP_LOGI(TAG, "Archivo %u/%u | decode %u/%u | frame %u | cargas %lu, rechazos %lu",
+             (unsigned)stats.file_hwm, (unsigned)stats.file_cap,
+             (unsigned)stats.decode_hwm, (unsigned)stats.decode_cap,
+             (unsigned)stats.frame_cap,
+             (unsigned long)stats.loads, (unsigned long)stats.rejects);
+}
+
+esp_err_t media_pool_init(const char* dir)
+{
+    if (stats.file_cap) return ESP_OK;
+
+    DIR* d = opendir(dir);
+    if (!d) {
+        ESP_LOGE(TAG, "No se pudo abrir directorio: %s", dir);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Primera pasada: el archivo más grande fija el buffer de archivo
+    char path[300];
+    struct dirent* entry;
+    struct stat st;
+    size_t max_file = 0;
+    while ((entry = readdir(d)) != NULL) {
+        if (!is_jpg(entry->d_name)) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (stat(path, &st) == 0 && (size_t)st.st_size > max_file) {
+            max_file = st.st_size;
+        }
+    }
+
+    if (max_file == 0) {
+        closedir(d);
+        ESP_LOGE(TAG, "Sin JPG en %s", dir);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Buffer temporal: el definitivo se reserva en la primera carga, después
+    // de que la app haya reservado los suyos (p.ej. el anillo de franjas)
+    uint8_t* scan_buf = heap_caps_malloc(max_file, MEDIA_CAPS);
+    if (!scan_buf) {
+        closedir(d);
+        ESP_LOGE(TAG, "Sin memoria para buffer de archivo (%u bytes)", (unsigned)max_file);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Segunda pasada: la mayor resolución fija el buffer de decodificación
+    rewinddir(d);
+    while ((entry = readdir(d)) != NULL) {
+        if (!is_jpg(entry->d_name)) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+
+        size_t size = read_file(path, scan_buf, max_file);
+        if (size == 0) continue;
+
+        esp_jpeg_image_output_t info;
+        esp_jpeg_image_cfg_t cfg = {
+            .indata = scan_buf,
+            .indata_size = size,
+            .advanced = {
+                .working_buffer = work_buf,
+                .working_buffer_size = sizeof(work_buf),
+            },
+        };
+        if (esp_jpeg_get_image_info(&cfg, &info) != ESP_OK) continue;
+
+        if ((uint32_t)info.width * info.height > (uint32_t)stats.max_width * stats.max_height) {
+            stats.max_width = info.width;
+            stats.max_height = info.height;
+        }
+    }
+    closedir(d);
+    heap_caps_free(scan_buf);
+    stats.file_cap = max_file;
+
+    mem_monitor_add_hook(media_pool_report, NULL);
+
+    ESP_LOGI(TAG, "Pool: archivo %u bytes, imagen máx %ux%u",
+             (unsigned)max_file, stats.max_width, stats.max_height);
+    return ESP_OK;
+}
+
+void media_pool_set_image_size(uint16_t width, uint16_t height)
+{
+    if ((uint32_t)width * height > (uint32_t)stats.max_width * stats.max_height) {
+        stats.max_width = width;
+        stats.max_height = height;
+    }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * Buffers
+ * ═══════════════════════════════════════════════════════════════════════════ */
+
+uint8_t* media_pool_load(const char* path, size_t* size)
+{
+    if (!file_buf) {
+        if (stats.file_cap == 0) return NULL;
+        file_buf = heap_caps_malloc(stats.file_cap, MEDIA_CAPS);
+        if (!file_buf) {
+            ESP_LOGE(TAG, "Sin memoria para buffer de archivo (%u bytes)", (unsigned)stats.file_cap);
+            return NULL;
+        }
+    }
+
+    size_t got = read_file(path, file_buf, stats.file_cap);
+    if (got == 0) {
+        stats.rejects++;
+        ESP_LOGE(TAG, "No se pudo cargar (o no cabe): %s", path);
+        return NULL;
+    }
+
+    stats.loads++;
+    if (got > stats.file_hwm) stats.file_hwm = got;
+    if (size) *size = got;
+    return file_buf;
+}
+
+uint8_t* media_pool_decode_buffer(esp_jpeg_image_scale_t scale, size_t* cap)
+{
+    // esp_jpeg redondea las dimensiones reducidas hacia arriba
+    size_t w = ((size_t)stats.max_width + (1u << scale) - 1) >> scale;
+    size_t h = ((size_t)stats.max_height + (1u << scale) - 1) >> scale;
+    size_t need = w * h * sizeof(uint16_t);
+    if (need == 0) need = FRAME_BYTES;
+
+    // Solo crece: tras el primer frame a la mayor escala ya no hay reservas
+    if (need > stats.decode_cap) {
+        if (decode_buf) heap_caps_free(decode_buf);
+        decode_buf = heap_caps_malloc(need, MEDIA_CAPS);
+        if (!decode_buf) {
+            stats.decode_cap = 0;
+            ESP_LOGE(TAG, "Sin memoria para decodificación (%u bytes)", (unsigned)need);
+            return NULL;
+        }
+        stats.decode_cap = need;
+    }
+
+    if (cap) *cap = stats.decode_cap;
+    return decode_buf;
+}
+
+void media_pool_note_decode(size_t bytes)
+{
+    if (bytes > stats.decode_hwm) stats.decode_hwm = bytes;
+}
+
+uint8_t* media_pool_work_buffer(void)
+{
+    return work_buf;
+}
+
+uint16_t* media_pool_frame(void)
+{
+    if (!frame_buf) {
+        frame_buf = heap_caps_malloc(FRAME_BYTES, MEDIA_CAPS);
+        if (!frame_buf) {
+            ESP_LOGE(TAG, "Sin memoria para framebuffer");
+            return NULL;
+        }
+        stats.frame_cap = FRAME_BYTES;
+    }
+    return frame_buf;
+}
+
+void media_pool_get_stats(media_pool_stats_t* out)
+{
+    if (out) *out = stats;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file media_pool.h
+ * @brief Buffers persistentes para cargar y decodificar los JPG de SPIFFS
+ *
+ * Los tamaños se calculan una vez al arrancar recorriendo los assets (el
+ * archivo más grande y la imagen de mayor resolución). Cada buffer se
+ * reserva la primera vez que se pide y se reutiliza en todos los frames:
+ * no hay malloc/free por frame ni fragmentación a largo plazo.
+ *
+ * Los buffers no son reentrantes: un solo decodificador a la vez.
+ */
+
+#ifndef MEDIA_POOL_H
+#define MEDIA_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "jpeg_decoder.h"
+
+/** @brief Área de trabajo que esp_jpeg necesita por decodificación */
+#define MEDIA_POOL_WORK_SIZE 3100
+
+/**
+ * @brief Tamaños y uso máximo de los buffers del pool
+ */
+typedef struct {
+    size_t file_cap;        ///< Bytes reservados para el archivo
+    size_t file_hwm;        ///< Mayor archivo cargado
+    size_t decode_cap;      ///< Bytes reservados para la imagen decodificada
+    size_t decode_hwm;      ///< Mayor imagen decodificada
+    size_t frame_cap;       ///< Bytes del framebuffer (0 si no se ha pedido)
+    uint16_t max_width;     ///< Mayor ancho de los assets
+    uint16_t max_height;    ///< Mayor alto de los assets
+    uint32_t loads;         ///< Archivos cargados
+    uint32_t rejects;       ///< Archivos que no cabían en el pool
+} media_pool_stats_t;
+
+/**
+ * @brief Recorre @p dir y dimensiona el pool para el mayor asset
+ *
+ * Solo calcula los tamaños: no deja nada reservado, así que puede llamarse
+ * antes de que la app reserve sus propios buffers. Registra además un hook
+ * en mem_monitor con los high-water marks.
+ *
+ * @param dir Directorio con los JPG (p.ej. "/spiffs")
+ * @return ESP_OK, ESP_ERR_NOT_FOUND si no hay JPG o ESP_ERR_NO_MEM
+ */
+esp_err_t media_pool_init(const char* dir);
+
+/**
+ * @brief Dimensiona el buffer de decodificación para imágenes de hasta
+ *        @p width x @p height sin recorrer un directorio
+ *
+ * Para JPG que no vienen de SPIFFS, p.ej. con el tamaño máximo de la
+ * cabecera ST7A. Solo amplía lo que ya calculó media_pool_init().
+ */
+void media_pool_set_image_size(uint16_t width, uint16_t height);
+
+/**
+ * @brief Carga un archivo completo en el buffer de archivo del pool
+ *
+ * La primera llamada reserva el buffer con el tamaño de media_pool_init().
+ * @param path Ruta al archivo
+ * @param[out] size Bytes leídos
+ * @return Puntero al contenido (válido hasta la siguiente carga) o NULL
+ */
+uint8_t* media_pool_load(const char* path, size_t* size);
+
+/**
+ * @brief Buffer de decodificación para imágenes reducidas a @p scale
+ * @param scale Escala de salida de esp_jpeg
+ * @param[out] cap Capacidad en bytes
+ * @return Buffer o NULL sin memoria
+ */
+uint8_t* media_pool_decode_buffer(esp_jpeg_image_scale_t scale, size_t* cap);
+
+/**
+ * @brief Anota los bytes realmente decodificados (para el high-water mark)
+ */
+void media_pool_note_decode(size_t bytes);
+
+/**
+ * @brief Área de trabajo persistente para esp_jpeg_image_cfg_t.advanced
+ */
+uint8_t* media_pool_work_buffer(void);
+
+/**
+ * @brief Framebuffer de pantalla completa (PSRAM si está disponible)
+ * @return Framebuffer o NULL sin memoria
+ */
+uint16_t* media_pool_frame(void);
+
+/**
+ * @brief Copia las estadísticas del pool
+ * @param out Destino
+ */
+void media_pool_get_stats(media_pool_stats_t* out);
+
+#endif // MEDIA_POOL_H
@@ -11,6 +11,14 @@ static const char* TAG = "MEM_MON";
 #define CONFIG_MEM_MONITOR_INTERVAL_MS 5000
 #endif
 
+typedef struct {
+    mem_monitor_hook_t fn;
+    void* ctx;
+} mem_monitor_hook_entry_t;
+
+static mem_monitor_hook_entry_t hooks[MEM_MONITOR_MAX_HOOKS];
+static volatile int hook_count = 0;
+
 static void mem_monitor_task(void* arg)
 {
     (void)arg;
@@ -33,6 +41,10 @@ static void mem_monitor_task(void* arg)
                  (unsigned)sram_total, (unsigned)sram_free);
 #endif
 
+        for (int i = 0; i < hook_count; i++) {
+            hooks[i].fn(hooks[i].ctx);
+        }
+
         vTaskDelay(pdMS_TO_TICKS(CONFIG_MEM_MONITOR_INTERVAL_MS));
     }
 }
@@ -45,3 +57,14 @@ void mem_monitor_start(void)
     (void)mem_monitor_task;
 #endif
 }
+
+bool mem_monitor_add_hook(mem_monitor_hook_t hook, void* ctx)
+{
+    if (!hook || hook_count >= MEM_MONITOR_MAX_HOOKS) {
+        return false;
+    }
+    hooks[hook_count].fn = hook;
+    hooks[hook_count].ctx = ctx;
+    hook_count++;  // Publicar después de rellenar la entrada
+    return true;
+}
@@ -1,6 +1,22 @@
 #ifndef MEM_MONITOR_H
 #define MEM_MONITOR_H
 
+#include <stdbool.h>
+
+/** @brief Máximo de hooks registrables */
+#define MEM_MONITOR_MAX_HOOKS 4
+
+/**
+ * @brief Función llamada tras cada informe periódico de memoria
+ */
+typedef void (*mem_monitor_hook_t)(void* ctx);
+
 void mem_monitor_start(void);
 
+/**
+ * @brief Añade un informe propio (p.ej. high-water marks de un pool)
+ * @return false si no quedan huecos
+ */
+bool mem_monitor_add_hook(mem_monitor_hook_t hook, void* ctx);
+
 #endif // MEM_MONITOR_H
@@ -7,20 +7,145 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <dirent.h>
 #include <string.h>
-#include <math.h>
+#include <strings.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "st77xx.h"
+#include "st77xx_async.h"
+#include "st77xx_kernels.h"
+#include "st77xx_scale.h"
+#include "st77xx_stats.h"
 #include "mem_monitor.h"
+#include "jpeg_stream.h"
+#include "frame_pipeline.h"
+#include "frame_sched.h"
+#include "media_pool.h"
+#include "anim_player.h"
 #include "sdkconfig.h"
 #include "jpeg_decoder.h"
 
 static const char* TAG = "st-idf";
 
+/**
+ * @brief Directorio con los JPG sueltos (sin contenedor ST7A)
+ */
+#define SPIFFS_DIR "/spiffs"
+
+/**
+ * @brief Frames "frame_NN[_delay-S.SSs].jpg" como máximo en SPIFFS_DIR
+ */
+#define SPIFFS_MAX_FRAMES 64
+
+/**
+ * @brief Delay de los frames cuyo nombre no lo indica (el de st7a_pack.py)
+ */
+#define FRAME_DELAY_MS 150
+
+/**
+ * @brief Frame suelto de SPIFFS: ruta real y delay de su nombre
+ */
+typedef struct {
+    int number;             // NN del nombre: orden de reproducción
+    uint32_t delay_ms;
+    char path[48];
+} spiffs_frame_t;
+
+static spiffs_frame_t spiffs_frames[SPIFFS_MAX_FRAMES];
+static int spiffs_frame_count = 0;
+
+/**
+ * @brief Delay en ms de un nombre "frame_NN_delay-S.SSs.jpg"
+ */
+static uint32_t frame_name_delay_ms(const char* name)
+{
+    const char* tag = strstr(name, "_delay-");
+    if (!tag) {
+        return FRAME_DELAY_MS;
+    }
+    char* end;
+    float seconds = strtof(tag + 7, &end);
+    if (end == tag + 7 || *end != 's' || seconds <= 0.0f) {
+        return FRAME_DELAY_MS;
+    }
+    return (uint32_t)(seconds * 1000.0f + 0.5f);
+}
+
+/**
+ * @brief Busca los frames de @p dir y los ordena por NN, como tools/st7a_pack.py
+ * @return Frames encontrados (en spiffs_frames)
+ */
+static int spiffs_scan_frames(const char* dir)
+{
+    DIR* d = opendir(dir);
+    if (!d) {
+        ESP_LOGE(TAG, "No se pudo abrir directorio: %s", dir);
+        return 0;
+    }
+
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        const char* name = entry->d_name;
+        if (strncmp(name, "frame_", 6) != 0) continue;
+        char* end;
+        long number = strtol(name + 6, &end, 10);
+        const char* ext = strrchr(name, '.');
+        if (end == name + 6 || (*end != '_' && *end != '.') || !ext ||
+            (strcasecmp(ext, ".jpg") != 0 && strcasecmp(ext, ".jpeg") != 0)) {
+            continue;
+        }
+        if (count == SPIFFS_MAX_FRAMES) {
+            ESP_LOGW(TAG, "Más de %d frames en %s: se ignora el resto", SPIFFS_MAX_FRAMES, dir);
+            break;
+        }
+
+        spiffs_frame_t f = { .number = (int)number, .delay_ms = frame_name_delay_ms(name) };
+        if (snprintf(f.path, sizeof(f.path), "%s/%s", dir, name) >= (int)sizeof(f.path)) {
+            ESP_LOGW(TAG, "Nombre demasiado largo: %s", name);
+            continue;
+        }
+
+        // Inserción ordenada: readdir() no garantiza ningún orden
+        int i = count++;
+        while (i > 0 && spiffs_frames[i - 1].number > f.number) {
+            spiffs_frames[i] = spiffs_frames[i - 1];
+            i--;
+        }
+        spiffs_frames[i] = f;
+    }
+    closedir(d);
+    return count;
+}
+
+/**
+ * @brief Tiempo en pantalla del frame @p index según los metadatos del asset
+ *
+ * @p ctx es el contenedor ST7A abierto, o NULL para los JPG de SPIFFS.
+ */
+static uint32_t animation_frame_delay(int index, void* ctx)
+{
+    const anim_t* anim = (const anim_t*)ctx;
+    if (!anim) {
+        return index < spiffs_frame_count ? spiffs_frames[index].delay_ms : FRAME_DELAY_MS;
+    }
+    anim_frame_t f;
+    return anim_get_frame(anim, index, &f) ? f.delay_ms : FRAME_DELAY_MS;
+}
+
+/**
+ * @brief Reducción extra que pide frame_sched con retraso (LATE_LOWER_SCALE)
+ *
+ * Solo la aplican las rutas que reescalan la imagen a su tamaño normal; el
+ * streaming por MCU y la decodificación centrada directa se saltan mientras
+ * sea > 0, así que la imagen pierde detalle pero no tamaño.
+ */
+static uint8_t decode_extra_scale = 0;
+
 /**
  * @brief Lista archivos en un directorio SPIFFS
  * @param dir_path Ruta del directorio
@@ -43,233 +168,278 @@ static void list_spiffs_files(const char* dir_path)
     closedir(dir);
 }
 
+#if !ST77XX_USE_PSRAM
 /**
- * @brief Decodifica y muestra imagen JPG usando modo stripe (bajo RAM)
+ * @brief Genera una franja escalando la imagen decodificada (cover mode)
+ */
+static void render_cover_stripe(uint16_t* stripe, int index, int32_t y0, int32_t rows, void* arg)
+{
+    (void)index;
+    st77xx_stripe_blit_scaled(stripe, y0, rows, (const st77xx_scaler_t*)arg);
+}
+
+/**
+ * @brief Decodifica un JPG completo en memoria y lo muestra por franjas
  * 
- * Escala la imagen para llenar la pantalla completa (cover mode).
- * Puede recortar bordes si la relación de aspecto no coincide.
+ * Escala la imagen para llenar la pantalla completa (cover mode), recortando
+ * bordes si la relación de aspecto no coincide. Es la ruta de respaldo cuando
+ * el streaming por MCU no es posible.
  * 
- * @param path Ruta al archivo JPG en SPIFFS
+ * @param jpg_buf Datos JPG
+ * @param file_size Tamaño en bytes
  * @return true si éxito, false en caso de error
  */
-static bool load_and_display_jpg_stripe(const char* path)
+static bool display_jpg_stripe_buffered(const uint8_t* jpg_buf, size_t file_size)
 {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        ESP_LOGE(TAG, "No se pudo abrir: %s", path);
-        return false;
-    }
-
-    fseek(f, 0, SEEK_END);
-    size_t file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    uint8_t* jpg_buf = heap_caps_malloc(file_size, MALLOC_CAP_8BIT);
-    if (!jpg_buf) {
-        ESP_LOGE(TAG, "Sin memoria para JPG (%u bytes)", (unsigned)file_size);
-        fclose(f);
-        return false;
+    // La escala se fija con el primer frame: el pool no vuelve a crecer
+    static bool scale_chosen = false;
+    static esp_jpeg_image_scale_t scale;
+    if (!scale_chosen) {
+        size_t free_heap = esp_get_free_heap_size();
+        if (free_heap > 130000) {
+            scale = JPEG_IMAGE_SCALE_1_2;
+        } else if (free_heap > 70000) {
+            scale = JPEG_IMAGE_SCALE_1_4;
+        } else {
+            scale = JPEG_IMAGE_SCALE_1_8;
+        }
+        scale_chosen = true;
+        ESP_LOGI(TAG, "RAM libre: %u, escala 1/%d", (unsigned)free_heap, 1 << scale);
     }
 
-    fread(jpg_buf, 1, file_size, f);
-    fclose(f);
-
-    size_t free_heap = esp_get_free_heap_size();
-    ESP_LOGI(TAG, "JPG: %u bytes, RAM libre: %u", (unsigned)file_size, (unsigned)free_heap);
+    // Con retraso se decodifica más pequeño; el escalado sigue cubriendo la pantalla
+    int reduced = scale + decode_extra_scale;
+    esp_jpeg_image_scale_t frame_scale = reduced > JPEG_IMAGE_SCALE_1_8 ? JPEG_IMAGE_SCALE_1_8
+                                                                        : (esp_jpeg_image_scale_t)reduced;
 
-    esp_jpeg_image_scale_t scale;
     size_t max_decode_size;
-    
-    if (free_heap > 130000) {
-        scale = JPEG_IMAGE_SCALE_1_2;
-        max_decode_size = 240 * 160 * sizeof(uint16_t);
-        ESP_LOGI(TAG, "Escala 1/2");
-    } else if (free_heap > 70000) {
-        scale = JPEG_IMAGE_SCALE_1_4;
-        max_decode_size = 120 * 80 * sizeof(uint16_t);
-        ESP_LOGI(TAG, "Escala 1/4");
-    } else {
-        scale = JPEG_IMAGE_SCALE_1_8;
-        max_decode_size = 60 * 40 * sizeof(uint16_t);
-        ESP_LOGI(TAG, "Escala 1/8");
-    }
-
-    uint8_t* decode_buf = heap_caps_malloc(max_decode_size, MALLOC_CAP_8BIT);
+    uint8_t* decode_buf = media_pool_decode_buffer(frame_scale, &max_decode_size);
     if (!decode_buf) {
-        ESP_LOGE(TAG, "Sin memoria para buffer");
-        free(jpg_buf);
         return false;
     }
 
     esp_jpeg_image_output_t img_info;
     esp_jpeg_image_cfg_t jpeg_cfg = {
-        .indata = jpg_buf,
+        .indata = (uint8_t*)jpg_buf,
         .indata_size = file_size,
         .outbuf = decode_buf,
         .outbuf_size = max_decode_size,
         .out_format = JPEG_IMAGE_FORMAT_RGB565,
-        .out_scale = scale,
-        .flags = { .swap_color_bytes = 0 }
+        .out_scale = frame_scale,
+        .flags = { .swap_color_bytes = 0 },
+        .advanced = {
+            .working_buffer = media_pool_work_buffer(),
+            .working_buffer_size = MEDIA_POOL_WORK_SIZE,
+        },
     };
 
+    int64_t t0 = st77xx_stats_begin();
     esp_err_t ret = esp_jpeg_decode(&jpeg_cfg, &img_info);
-    free(jpg_buf);
-
+    st77xx_stats_end(ST77XX_STAGE_DECODE, t0);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error JPEG: %s", esp_err_to_name(ret));
-        free(decode_buf);
         return false;
     }
+    media_pool_note_decode(img_info.output_len);
 
     int src_w = img_info.width;
     int src_h = img_info.height;
     ESP_LOGI(TAG, "Imagen: %dx%d → Pantalla: %dx%d", src_w, src_h, ST77XX_WIDTH, ST77XX_HEIGHT);
 
-    /* Escalar para cubrir pantalla (cover mode) */
-    float scale_x = (float)ST77XX_WIDTH / src_w;
-    float scale_y = (float)ST77XX_HEIGHT / src_h;
-    float fill_scale = fmaxf(scale_x, scale_y);
-    
-    int scaled_w = (int)(src_w * fill_scale);
-    int scaled_h = (int)(src_h * fill_scale);
-    int offset_x = (ST77XX_WIDTH - scaled_w) / 2;
-    int offset_y = (ST77XX_HEIGHT - scaled_h) / 2;
-    
-    ESP_LOGI(TAG, "Fill: %dx%d, escala=%.2f, offset(%d,%d)", 
-             scaled_w, scaled_h, fill_scale, offset_x, offset_y);
-
-    st77xx_init_stripe_mode();
-    uint16_t* stripe = st77xx_stripe_get_buffer();
-    if (!stripe) {
-        ESP_LOGE(TAG, "Stripe mode no disponible");
-        free(decode_buf);
+    /* Escalar para cubrir pantalla (cover mode); tablas de columnas precalculadas */
+    static st77xx_scaler_t scaler;
+    if (!st77xx_scaler_init(&scaler, (const uint16_t*)decode_buf, src_w, src_h, src_w,
+                            0, 0, ST77XX_WIDTH, ST77XX_HEIGHT,
+                            ST77XX_FIT_COVER, ST77XX_FILTER_BILINEAR, 0x0000)) {
         return false;
     }
+    ESP_LOGI(TAG, "Fill: %dx%d en (%d,%d), escala %s",
+             (int)scaler.img_w, (int)scaler.img_h, (int)scaler.img_x, (int)scaler.img_y,
+             scaler.ratio ? "entera" : "libre");
 
-    uint16_t* src = (uint16_t*)decode_buf;
-    st77xx_stripe_begin_frame();
+    // Cada franja se genera mientras el DMA envía la anterior
+    bool ok = st77xx_stripe_render(render_cover_stripe, &scaler);
     
-    for (int stripe_idx = 0; stripe_idx < ST77XX_STRIPE_COUNT; stripe_idx++) {
-        int stripe_y_start = stripe_idx * ST77XX_STRIPE_HEIGHT;
-        
-        for (int y = 0; y < ST77XX_STRIPE_HEIGHT; y++) {
-            int screen_y = stripe_y_start + y;
-            float src_y_f = (float)(screen_y - offset_y) / fill_scale;
-            int src_y = (int)src_y_f;
-            
-            if (src_y < 0 || src_y >= src_h) {
-                for (int x = 0; x < ST77XX_WIDTH; x++) {
-                    stripe[y * ST77XX_WIDTH + x] = 0;
-                }
-                continue;
-            }
-            
-            for (int screen_x = 0; screen_x < ST77XX_WIDTH; screen_x++) {
-                float src_x_f = (float)(screen_x - offset_x) / fill_scale;
-                int src_x = (int)src_x_f;
-                
-                if (src_x < 0 || src_x >= src_w) {
-                    stripe[y * ST77XX_WIDTH + screen_x] = 0;
-                } else {
-                    stripe[y * ST77XX_WIDTH + screen_x] = src[src_y * src_w + src_x];
-                }
-            }
-        }
-        
-        st77xx_stripe_flush_next();
+    if (!ok) {
+        ESP_LOGE(TAG, "Stripe mode no disponible");
     }
-
-    free(decode_buf);
-    st77xx_cleanup_stripe_mode();
-    
-    ESP_LOGI(TAG, "JPG mostrado: %s", path);
-    return true;
+    return ok;
 }
 
-#if ST77XX_USE_PSRAM
 /**
- * @brief Decodifica y muestra imagen JPG usando PSRAM
+ * @brief Decodifica y muestra imagen JPG usando modo stripe (bajo RAM)
  * 
- * Permite decodificación a resolución completa sin escalado.
- * Requiere ESP32-S3 con PSRAM habilitada.
+ * Intenta primero jpeg_stream_display_file() (escala 1/2^n centrada, sin
+ * buffers de imagen) y si no es posible usa display_jpg_stripe_buffered().
  * 
  * @param path Ruta al archivo JPG en SPIFFS
  * @return true si éxito, false en caso de error
  */
-static bool load_and_display_jpg_psram(const char* path)
+static bool load_and_display_jpg_stripe(const char* path)
 {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        ESP_LOGE(TAG, "No se pudo abrir: %s", path);
-        return false;
+    // Primero sin buffers intermedios: MCU -> franja -> SPI. No reescala:
+    // con reducción extra va directo a la ruta con buffer
+    if (!decode_extra_scale) {
+        esp_err_t stream_ret = jpeg_stream_display_file(path);
+        if (stream_ret != ESP_ERR_NOT_SUPPORTED) {
+            return stream_ret == ESP_OK;
+        }
     }
 
-    fseek(f, 0, SEEK_END);
-    size_t file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    uint8_t* jpg_buf = heap_caps_malloc(file_size, MALLOC_CAP_8BIT);
+    size_t file_size;
+    uint8_t* jpg_buf = media_pool_load(path, &file_size);
     if (!jpg_buf) {
-        ESP_LOGE(TAG, "Sin memoria para JPG");
-        fclose(f);
         return false;
     }
+    return display_jpg_stripe_buffered(jpg_buf, file_size);
+}
 
-    fread(jpg_buf, 1, file_size, f);
-    fclose(f);
-
-    // Buffer suficiente para imágenes hasta 800x600
-    size_t max_out_size = (size_t)800 * 600 * sizeof(uint16_t);
-    uint8_t* decode_buf = heap_caps_malloc(max_out_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!decode_buf) {
-        // Fallback a RAM interna si PSRAM falla
-        ESP_LOGW(TAG, "PSRAM no disponible, usando RAM interna");
-        max_out_size = (size_t)ST77XX_WIDTH * ST77XX_HEIGHT * sizeof(uint16_t);
-        decode_buf = heap_caps_malloc(max_out_size, MALLOC_CAP_8BIT);
-        if (!decode_buf) {
-            ESP_LOGE(TAG, "Sin memoria para decodificación");
-            free(jpg_buf);
-            return false;
+/**
+ * @brief Igual que load_and_display_jpg_stripe() con el JPG ya en memoria
+ */
+static bool display_jpg_stripe(const uint8_t* data, size_t size)
+{
+    if (!decode_extra_scale) {
+        esp_err_t stream_ret = jpeg_stream_display(data, size);
+        if (stream_ret != ESP_ERR_NOT_SUPPORTED) {
+            return stream_ret == ESP_OK;
         }
-    } else {
-        ESP_LOGI(TAG, "Usando PSRAM para decodificación (%u bytes)", (unsigned)max_out_size);
     }
+    return display_jpg_stripe_buffered(data, size);
+}
+
+#endif
 
+#if ST77XX_USE_PSRAM
+/**
+ * @brief Decodifica reducido y amplía a la caja de la decodificación normal
+ *
+ * La caja es la de jpeg_stream_decode_centered(): la menor reducción en
+ * potencias de dos con la que la imagen cabe, centrada. La decodificación
+ * usa decode_extra_scale pasos más y se amplía por duplicado de píxeles.
+ */
+static bool decode_jpg_reduced_to_frame(const uint8_t* jpg_buf, size_t file_size,
+                                        uint16_t* frame, bool panel_order)
+{
     esp_jpeg_image_output_t img_info;
     esp_jpeg_image_cfg_t jpeg_cfg = {
-        .indata = jpg_buf,
+        .indata = (uint8_t*)jpg_buf,
         .indata_size = file_size,
-        .outbuf = decode_buf,
-        .outbuf_size = max_out_size,
         .out_format = JPEG_IMAGE_FORMAT_RGB565,
-        .out_scale = JPEG_IMAGE_SCALE_0,
-        .flags = { .swap_color_bytes = 0 }
+        .flags = { .swap_color_bytes = panel_order },
+        .advanced = {
+            .working_buffer = media_pool_work_buffer(),
+            .working_buffer_size = MEDIA_POOL_WORK_SIZE,
+        },
     };
+    if (esp_jpeg_get_image_info(&jpeg_cfg, &img_info) != ESP_OK) {
+        return false;
+    }
 
-    esp_err_t ret = esp_jpeg_decode(&jpeg_cfg, &img_info);
-    free(jpg_buf);
+    int fit = 0;
+    while (fit < JPEG_IMAGE_SCALE_1_8 && ((img_info.width >> fit) > ST77XX_WIDTH ||
+                                          (img_info.height >> fit) > ST77XX_HEIGHT)) {
+        fit++;
+    }
+    int32_t box_w = img_info.width >> fit;
+    int32_t box_h = img_info.height >> fit;
+    int reduced = fit + decode_extra_scale;
+    jpeg_cfg.out_scale = reduced > JPEG_IMAGE_SCALE_1_8 ? JPEG_IMAGE_SCALE_1_8
+                                                        : (esp_jpeg_image_scale_t)reduced;
+
+    size_t max_out_size;
+    jpeg_cfg.outbuf = media_pool_decode_buffer(jpeg_cfg.out_scale, &max_out_size);
+    jpeg_cfg.outbuf_size = max_out_size;
+    if (!jpeg_cfg.outbuf) {
+        return false;
+    }
 
+    // El buffer de decodificación puede ser aún el origen de la copia anterior
+    st77xx_async_wait(portMAX_DELAY);
+    int64_t t0 = st77xx_stats_begin();
+    esp_err_t ret = esp_jpeg_decode(&jpeg_cfg, &img_info);
+    st77xx_stats_end(ST77XX_STAGE_DECODE, t0);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error decodificando: %s", esp_err_to_name(ret));
-        free(decode_buf);
         return false;
     }
+    media_pool_note_decode(img_info.output_len);
 
-    ESP_LOGI(TAG, "JPG: %dx%d", img_info.width, img_info.height);
+    // Una sola tarea decodifica a la vez: el escalador puede ser estático
+    static st77xx_scaler_t scaler;
+    if (!st77xx_scaler_init(&scaler, (const uint16_t*)jpeg_cfg.outbuf, img_info.width, img_info.height,
+                            img_info.width, (ST77XX_WIDTH - box_w) / 2, (ST77XX_HEIGHT - box_h) / 2,
+                            box_w, box_h, ST77XX_FIT_STRETCH, ST77XX_FILTER_NEAREST, 0x0000)) {
+        return false;
+    }
+    if (box_w < ST77XX_WIDTH || box_h < ST77XX_HEIGHT) {
+        memset(frame, 0, ST77XX_FB_SIZE);
+    }
+    st77xx_blit_scaled(frame, &scaler);
+    return true;
+}
 
-    // Framebuffer en PSRAM
-    uint16_t* frame_buffer = heap_caps_malloc(
-        (size_t)ST77XX_WIDTH * ST77XX_HEIGHT * sizeof(uint16_t),
-        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT
-    );
-    if (!frame_buffer) {
-        // Mostrar directo si no hay más memoria
-        st77xx_flush((uint16_t*)decode_buf);
-        free(decode_buf);
-        return true;
+/**
+ * @brief Decodifica un JPG centrado en un framebuffer de pantalla completa
+ * 
+ * Los bloques MCU se escriben directamente en su posición dentro de @p frame
+ * y solo se borran las bandas negras. Si el decodificador de ROM no está
+ * disponible, decodifica a un buffer intermedio y copia la imagen centrada
+ * por DMA; la copia puede seguir en curso al volver (st77xx_async_wait()
+ * antes de enviar el frame).
+ * Con decode_extra_scale usa decode_jpg_reduced_to_frame().
+ * 
+ * @param jpg_buf Datos JPG
+ * @param file_size Tamaño en bytes
+ * @param frame Framebuffer de ST77XX_WIDTH x ST77XX_HEIGHT
+ * @param panel_order true para el orden de bytes del panel (st77xx_flush_raw()),
+ *                    false para RGB565 nativo (st77xx_swap_and_display())
+ * @return true si éxito, false en caso de error
+ */
+static bool decode_jpg_data_to_frame(const uint8_t* jpg_buf, size_t file_size,
+                                     uint16_t* frame, bool panel_order)
+{
+    if (decode_extra_scale) {
+        return decode_jpg_reduced_to_frame(jpg_buf, file_size, frame, panel_order);
+    }
+
+    esp_err_t ret = jpeg_stream_decode_centered(jpg_buf, file_size, frame,
+                                                ST77XX_WIDTH, ST77XX_HEIGHT, panel_order);
+    if (ret != ESP_ERR_NOT_SUPPORTED) {
+        return ret == ESP_OK;
+    }
+
+    size_t max_out_size;
+    uint8_t* decode_buf = media_pool_decode_buffer(JPEG_IMAGE_SCALE_0, &max_out_size);
+    if (!decode_buf) {
+        return false;
     }
 
-    memset(frame_buffer, 0, (size_t)ST77XX_WIDTH * ST77XX_HEIGHT * sizeof(uint16_t));
+    esp_jpeg_image_output_t img_info;
+    esp_jpeg_image_cfg_t jpeg_cfg = {
+        .indata = (uint8_t*)jpg_buf,
+        .indata_size = file_size,
+        .outbuf = decode_buf,
+        .outbuf_size = max_out_size,
+        .out_format = JPEG_IMAGE_FORMAT_RGB565,
+        .out_scale = JPEG_IMAGE_SCALE_0,
+        .flags = { .swap_color_bytes = panel_order },
+        .advanced = {
+            .working_buffer = media_pool_work_buffer(),
+            .working_buffer_size = MEDIA_POOL_WORK_SIZE,
+        },
+    };
+
+    // El buffer de decodificación puede ser aún el origen de la copia anterior
+    st77xx_async_wait(portMAX_DELAY);
+    int64_t t0 = st77xx_stats_begin();
+    ret = esp_jpeg_decode(&jpeg_cfg, &img_info);
+    st77xx_stats_end(ST77XX_STAGE_DECODE, t0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error decodificando: %s", esp_err_to_name(ret));
+        return false;
+    }
+    media_pool_note_decode(img_info.output_len);
 
     uint16_t* src = (uint16_t*)decode_buf;
     int img_w = img_info.width;
@@ -285,19 +455,164 @@ static bool load_and_display_jpg_psram(const char* path)
     if (offset_x + copy_w > ST77XX_WIDTH) copy_w = ST77XX_WIDTH - offset_x;
     if (offset_y + copy_h > ST77XX_HEIGHT) copy_h = ST77XX_HEIGHT - offset_y;
 
-    for (int y = 0; y < copy_h; y++) {
-        uint16_t* dst_row = &frame_buffer[(offset_y + y) * ST77XX_WIDTH + offset_x];
-        uint16_t* src_row = &src[(src_start_y + y) * img_w + src_start_x];
-        memcpy(dst_row, src_row, copy_w * sizeof(uint16_t));
+    // Solo las bandas negras, por CPU y antes de que el DMA toque el frame
+    t0 = st77xx_stats_begin();
+    int bottom = offset_y + copy_h;
+    st77xx_kernel_fill_rect(frame, ST77XX_WIDTH, ST77XX_WIDTH, offset_y, 0x0000);
+    st77xx_kernel_fill_rect(&frame[bottom * ST77XX_WIDTH], ST77XX_WIDTH,
+                            ST77XX_WIDTH, ST77XX_HEIGHT - bottom, 0x0000);
+    st77xx_kernel_fill_rect(&frame[offset_y * ST77XX_WIDTH], ST77XX_WIDTH,
+                            offset_x, copy_h, 0x0000);
+    st77xx_kernel_fill_rect(&frame[offset_y * ST77XX_WIDTH + offset_x + copy_w], ST77XX_WIDTH,
+                            ST77XX_WIDTH - offset_x - copy_w, copy_h, 0x0000);
+
+    // La copia sigue por DMA al volver: quien envía el frame la espera con
+    // st77xx_async_wait() y mientras tanto ya se puede cargar el siguiente
+    esp_err_t copy_ret = st77xx_async_blit(&frame[offset_y * ST77XX_WIDTH + offset_x], ST77XX_WIDTH,
+                                           &src[src_start_y * img_w + src_start_x], img_w,
+                                           copy_w, copy_h, NULL, NULL);
+    st77xx_stats_end(ST77XX_STAGE_SCALE, t0);
+    return copy_ret == ESP_OK;
+}
+
+/**
+ * @brief Carga un JPG de SPIFFS y lo decodifica con decode_jpg_data_to_frame()
+ */
+static bool decode_jpg_to_frame(const char* path, uint16_t* frame, bool panel_order)
+{
+    size_t file_size;
+    uint8_t* jpg_buf = media_pool_load(path, &file_size);
+    if (!jpg_buf) {
+        return false;
     }
+    return decode_jpg_data_to_frame(jpg_buf, file_size, frame, panel_order);
+}
 
-    free(decode_buf);
-    st77xx_flush(frame_buffer);
-    free(frame_buffer);
-    
+/**
+ * @brief Frame decodificado desde la caché, o decodificado e insertado en ella
+ * 
+ * @param name Clave del asset (ruta en SPIFFS o "anim/N")
+ * @param jpg Datos JPG, o NULL para cargarlos de @p name solo si hace falta
+ * @param size Tamaño de @p jpg
+ * @param fallback Framebuffer donde decodificar si el frame no cabe en caché
+ * @return Píxeles en orden del panel, o NULL si falla. Si vienen de la caché
+ *         están fijados: liberar con st77xx_cache_release() tras enviarlos
+ *
+ * Con una reducción extra activa (decode_extra_scale) el frame
+ * se decodifica en @p fallback: la caché solo guarda frames completos.
+ */
+static const uint16_t* decode_cached(const char* name, const uint8_t* jpg, size_t size,
+                                     uint16_t* fallback)
+{
+    uint32_t key = st77xx_cache_key(name);
+    const uint16_t* hit = st77xx_cache_get(key, NULL);
+    if (hit) {
+        return hit;
+    }
+
+    uint16_t* slot = decode_extra_scale ? NULL : st77xx_cache_insert(key, ST77XX_FB_SIZE);
+    uint16_t* dst = slot ? slot : fallback;
+    if (!dst) {
+        return NULL;
+    }
+
+    bool ok = jpg ? decode_jpg_data_to_frame(jpg, size, dst, true)
+                  : decode_jpg_to_frame(name, dst, true);
+    if (!ok && slot) {
+        st77xx_cache_release(slot);
+        st77xx_cache_remove(key);
+    }
+    return ok ? dst : NULL;
+}
+
+/**
+ * @brief Decodifica y muestra imagen JPG usando PSRAM
+ * 
+ * Permite decodificación a resolución completa sin escalado.
+ * Requiere ESP32-S3 con PSRAM habilitada. Si hay double buffers
+ * (st77xx_init_double_buffers()) decodifica en el back buffer y presenta
+ * con st77xx_swap_and_display(); si no, usa el framebuffer del pool.
+ * 
+ * @param path Ruta al archivo JPG en SPIFFS
+ * @return true si éxito, false en caso de error
+ */
+static bool load_and_display_jpg_psram(const char* path)
+{
+    uint16_t* draw_buffer = st77xx_get_draw_buffer();
+    if (draw_buffer) {
+        bool ok = decode_jpg_to_frame(path, draw_buffer, false);
+        if (ok) {
+            st77xx_async_wait(portMAX_DELAY);
+            st77xx_swap_and_display();
+        }
+        return ok;
+    }
+
+    const uint16_t* pixels = decode_cached(path, NULL, 0, media_pool_frame());
+    if (!pixels) {
+        return false;
+    }
+    st77xx_async_wait(portMAX_DELAY);
+    st77xx_flush_raw(pixels);
+    st77xx_cache_release(pixels);
     ESP_LOGI(TAG, "JPG mostrado: %s", path);
     return true;
 }
+
+/**
+ * @brief Callback del pipeline: decodifica el frame @p index de la animación
+ * 
+ * @p ctx es el contenedor ST7A abierto, o NULL para leer los JPG de SPIFFS.
+ */
+static bool decode_animation_frame(int index, frame_pipeline_frame_t* frame, void* ctx)
+{
+    const anim_t* anim = (const anim_t*)ctx;
+    char name[32];
+    decode_extra_scale = frame->slot.scale;
+    if (!anim) {
+        if (index >= spiffs_frame_count) {
+            return false;
+        }
+        frame->pixels = decode_cached(spiffs_frames[index].path, NULL, 0, frame->buffer);
+        return frame->pixels != NULL;
+    }
+
+    anim_frame_t f;
+    if (!anim_get_frame(anim, index, &f)) {
+        return false;
+    }
+
+    if (anim->header->format == ST7A_FORMAT_RGB565_BE) {
+        // Ya en orden del panel: se envía directo desde la flash mapeada
+        frame->pixels = (const uint16_t*)f.data;
+        return true;
+    }
+    snprintf(name, sizeof(name), "anim/%d", index);
+    frame->pixels = decode_cached(name, f.data, f.size, frame->buffer);
+    return frame->pixels != NULL;
+}
+
+/**
+ * @brief Callback del pipeline: devuelve a la caché un frame ya enviado
+ */
+static void release_animation_frame(const uint16_t* pixels, void* ctx)
+{
+    (void)ctx;
+    st77xx_cache_release(pixels);  // Ignora punteros que no son de la caché
+}
+
+/**
+ * @brief Hook de mem_monitor: uso y aciertos de la caché de frames
+ */
+static void report_frame_cache(void* ctx)
+{
+    (void)ctx;
+    st77xx_cache_stats_t cs;
+    st77xx_cache_get_stats(&cs);
+    ESP_LOGI(TAG, "Caché frames: %d entradas, %u/%u bytes | hits %lu misses %lu evict %lu",
+             cs.entries, (unsigned)cs.bytes_used, (unsigned)cs.budget,
+             (unsigned long)cs.hits, (unsigned long)cs.misses, (unsigned long)cs.evictions);
+}
 #endif
 
 /**
@@ -315,14 +630,110 @@ static bool load_and_display_jpg(const char* path)
 }
 
 /**
- * @brief Número total de frames en la animación
+ * @brief Partición raw con el contenedor ST7A
+ */
+#define ANIM_PARTITION_LABEL "anim"
+
+/**
+ * @brief Partición raw con el splash de arranque (ST7A RGB565 de un frame)
+ */
+#define SPLASH_PARTITION_LABEL "splash"
+
+/**
+ * @brief Mapea el splash si existe y coincide con la pantalla
+ * @param[out] splash Contenedor abierto; cerrar tras st77xx_init_wait()
+ * @return Píxeles en orden del panel dentro de la flash mapeada, o NULL
+ */
+static const uint16_t* splash_open(anim_t* splash)
+{
+    anim_frame_t f;
+    if (anim_open(SPLASH_PARTITION_LABEL, splash) != ESP_OK) {
+        return NULL;
+    }
+    const st7a_header_t* h = splash->header;
+    if (h->format != ST7A_FORMAT_RGB565_BE || h->width != ST77XX_WIDTH ||
+        h->height != ST77XX_HEIGHT || !anim_get_frame(splash, 0, &f) ||
+        f.size != ST77XX_FB_SIZE) {
+        ESP_LOGW(TAG, "Splash incompatible con la pantalla");
+        anim_close(splash);
+        return NULL;
+    }
+    return (const uint16_t*)f.data;
+}
+
+/**
+ * @brief Comprueba que el contenedor se puede reproducir en esta pantalla
+ */
+static bool anim_playable(const anim_t* anim)
+{
+    const st7a_header_t* h = anim->header;
+    if (h->format == ST7A_FORMAT_JPEG) {
+        return true;
+    }
+    if (h->width != ST77XX_WIDTH || h->height != ST77XX_HEIGHT) {
+        return false;
+    }
+    if (h->format == ST7A_FORMAT_SPAN565) {
+        return true;
+    }
+    if (h->format != ST7A_FORMAT_RGB565_BE) {
+        return false;
+    }
+    for (int i = 0; i < h->frame_count; i++) {
+        if (anim->index[i].size != ST77XX_FB_SIZE) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Muestra el frame @p index del contenedor ST7A
+ * @param anim Contenedor abierto
+ * @param index Frame
+ * @return true si éxito
  */
-#define FRAME_COUNT 14
+static bool display_anim_frame(const anim_t* anim, int index)
+{
+    anim_frame_t f;
+    if (!anim_get_frame(anim, index, &f)) {
+        return false;
+    }
+
+    if (anim->header->format == ST7A_FORMAT_RGB565_BE) {
+        st77xx_flush_raw((const uint16_t*)f.data);
+        return true;
+    }
+    if (anim->header->format == ST7A_FORMAT_SPAN565) {
+        // Solo los rectángulos que cambian, directo desde flash
+        return anim_play_span_frame(&f, ST77XX_WIDTH, ST77XX_HEIGHT) >= 0;
+    }
+
+#if ST77XX_USE_PSRAM
+    char name[32];
+    snprintf(name, sizeof(name), "anim/%d", index);
+    const uint16_t* pixels = decode_cached(name, f.data, f.size, media_pool_frame());
+    if (!pixels) {
+        return false;
+    }
+    st77xx_async_wait(portMAX_DELAY);
+    st77xx_flush_raw(pixels);
+    st77xx_cache_release(pixels);
+    return true;
+#else
+    return display_jpg_stripe(f.data, f.size);
+#endif
+}
 
+#if ST77XX_USE_STATS
 /**
- * @brief Delay entre frames en milisegundos (0.06s = 60ms)
+ * @brief Hook de mem_monitor: tiempos por etapa y ritmo desde el informe anterior
  */
-#define FRAME_DELAY_MS 1
+static void report_frame_timing(void* ctx)
+{
+    (void)ctx;
+    st77xx_stats_log();
+    st77xx_stats_reset();
+}
+#endif
 
 /**
  * @brief Punto de entrada de la aplicación
@@ -331,29 +742,120 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "Heap libre inicial: %lu bytes", (unsigned long)esp_get_free_heap_size());
     
+    // Init del panel en segundo plano: sus esperas se solapan con el montaje
+    // de SPIFFS y la carga de recursos. El splash sale de la flash mapeada.
+    static anim_t splash;
+    const uint16_t* splash_pixels = splash_open(&splash);
+    bool init_async = st77xx_init_async(splash_pixels) == ESP_OK;
+    if (!init_async) {
+        st77xx_init();
+    }
+    
     st77xx_mount_spiffs();
-    st77xx_init();
-    st77xx_backlight(77);
     mem_monitor_start();
+#if ST77XX_USE_STATS
+    mem_monitor_add_hook(report_frame_timing, NULL);
+#endif
+    
+    // Contenedor empaquetado en flash; si no está, los JPG sueltos de SPIFFS
+    static anim_t anim;
+    bool use_anim = anim_open(ANIM_PARTITION_LABEL, &anim) == ESP_OK;
+    if (use_anim && !anim_playable(&anim)) {
+        ESP_LOGW(TAG, "Contenedor ST7A incompatible con la pantalla");
+        anim_close(&anim);
+        use_anim = false;
+    }
+    if (use_anim && anim.header->format == ST7A_FORMAT_JPEG) {
+        // La cabecera guarda el mayor tamaño de sus frames
+        media_pool_set_image_size(anim.header->width, anim.header->height);
+    }
+    if (!use_anim) {
+        list_spiffs_files(SPIFFS_DIR);
+        spiffs_frame_count = spiffs_scan_frames(SPIFFS_DIR);
+        
+        // Buffers de archivo/decodificación dimensionados una sola vez
+        if (media_pool_init(SPIFFS_DIR) != ESP_OK) {
+            ESP_LOGE(TAG, "Pool de medios no disponible");
+        }
+    }
+    
+    if (init_async) {
+        st77xx_init_wait(UINT32_MAX);
+    }
+    if (splash_pixels) {
+        anim_close(&splash);
+    }
+    st77xx_backlight(77);
+    
+#if !ST77XX_USE_PSRAM
+    // Anillo de franjas persistente: no se reasigna en cada frame
+    st77xx_init_stripe_mode();
+#endif
     
     ESP_LOGI(TAG, "Heap libre después init: %lu bytes", (unsigned long)esp_get_free_heap_size());
     ESP_LOGI(TAG, "Display: %s %dx%d, PSRAM: %s", 
              ST77XX_CONTROLLER_NAME, ST77XX_WIDTH, ST77XX_HEIGHT,
              ST77XX_USE_PSRAM ? "SI" : "NO");
     
-    list_spiffs_files("/spiffs");
+    int frame_count = use_anim ? anim_frame_count(&anim) : spiffs_frame_count;
+    if (frame_count == 0) {
+        ESP_LOGE(TAG, "No hay frames que reproducir en %s", SPIFFS_DIR);
+        return;
+    }
+    ESP_LOGI(TAG, "Reproduciendo video (%d frames, %s)...", frame_count,
+             use_anim ? "ST7A" : "SPIFFS");
+    
+    // Los deltas dependen del frame anterior: nunca se saltan
+    bool span = use_anim && anim.header->format == ST7A_FORMAT_SPAN565;
+    
+#if ST77XX_USE_PSRAM
+    mem_monitor_add_hook(report_frame_cache, NULL);
+    
+    // Decodificación y envío solapados en cores distintos. Los deltas SPAN565
+    // no se decodifican a framebuffer: se reproducen en secuencia.
+    frame_pipeline_config_t pipe_cfg = {
+        .decode = decode_animation_frame,
+        .release = release_animation_frame,
+        .delay = animation_frame_delay,
+        .ctx = use_anim ? &anim : NULL,
+        .frame_count = frame_count,
+        .frame_delay_ms = FRAME_DELAY_MS
+    };
+    if (!span && frame_pipeline_start(&pipe_cfg) == ESP_OK) {
+        return;
+    }
+    if (!span) {
+        ESP_LOGW(TAG, "Pipeline no disponible, reproducción secuencial");
+    }
+#endif
+    
+    // Cada frame en su intervalo de la línea de tiempo; con retraso se
+    // salta o se reduce según CONFIG_FRAME_SCHED_LATE_POLICY
+    frame_sched_start();
+    frame_sched_slot_t slot;
     
-    ESP_LOGI(TAG, "Reproduciendo video (%d frames @ %dms)...", FRAME_COUNT, FRAME_DELAY_MS);
+    if (use_anim) {
+        int i = 0;
+        while (1) {
+            frame_sched_plan(animation_frame_delay(i, &anim), !span, &slot);
+            if (!slot.skip && frame_sched_present(&slot)) {
+                decode_extra_scale = slot.scale;
+                display_anim_frame(&anim, i);
+                frame_sched_presented(&slot);
+            }
+            i = anim_next_index(&anim, i);
+        }
+    }
     
-    char path[64];
     while (1) {
-        for (int i = 0; i < FRAME_COUNT; i++) {
-            snprintf(path, sizeof(path), "/spiffs/frame_%02d_delay-0.15s.jpg", i);
-            load_and_display_jpg(path);
-            vTaskDelay(pdMS_TO_TICKS(FRAME_DELAY_MS));
+        for (int i = 0; i < frame_count; i++) {
+            frame_sched_plan(animation_frame_delay(i, NULL), true, &slot);
+            if (slot.skip || !frame_sched_present(&slot)) {
+                continue;
+            }
+            decode_extra_scale = slot.scale;
+            load_and_display_jpg(spiffs_frames[i].path);
+            frame_sched_presented(&slot);
         }
     }
 }
-
-
-
@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""Empaqueta los frames de una animación en un contenedor ST7A.
+
+Uso:
+    st7a_pack.py spiffs_image -o build/anim.st7a
+    st7a_pack.py spiffs_image -o anim.st7a --format rgb565 --size 480x320
+
+Los frames se toman de los archivos ``frame_NN_delay-S.Ss.jpg`` del
+directorio, ordenados por NN; el delay sale del nombre (o de --delay).
+Con --format rgb565 los JPG se convierten a RGB565 big-endian del tamaño
+de la pantalla (requiere Pillow) para enviarlos sin decodificar.
+
+Con --frames N solo se empaquetan los N primeros; el splash de arranque
+es un contenedor rgb565 de un frame (--format rgb565 --frames 1).
+
+Con --format span cada frame guarda solo los rectángulos que cambian
+respecto al anterior (el primero y cada --keyint frames, respecto a negro),
+y se añade un delta final del último frame al primero para el bucle. El
+coste de abrir una ventana (--window-cost, en píxeles) decide cuándo se
+unen dos zonas cercanas, igual que ST77XX_WINDOW_COST_PX en el driver.
+
+El formato está descrito en main/anim_player.h.
+"""
+
+import argparse
+import re
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = b"ST7A"
+VERSION = 1
+ALIGN = 4
+
+FORMAT_JPEG = 0
+FORMAT_RGB565_BE = 1
+FORMAT_SPAN565 = 2
+
+FRAME_KEY = 0x01
+FRAME_DELTA = 0x02
+FRAME_LOOP = 0x04
+
+SPAN_LITERAL = 0
+SPAN_FILL = 1
+
+HEADER = struct.Struct("<4sHHHHBBHII")   # st7a_header_t, 24 bytes
+ENTRY = struct.Struct("<IIHBB")          # st7a_frame_t, 12 bytes
+SPAN_FRAME = struct.Struct("<HH")        # st7a_span_frame_t
+SPAN_RECT = struct.Struct("<HHHHH")      # st7a_span_rect_t
+
+FRAME_RE = re.compile(r"frame_(\d+)(?:_delay-([0-9.]+)s)?\.jpe?g$", re.IGNORECASE)
+
+
+def jpeg_size(data):
+    """Devuelve (ancho, alto) leyendo el marcador SOF del JPG."""
+    pos = 2
+    while pos + 4 <= len(data):
+        if data[pos] != 0xFF:
+            raise ValueError("marcador JPEG inválido")
+        marker = data[pos + 1]
+        length = struct.unpack(">H", data[pos + 2:pos + 4])[0]
+        if marker in (0xC0, 0xC1, 0xC2):
+            height, width = struct.unpack(">HH", data[pos + 5:pos + 9])
+            return width, height
+        pos += 2 + length
+    raise ValueError("JPEG sin SOF")
+
+
+def to_rgb565_be(path, size):
+    from PIL import Image
+
+    img = Image.open(path).convert("RGB")
+    canvas = Image.new("RGB", size)
+    canvas.paste(img, ((size[0] - img.width) // 2, (size[1] - img.height) // 2))
+    out = bytearray()
+    for r, g, b in canvas.getdata():
+        out += struct.pack(">H", ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3))
+    return bytes(out)
+
+
+def collect_frames(src, default_delay_ms):
+    frames = []
+    for path in Path(src).iterdir():
+        m = FRAME_RE.match(path.name)
+        if not m:
+            continue
+        delay_ms = default_delay_ms
+        if m.group(2) is not None:
+            delay_ms = round(float(m.group(2)) * 1000)
+        frames.append((int(m.group(1)), path, delay_ms))
+    frames.sort()
+    return [(path, delay) for _, path, delay in frames]
+
+
+def changed_columns(prev, cur, width, y0, y1):
+    """Columnas con algún píxel distinto en las filas [y0, y1)."""
+    stride = width * 2
+    cols = bytearray(width)
+    for y in range(y0, y1):
+        a = prev[y * stride:(y + 1) * stride]
+        b = cur[y * stride:(y + 1) * stride]
+        if a == b:
+            continue
+        for x in range(width):
+            if a[2 * x:2 * x + 2] != b[2 * x:2 * x + 2]:
+                cols[x] = 1
+    return cols
+
+
+def diff_rects(prev, cur, size, band, window_cost):
+    """Rectángulos (x, y, w, h) que cubren los píxeles distintos."""
+    width, height = size
+    stride = width * 2
+    rects = []
+    for by in range(0, height, band):
+        y_end = min(by + band, height)
+        cols = changed_columns(prev, cur, width, by, y_end)
+
+        # Tramos de columnas; un hueco más barato que una ventana se une
+        spans = []
+        x = 0
+        while x < width:
+            if not cols[x]:
+                x += 1
+                continue
+            x0 = x
+            while x < width and cols[x]:
+                x += 1
+            if spans and (x0 - spans[-1][1]) * (y_end - by) <= window_cost:
+                spans[-1][1] = x
+            else:
+                spans.append([x0, x])
+
+        for x0, x1 in spans:
+            rows = [y for y in range(by, y_end)
+                    if prev[y * stride + 2 * x0:y * stride + 2 * x1]
+                    != cur[y * stride + 2 * x0:y * stride + 2 * x1]]
+            y0, y1 = rows[0], rows[-1] + 1
+            # Continuación exacta del rectángulo de la banda anterior
+            last = rects[-1] if rects else None
+            if last and last[0] == x0 and last[2] == x1 - x0 and last[1] + last[3] == y0:
+                rects[-1] = (x0, last[1], x1 - x0, y1 - last[1])
+            else:
+                rects.append((x0, y0, x1 - x0, y1 - y0))
+    return rects
+
+
+def encode_span_frame(prev, cur, size, band, window_cost):
+    width = size[0]
+    stride = width * 2
+    rects = diff_rects(prev, cur, size, band, window_cost)
+    out = bytearray(SPAN_FRAME.pack(len(rects), 0))
+    for x, y, w, h in rects:
+        pixels = b"".join(cur[(y + r) * stride + 2 * x:(y + r) * stride + 2 * (x + w)]
+                          for r in range(h))
+        first = pixels[:2]
+        if pixels == first * (w * h):
+            # Color liso: un solo píxel, en RGB565 nativo
+            color = struct.unpack(">H", first)[0]
+            out += SPAN_RECT.pack(x, y, w, h, SPAN_FILL) + struct.pack("<H", color)
+        else:
+            out += SPAN_RECT.pack(x, y, w, h, SPAN_LITERAL) + pixels
+    return bytes(out)
+
+
+def encode_span(images, size, keyint, band, window_cost):
+    """images: lista de (rgb565 big-endian, delay_ms). Devuelve payloads."""
+    black = bytes(size[0] * size[1] * 2)
+    payloads = []
+    prev = None
+    for i, (img, delay_ms) in enumerate(images):
+        key = prev is None or (keyint and i % keyint == 0)
+        base = black if key else prev
+        flags = FRAME_KEY if key else FRAME_DELTA
+        payloads.append((encode_span_frame(base, img, size, band, window_cost), delay_ms, flags))
+        prev = img
+
+    if len(images) > 1:
+        loop = encode_span_frame(images[-1][0], images[0][0], size, band, window_cost)
+        payloads.append((loop, images[0][1], FRAME_DELTA | FRAME_LOOP))
+    return payloads
+
+
+def container(payloads, fmt, width, height):
+    index_offset = HEADER.size
+    offset = index_offset + ENTRY.size * len(payloads)
+    entries = []
+    body = bytearray()
+    for data, delay_ms, flags in payloads:
+        pad = -offset % ALIGN
+        body += b"\0" * pad
+        offset += pad
+        entries.append(ENTRY.pack(offset, len(data), min(delay_ms, 0xFFFF), flags, 0))
+        body += data
+        offset += len(data)
+
+    header = HEADER.pack(MAGIC, VERSION, HEADER.size, width, height, fmt, 0,
+                         len(payloads), index_offset, offset)
+    return header + b"".join(entries) + bytes(body)
+
+
+def pack(frames, fmt, size, keyint=0, band=8, window_cost=512):
+    if fmt == FORMAT_JPEG:
+        payloads = []
+        width = height = 0
+        for path, delay_ms in frames:
+            data = path.read_bytes()
+            w, h = jpeg_size(data)
+            width, height = max(width, w), max(height, h)
+            payloads.append((data, delay_ms, FRAME_KEY))
+        return container(payloads, fmt, width, height)
+
+    images = [(to_rgb565_be(path, size), delay_ms) for path, delay_ms in frames]
+    if fmt == FORMAT_RGB565_BE:
+        payloads = [(img, delay_ms, FRAME_KEY) for img, delay_ms in images]
+    else:
+        payloads = encode_span(images, size, keyint, band, window_cost)
+    return container(payloads, fmt, size[0], size[1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("src", help="directorio con frame_NN_delay-S.Ss.jpg")
+    parser.add_argument("-o", "--output", required=True, help="archivo .st7a de salida")
+    parser.add_argument("--format", choices=("jpeg", "rgb565", "span"), default="jpeg")
+    parser.add_argument("--size", default="480x320", help="pantalla para rgb565 (ANCHOxALTO)")
+    parser.add_argument("--delay", type=int, default=150, help="delay por defecto en ms")
+    parser.add_argument("--frames", type=int, default=0,
+                        help="empaqueta solo los N primeros frames (0 = todos)")
+    parser.add_argument("--keyint", type=int, default=0,
+                        help="span: keyframe cada N frames (0 = solo el primero)")
+    parser.add_argument("--band", type=int, default=8, help="span: filas por banda")
+    parser.add_argument("--window-cost", type=int, default=512,
+                        help="span: coste de una ventana en píxeles")
+    parser.add_argument("--max-size", type=lambda v: int(v, 0), default=0,
+                        help="falla si el contenedor supera este tamaño (partición)")
+    args = parser.parse_args()
+
+    frames = collect_frames(args.src, args.delay)
+    if args.frames > 0:
+        frames = frames[:args.frames]
+    if not frames:
+        sys.exit(f"st7a_pack: no hay frames en {args.src}")
+
+    fmt = {"jpeg": FORMAT_JPEG, "rgb565": FORMAT_RGB565_BE, "span": FORMAT_SPAN565}[args.format]
+    size = tuple(int(v) for v in args.size.lower().split("x"))
+    blob = pack(frames, fmt, size, args.keyint, args.band, args.window_cost)
+
+    if args.max_size and len(blob) > args.max_size:
+        sys.exit(f"st7a_pack: {len(blob)} bytes no caben en {args.max_size}")
+
+    Path(args.output).parent.mkdir(parents=True, exist_ok=True)
+    Path(args.output).write_bytes(blob)
+    print(f"st7a_pack: {len(frames)} frames, {len(blob)} bytes -> {args.output}")
+
+
+if __name__ == "__main__":
+    main()
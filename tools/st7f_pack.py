@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Rasteriza un TTF en una fuente antialias ST7F.
+
+Uso:
+    st7f_pack.py fuente.ttf --size 48 -o build/font.st7f
+    st7f_pack.py fuente.ttf --size 64 --bpp 2 --chars "0123456789:.-" -o digits.st7f
+
+Cada glifo se guarda recortado a su caja, con su avance y desplazamientos,
+y con 2 o 4 bits de alfa por píxel. Por defecto se incluyen ASCII
+imprimible y los caracteres extra de la fuente 8x12 del driver
+(¡¿Ñáéíñóúü). Requiere Pillow.
+
+El formato está descrito en components/st77xx/include/st77xx_font.h.
+"""
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = b"ST7F"
+VERSION = 1
+
+HEADER = struct.Struct("<4sHHBBHHHIII")  # st7f_header_t, 28 bytes
+GLYPH = struct.Struct("<IIBBBBhh")       # st7f_glyph_t, 16 bytes
+
+DEFAULT_CHARS = "".join(chr(c) for c in range(32, 127)) + "¡¿Ñáéíñóúü"
+
+
+def rasterize(ttf, size, chars):
+    """Devuelve (glifos, alto de línea, ascent).
+
+    Cada glifo es (codepoint, ancho, alto, x_offset, y_offset, avance, alfa)
+    con el alfa como bytes 0..255 fila a fila.
+    """
+    from PIL import Image, ImageDraw, ImageFont
+
+    font = ImageFont.truetype(str(ttf), size)
+    ascent, descent = font.getmetrics()
+    glyphs = []
+    for ch in sorted(set(chars)):
+        # Caja relativa a la parte superior de la línea (ancla "la")
+        x0, y0, x1, y1 = font.getbbox(ch, anchor="la")
+        advance = round(font.getlength(ch))
+        w, h = max(0, x1 - x0), max(0, y1 - y0)
+        alpha = b""
+        if w and h:
+            img = Image.new("L", (w, h), 0)
+            ImageDraw.Draw(img).text((-x0, -y0), ch, font=font, fill=255, anchor="la")
+            alpha = img.tobytes()
+        glyphs.append((ord(ch), w, h, x0, y0, advance, alpha))
+    return glyphs, ascent + descent, ascent
+
+
+def quantize(alpha, w, h, bpp):
+    """Empaqueta el alfa 0..255 a bpp bits, filas alineadas a byte."""
+    levels = (1 << bpp) - 1
+    per_byte = 8 // bpp
+    out = bytearray()
+    for y in range(h):
+        row = alpha[y * w:(y + 1) * w]
+        for x0 in range(0, w, per_byte):
+            byte = 0
+            for i, a in enumerate(row[x0:x0 + per_byte]):
+                byte |= ((a * levels + 127) // 255) << (8 - bpp * (i + 1))
+            out.append(byte)
+    return bytes(out)
+
+
+def pack(glyphs, bpp, line_height, ascent):
+    glyphs = sorted(glyphs)
+    glyph_offset = HEADER.size
+    bitmap_offset = glyph_offset + GLYPH.size * len(glyphs)
+
+    table = bytearray()
+    bitmaps = bytearray()
+    for cp, w, h, x_off, y_off, advance, alpha in glyphs:
+        if w > 255 or h > 255 or advance > 255:
+            raise ValueError(f"glifo U+{cp:04X} demasiado grande ({w}x{h}, avance {advance})")
+        table += GLYPH.pack(cp, len(bitmaps), w, h, advance, 0, x_off, y_off)
+        bitmaps += quantize(alpha, w, h, bpp)
+
+    total = bitmap_offset + len(bitmaps)
+    header = HEADER.pack(MAGIC, VERSION, HEADER.size, bpp, 0, len(glyphs),
+                         line_height, ascent, glyph_offset, bitmap_offset, total)
+    return header + table + bitmaps
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("ttf", help="fuente TrueType/OpenType")
+    parser.add_argument("-o", "--output", required=True, help="archivo .st7f de salida")
+    parser.add_argument("--size", type=int, default=32, help="tamaño en píxeles")
+    parser.add_argument("--bpp", type=int, choices=(2, 4), default=4, help="bits de alfa por píxel")
+    parser.add_argument("--chars", default=DEFAULT_CHARS, help="caracteres a incluir")
+    parser.add_argument("--max-size", type=lambda v: int(v, 0), default=0,
+                        help="falla si la fuente supera este tamaño (partición)")
+    args = parser.parse_args()
+
+    glyphs, line_height, ascent = rasterize(args.ttf, args.size, args.chars)
+    blob = pack(glyphs, args.bpp, line_height, ascent)
+
+    if args.max_size and len(blob) > args.max_size:
+        sys.exit(f"st7f_pack: {len(blob)} bytes no caben en {args.max_size}")
+
+    Path(args.output).parent.mkdir(parents=True, exist_ok=True)
+    Path(args.output).write_bytes(blob)
+    print(f"st7f_pack: {len(glyphs)} glifos, {len(blob)} bytes -> {args.output}")
+
+
+if __name__ == "__main__":
+    main()